@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// Steps the same falling bodies under gravity and friction with symplectic Euler twice, once as separately allocated
+// objects laid out the way objects were before the body store, and once streaming through the arrays of a body store.
+// Bytes are what a step touches for all the bodies, a whole object and the pointer to it against the hot arrays. Times
+// are the average milliseconds per step
+struct BodyStoreBenchmark
+{
+	int bodyCount;
+	size_t objectBytes;
+	size_t storeBytes;
+	float objectTime;
+	float storeTime;
+	bool matches;		// Whether both ended with exactly the same positions and velocities
+};
+BodyStoreBenchmark benchmarkBodyStore(int bodyCount, int steps);
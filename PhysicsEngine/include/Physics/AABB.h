@@ -2,20 +2,23 @@
 #include "Object.h"
 namespace Physics
 {
-	class AABB : public Object
+	template <typename Real>
+	class BasicAABB : public BasicObject<Real>
 	{
 	public:
-		AABB(vec3 position, vec3 halfExtent, float mass, vec4 color, bool isStatic);
-		~AABB();
-		void draw();
+		typedef typename BasicObject<Real>::Vector Vector;
+		typedef typename BasicObject<Real>::BodyStore BodyStore;
+
+		BasicAABB(Vector position, Vector halfExtent, Real mass, vec4 color, bool isStatic, BodyStore * bodies = nullptr);
+		~BasicAABB();
+		void draw(float alpha);
 
 		// Getter
-		inline const vec3 & getExtents() const { return m_extents; }
-		vec3 getMin(); 
-		vec3 getMax();
+		inline const Vector & getExtents() const { return m_extents; }
+		Vector getMin(); 
+		Vector getMax();
 	protected:
 		// How much the AABB extends from the centre
-		vec3 m_extents;
+		Vector m_extents;
 	};
 }
-
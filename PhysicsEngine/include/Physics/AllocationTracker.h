@@ -0,0 +1,27 @@
+#pragma once
+#include "MemoryAccounting.h"
+#include <cstdint>
+/*
+	Opt-in counting of heap allocations, used to check that a warmed up scene steps without allocating.
+	Defining PHYSICS_TRACK_ALLOCATIONS for the whole program replaces the global operator new and delete with versions that
+	count every call on any thread before passing it on to malloc and free. Debug builds define it. Without it the counts
+	stay at zero.
+	Each allocation also records its size and the category of the thread's memory scope in a header in front of it, so
+	the bytes are taken off the same category when it is freed.
+*/
+namespace Physics
+{
+	class AllocationTracker
+	{
+	public:
+		// Whether the counting operators are compiled in
+		static bool isEnabled();
+
+		// The number of allocations and frees made since the program started
+		static uint64_t getAllocationCount();
+		static uint64_t getFreeCount();
+
+		// The bytes live in a category, the most that have been live in it at once, and the allocations made in it
+		static MemoryUsage getUsage(MemoryCategory category);
+	};
+}
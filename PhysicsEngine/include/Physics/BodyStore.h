@@ -0,0 +1,148 @@
+#pragma once
+#include "Precision.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+using glm::vec3;
+using glm::vec4;
+using std::vector;
+/*
+	Structure of arrays storage for the state of the bodies in a scene.
+	Every component of the state the scene steps is kept in its own contiguous array, so the loops of a step only stream
+	through the bytes they use. Colour and the owning objects are kept in separate cold arrays that only drawing touches.
+	Objects are views of a body in a store, see Object. A body is found by its index, which changes when another body is
+	removed since the last body is moved into its place, the owning object is told its new index when that happens.
+*/
+namespace Physics
+{
+	// Allocates arrays aligned to a cache line, so no array shares its first line with another and vector loads are aligned
+	template <typename T, size_t Alignment = 64>
+	struct AlignedAllocator
+	{
+		typedef T value_type;
+
+		AlignedAllocator() {}
+		template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+		template <typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+		T * allocate(size_t count)
+		{
+			// Over allocate and keep the pointer that was returned just before the aligned block so it can be freed
+			char * memory = (char *)::operator new(count * sizeof(T) + Alignment + sizeof(void *));
+			uintptr_t aligned = ((uintptr_t)(memory + sizeof(void *)) + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+			((void **)aligned)[-1] = memory;
+			return (T *)aligned;
+		}
+
+		void deallocate(T * pointer, size_t)
+		{
+			::operator delete(((void **)pointer)[-1]);
+		}
+
+		template <typename U> bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+		template <typename U> bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+	};
+
+	template <typename T>
+	using AlignedVector = vector<T, AlignedAllocator<T>>;
+
+	template <typename Real>
+	class BasicBodyStore
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicObject<Real> Object;
+
+		// Constructor
+		BasicBodyStore();
+
+		// Destructor
+		~BasicBodyStore();
+
+		// Adds a body owned by the object and returns its index
+		int add(Object * owner, const Vector & position, Real mass, const vec4 & color, bool isStatic);
+
+		// Moves a body from another store into this one and returns its new index in this store
+		int moveFrom(BasicBodyStore & other, int index);
+
+		// Removes a body by moving the last body into its place
+		void remove(int index);
+
+		// Removes every body marked in removed, which is in the same order as the bodies, in one pass that keeps the rest in
+		// order. The objects of the removed bodies are left without a store, they are expected to be deleted straight after
+		void compact(const vector<bool> & removed);
+
+		// The number of bodies in the store
+		inline int size() const { return (int)m_owner.size(); }
+
+		// The bytes of hot state a fixed step reads or writes for each body it steps: position, previous position,
+		// velocity and acceleration, inverse mass, friction and the static flag
+		static const size_t HOT_BYTES_PER_BODY = 14 * sizeof(Real) + sizeof(uint8_t);
+
+		// The bytes the store's arrays hold on to
+		size_t getMemoryBytes() const;
+
+		// Getters
+		inline Vector getPosition(int body) const { return Vector(m_positionX[body], m_positionY[body], m_positionZ[body]); }
+		inline Vector getPreviousPosition(int body) const { return Vector(m_previousX[body], m_previousY[body], m_previousZ[body]); }
+		inline Vector getVelocity(int body) const { return Vector(m_velocityX[body], m_velocityY[body], m_velocityZ[body]); }
+		inline Vector getAcceleration(int body) const { return Vector(m_accelerationX[body], m_accelerationY[body], m_accelerationZ[body]); }
+		inline Real getMass(int body) const { return m_mass[body]; }
+		inline Real getInverseMass(int body) const { return m_inverseMass[body]; }
+		inline Real getFriction(int body) const { return m_friction[body]; }
+		inline Real getElasticity(int body) const { return m_elasticity[body]; }
+		inline bool getIsStatic(int body) const { return m_isStatic[body] != 0; }
+		inline int getLODLevel(int body) const { return m_lodLevel[body]; }
+		inline const vec4 & getColor(int body) const { return m_color[body]; }
+		inline Object * getOwner(int body) const { return m_owner[body]; }
+
+		// The arrays of an axis of position or velocity, 0 to 2 for x to z, for loops that read many bodies through indices
+		inline const Real * getPositionArray(int axis) const { return axis == 0 ? m_positionX.data() : axis == 1 ? m_positionY.data() : m_positionZ.data(); }
+		inline const Real * getVelocityArray(int axis) const { return axis == 0 ? m_velocityX.data() : axis == 1 ? m_velocityY.data() : m_velocityZ.data(); }
+
+		// The hot arrays to write through, for loops that stream every body in order rather than going through getters
+		inline Real * getPositionArray(int axis) { return axis == 0 ? m_positionX.data() : axis == 1 ? m_positionY.data() : m_positionZ.data(); }
+		inline Real * getPreviousPositionArray(int axis) { return axis == 0 ? m_previousX.data() : axis == 1 ? m_previousY.data() : m_previousZ.data(); }
+		inline Real * getVelocityArray(int axis) { return axis == 0 ? m_velocityX.data() : axis == 1 ? m_velocityY.data() : m_velocityZ.data(); }
+		inline Real * getAccelerationArray(int axis) { return axis == 0 ? m_accelerationX.data() : axis == 1 ? m_accelerationY.data() : m_accelerationZ.data(); }
+		inline const Real * getInverseMassArray() const { return m_inverseMass.data(); }
+		inline const Real * getFrictionArray() const { return m_friction.data(); }
+		inline const uint8_t * getIsStaticArray() const { return m_isStatic.data(); }
+
+		// Setters
+		inline void setPosition(int body, const Vector & position) { m_positionX[body] = position.x; m_positionY[body] = position.y; m_positionZ[body] = position.z; }
+		inline void setVelocity(int body, const Vector & velocity) { m_velocityX[body] = velocity.x; m_velocityY[body] = velocity.y; m_velocityZ[body] = velocity.z; }
+		inline void setAcceleration(int body, const Vector & acceleration) { m_accelerationX[body] = acceleration.x; m_accelerationY[body] = acceleration.y; m_accelerationZ[body] = acceleration.z; }
+		inline void setFriction(int body, Real friction) { m_friction[body] = friction; }
+		inline void setElasticity(int body, Real elasticity) { m_elasticity[body] = elasticity; }
+		inline void setLODLevel(int body, int level) { m_lodLevel[body] = level; }
+		inline void setColor(int body, const vec4 & color) { m_color[body] = color; }
+
+		// The inverse mass is worked out here once, static bodies have an inverse mass of zero
+		inline void setMass(int body, Real mass) { m_mass[body] = mass; m_inverseMass[body] = m_isStatic[body] ? Real(0) : Real(1) / mass; }
+
+		// Copies the current position into the previous position, called before each fixed step
+		inline void storePreviousPosition(int body) { m_previousX[body] = m_positionX[body]; m_previousY[body] = m_positionY[body]; m_previousZ[body] = m_positionZ[body]; }
+
+	private:
+		// Hot state, read and written by every fixed step
+		AlignedVector<Real> m_positionX, m_positionY, m_positionZ;
+		AlignedVector<Real> m_previousX, m_previousY, m_previousZ;
+		AlignedVector<Real> m_velocityX, m_velocityY, m_velocityZ;
+		AlignedVector<Real> m_accelerationX, m_accelerationY, m_accelerationZ;
+		AlignedVector<Real> m_inverseMass;	// Forces are multiplied by the inverse mass, which is zero for static bodies
+		AlignedVector<Real> m_friction;
+		AlignedVector<uint8_t> m_isStatic;
+
+		// Warm state, only read by collision resolution, energy and level of detail
+		AlignedVector<Real> m_mass;
+		AlignedVector<Real> m_elasticity;
+		AlignedVector<int> m_lodLevel;
+
+		// Cold state, only used for drawing and bookkeeping
+		vector<vec4> m_color;
+		vector<Object *> m_owner;
+	};
+}
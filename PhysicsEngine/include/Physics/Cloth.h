@@ -0,0 +1,143 @@
+#pragma once
+#include "BodyStore.h"
+#include "FrameArena.h"
+#include "Precision.h"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+using glm::vec4;
+/*
+	A compact cloth, a grid of particles joined by springs that is simulated without an object or spring for each of them.
+	Each particle only keeps its position, its position at the start of the step for drawing, and its velocity, one array
+	per axis. The mass, friction, spring settings and colour are shared by the whole cloth, and the springs are
+	implied by the grid: structural springs along the rows and columns and shear springs along both diagonals.
+	Velocity can be kept as half floats, which loses about three decimal digits of it in return for six fewer bytes per
+	particle. Nothing the size of the cloth is unpacked, the spring forces unpack a row at a time and each particle is
+	unpacked and packed again as it is moved, so it is rounded at the end of every substep.
+	The scene steps its cloths every fixed step with the spring substeps and symplectic Euler. Cloths don't collide with
+	the scene's objects or levels of detail, they are meant for large sheets that would cost too much as objects.
+*/
+namespace Physics
+{
+	template <typename Real>
+	class BasicCloth
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+
+		// Constructor. Row i, column j starts at origin + (i, j, 0) * spacing, the same layout as the app's cloth of spheres.
+		// Structural springs are spacing long and shear springs spacing * sqrt(2), all with the same coefficient and damping
+		BasicCloth(int rows, int columns, const Vector & origin, Real spacing, Real particleMass, Real springCoefficient, Real damping, const vec4 & color, bool compactVelocity = false);
+
+		// Pinned particles don't move
+		void setPinned(int row, int column);
+
+		// Getters
+		inline int getRows() const { return m_rows; }
+		inline int getColumns() const { return m_columns; }
+		inline int getParticleCount() const { return m_rows * m_columns; }
+		inline int getSpringCount() const { return (m_rows - 1) * m_columns + m_rows * (m_columns - 1) + 2 * (m_rows - 1) * (m_columns - 1); }
+		inline int getPinnedCount() const { return (int)m_pinned.size(); }
+		inline bool getCompactVelocity() const { return m_compactVelocity; }
+		inline Real getParticleMass() const { return m_particleMass; }
+		inline Real getFriction() const { return m_friction; }
+		inline Real getSpringCoefficient() const { return m_springCoefficient; }
+		inline Vector getPosition(int particle) const { return Vector(m_positionX[particle], m_positionY[particle], m_positionZ[particle]); }
+		inline Vector getPreviousPosition(int particle) const { return Vector(m_previousX[particle], m_previousY[particle], m_previousZ[particle]); }
+		inline const vec4 & getColor() const { return m_color; }
+		Vector getVelocity(int particle) const;
+
+		// Setters
+		inline void setFriction(Real friction) { m_friction = friction; }
+		void setVelocity(int particle, const Vector & velocity);
+		void setSpringCoefficient(Real springCoefficient);
+
+		// Advances the cloth through deltaTime in substeps equal steps, forEach(count, body) calls body(begin, end) over
+		// ranges covering 0 to count and may run them in parallel. The spring forces the step works out are taken from the
+		// arena, which must not be reset until it returns
+		template <typename ForEach>
+		void step(Real deltaTime, int substeps, const Vector & gravity, FrameArena & arena, ForEach forEach);
+
+		// Draws the structural springs, blended between the previous and current fixed step by alpha
+		void draw(float alpha) const;
+
+		// Kinetic, gravitational and spring energy of the cloth, the same way Scene::getTotalEnergy counts objects
+		Real getEnergy(const Vector & gravity) const;
+
+		// Mixes the bits of every position and velocity into an FNV-1a hash
+		uint64_t hashState(uint64_t hash) const;
+
+		// Bytes kept for each particle, and the bytes the whole cloth holds on to
+		static size_t getBytesPerParticle(bool compactVelocity);
+		size_t getMemoryBytes() const;
+
+	private:
+		// The four kinds of spring, each joins particle (row, column) to (row + rowOffset, column + columnOffset)
+		enum { RIGHT, UP, UP_RIGHT, UP_LEFT, DIRECTIONS };
+		static const int ROW_OFFSET[DIRECTIONS];
+		static const int COLUMN_OFFSET[DIRECTIONS];
+
+		// Stores the previous positions and takes the step's spring forces from the arena
+		void beginStep(FrameArena & arena);
+
+		// Works out the forces of the springs whose first particle is in particles begin to end
+		void computeSpringForces(size_t begin, size_t end);
+
+		// Adds up the forces on particles begin to end and moves them with symplectic Euler
+		void integrateParticles(Real deltaTime, const Vector & gravity, size_t begin, size_t end);
+
+		// Puts the pinned particles back and stops them
+		void endSubstep();
+		void endStep();
+
+		int m_rows;
+		int m_columns;
+
+		// Shared by every particle
+		Real m_particleMass;
+		Real m_inverseMass;
+		Real m_friction;
+		Real m_springCoefficient;
+		Real m_damping;
+		Real m_structuralLength;
+		Real m_shearLength;
+		vec4 m_color;
+
+		// Per particle state
+		AlignedVector<Real> m_positionX, m_positionY, m_positionZ;
+		AlignedVector<Real> m_previousX, m_previousY, m_previousZ;
+		AlignedVector<Real> m_velocityX, m_velocityY, m_velocityZ;			// Empty with compact velocity
+		AlignedVector<uint16_t> m_halfVelocityX, m_halfVelocityY, m_halfVelocityZ;	// Empty without it
+		bool m_compactVelocity;
+
+		// The pinned particles, in the order they were pinned
+		vector<int> m_pinned;
+
+		// The spring kernel reads a value per spring, so the shared spring settings are repeated along a row. The body
+		// indices of a row's springs are columns, taken from 0 to 2 * columns + 1
+		AlignedVector<Real> m_rowStructuralLength;
+		AlignedVector<Real> m_rowShearLength;
+		AlignedVector<Real> m_rowSpringCoefficient;
+		AlignedVector<Real> m_rowDamping;
+		vector<int> m_columnIndex;
+
+		// Scratch of the current step, from the arena. Forces of each kind of spring are kept by their first particle
+		Real * m_springForce[DIRECTIONS][3];
+	};
+
+	template <typename Real>
+	template <typename ForEach>
+	void BasicCloth<Real>::step(Real deltaTime, int substeps, const Vector & gravity, FrameArena & arena, ForEach forEach)
+	{
+		beginStep(arena);
+		Real substepTime = deltaTime / substeps;
+		size_t count = (size_t)getParticleCount();
+		for (int substep = 0; substep < substeps; substep++)
+		{
+			forEach(count, [&](size_t begin, size_t end) { computeSpringForces(begin, end); });
+			forEach(count, [&](size_t begin, size_t end) { integrateParticles(substepTime, gravity, begin, end); });
+			endSubstep();
+		}
+		endStep();
+	}
+}
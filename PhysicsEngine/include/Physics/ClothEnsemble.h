@@ -0,0 +1,120 @@
+#pragma once
+#include "BodyStore.h"
+#include "Precision.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+using std::vector;
+/*
+	Many instances of the same compact cloth, stepped together with each instance in its own SIMD lane, for Monte Carlo
+	runs and sweeps over one rig.
+	Every instance has the same grid, spacing, starting position and pins, and its own spring coefficient, damping,
+	particle mass and friction. The instances are kept in blocks of LANES, and within a block each value of a particle
+	is stored for every lane next to each other, so particle i's x position in lane l is positionX[i * LANES + l]. As
+	the grid is the same in every lane, a spring reads its two particles' lanes with plain loads and works out its force
+	for all of a block's instances at once, with no gathers. Integration is done the same way.
+	Each lane steps exactly like a compact cloth with full precision velocities, see Cloth: the same symplectic Euler
+	substeps with the operations in the same order, so an instance matches a Cloth made with its settings bit for bit.
+	Float blocks are stepped eight lanes to an instruction with AVX, or four with SSE, where the target has them. The
+	project's x64 configurations build with /arch:AVX for this, Win32 ones get SSE and four lanes at a time. Double
+	blocks use plain loops over the lanes, which compilers can vectorize. Blocks are independent, so they are shared out
+	over a worker pool when one is given.
+*/
+namespace Physics
+{
+	class WorkerPool;
+
+	template <typename Real>
+	class BasicClothEnsemble
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+
+		// The number of instances in a block
+		static const int LANES = 8;
+
+		// Constructor. Every instance starts with the same settings, as a Cloth with the same arguments would, and can be
+		// given its own afterwards. The last block's lanes past instanceCount are stepped with the first instance's settings
+		BasicClothEnsemble(int instanceCount, int rows, int columns, const Vector & origin, Real spacing, Real particleMass, Real springCoefficient, Real damping);
+
+		// Pins a particle in every instance
+		void setPinned(int row, int column);
+
+		// Settings of one instance
+		void setSpringCoefficient(int instance, Real springCoefficient);
+		void setDamping(int instance, Real damping);
+		void setParticleMass(int instance, Real particleMass);
+		void setFriction(int instance, Real friction);
+
+		// Advances every instance through deltaTime in substeps equal steps, the blocks are shared out over the workers if
+		// there are any
+		void step(Real deltaTime, int substeps, const Vector & gravity, WorkerPool * workers = nullptr);
+
+		// Getters
+		inline int getInstanceCount() const { return m_instanceCount; }
+		inline int getBlockCount() const { return (int)m_blocks.size(); }
+		inline int getRows() const { return m_rows; }
+		inline int getColumns() const { return m_columns; }
+		inline int getParticleCount() const { return m_rows * m_columns; }
+		Vector getPosition(int instance, int particle) const;
+		Vector getVelocity(int instance, int particle) const;
+
+		// Energy and state hash of one instance, the same as Cloth::getEnergy and Cloth::hashState
+		Real getEnergy(int instance, const Vector & gravity) const;
+		uint64_t hashState(int instance, uint64_t hash) const;
+
+		// Whether float blocks are stepped with SIMD on this target, and how many lanes an instruction covers
+		static int getSimdWidth();
+
+		// Bytes the ensemble holds on to
+		size_t getMemoryBytes() const;
+
+	private:
+		// The same four kinds of spring as Cloth, each joins particle (row, column) to (row + rowOffset, column + columnOffset)
+		enum { RIGHT, UP, UP_RIGHT, UP_LEFT, DIRECTIONS };
+		static const int ROW_OFFSET[DIRECTIONS];
+		static const int COLUMN_OFFSET[DIRECTIONS];
+
+		// LANES instances, every array holds LANES values per particle. The spring forces are the block's own scratch so
+		// blocks can be stepped at the same time, and are kept by the first particle of each spring like Cloth's
+		struct Block
+		{
+			AlignedVector<Real> positionX, positionY, positionZ;
+			AlignedVector<Real> previousX, previousY, previousZ;
+			AlignedVector<Real> velocityX, velocityY, velocityZ;
+			AlignedVector<Real> springForce[DIRECTIONS][3];
+
+			// Settings of each lane
+			Real particleMass[LANES];
+			Real inverseMass[LANES];
+			Real springCoefficient[LANES];
+			Real damping[LANES];
+			Real friction[LANES];
+		};
+
+		// Steps one block through one fixed step
+		void stepBlock(Block & block, Real deltaTime, int substeps, const Vector & gravity);
+
+		int m_instanceCount;
+		int m_rows;
+		int m_columns;
+		Real m_structuralLength;
+		Real m_shearLength;
+
+		vector<Block> m_blocks;
+		vector<int> m_pinned;
+	};
+
+	// Steps instanceCount cloths of rows by columns, each with its own spring coefficient, for steps fixed steps as a cloth
+	// ensemble and as separate Cloths, and checks they end up the same. Times are the total milliseconds
+	struct ClothEnsembleBenchmark
+	{
+		int instanceCount;
+		int simdWidth;
+		float clothTime;
+		float ensembleTime;
+		bool matches;		// Whether every instance's state hash matched its Cloth's
+	};
+	ClothEnsembleBenchmark benchmarkClothEnsemble(int instanceCount, int rows, int columns, int steps);
+}
@@ -1,19 +1,26 @@
 #pragma once
+#include "Precision.h"
 /*
 	Constraint pure virtual class which is a base for all types of constraints used in the project
 */
 namespace Physics
 {
-	class Object;
-	class Constraint
+	template <typename Real>
+	class BasicConstraint
 	{
 	public:
+		typedef BasicObject<Real> Object;
+
 		// Virtual destructor
-		virtual ~Constraint();
+		virtual ~BasicConstraint();
+
+		// Getters for the constrained objects
+		inline Object * getObjectA() const { return m_objA; }
+		inline Object * getObjectB() const { return m_objB; }
 	protected:
 		// Protected constructor so that only child classes can initialise this
 		// To initialise, the constructor takes object pointers to the objects that the constraint constrains
-		Constraint(Object * objA, Object * objB);
+		BasicConstraint(Object * objA, Object * objB);
 		Object * m_objA;
 		Object * m_objB;
 	};
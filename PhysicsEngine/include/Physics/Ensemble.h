@@ -0,0 +1,95 @@
+#pragma once
+#include "Integrator.h"
+#include "Precision.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+using std::vector;
+/*
+	Many independent copies of one scene, stepped side by side in one process, for parameter sweeps.
+	Every instance is built by the same template function, which fills an empty scene, and then has its own overrides
+	applied to what the template built. Running the ensemble steps every instance the same number of fixed steps, the
+	instances are shared out over a worker pool and each one is stepped on a single thread, so instances don't wait on
+	each other and no two threads ever touch the same scene. Metrics are collected from each instance once it has run.
+	The instances are deterministic scenes, so an instance's state hash only depends on its template and overrides.
+*/
+namespace Physics
+{
+	class WorkerPool;
+
+	// Values an instance changes from its template, a negative value keeps what the template set
+	template <typename Real>
+	struct BasicEnsembleOverrides
+	{
+		Real springCoefficient = Real(-1);		// Of every spring and cloth
+		Real elasticity = Real(-1);				// Of every object
+		Real friction = Real(-1);				// Of every object and cloth
+	};
+
+	// What an instance measured after the last run
+	template <typename Real>
+	struct BasicEnsembleMetrics
+	{
+		Real startEnergy;			// Total energy when the instance was built
+		Real energy;				// Total energy after the run
+		Real averageStretch;		// Spring stretch, see Scene::getAverageSpringStretch
+		Real maxStretch;
+		uint64_t stateHash;			// See Scene::getStateHash
+		int objectCount;
+		int stepCount;				// Fixed steps the instance has taken since it was built
+		float runTime;				// Milliseconds the instance's part of the last run took
+	};
+
+	template <typename Real>
+	class BasicEnsemble
+	{
+	public:
+		typedef BasicScene<Real> Scene;
+		typedef BasicEnsembleOverrides<Real> Overrides;
+		typedef BasicEnsembleMetrics<Real> Metrics;
+
+		// Fills an empty scene with the template's objects, springs, cloths and settings
+		typedef std::function<void(Scene & scene)> BuildFunction;
+
+		// Constructor, every instance is a scene with the integrator built by build
+		BasicEnsemble(BuildFunction build, IntegratorType integrator = IntegratorType::SYMPLECTIC_EULER);
+
+		// Destructor, deletes the instances
+		~BasicEnsemble();
+
+		// Builds an instance from the template, applies its overrides and returns its index
+		int addInstance(const Overrides & overrides);
+
+		// Steps every instance through steps fixed steps, the instances are shared out over threadCount threads
+		void run(int steps, int threadCount);
+
+		// Getters
+		inline int getInstanceCount() const { return (int)m_instances.size(); }
+		inline Scene * getScene(int instance) const { return m_instances[instance]; }
+		inline const Overrides & getOverrides(int instance) const { return m_overrides[instance]; }
+		inline const Metrics & getMetrics(int instance) const { return m_metrics[instance]; }
+
+		// Milliseconds the last run took from start to finish, and the sum of the instances' own run times
+		inline float getLastRunTime() const { return m_lastRunTime; }
+		float getInstanceRunTime() const;
+
+	private:
+		// Sets what the overrides change in a scene built from the template
+		void applyOverrides(Scene & scene, const Overrides & overrides);
+
+		// Fills in an instance's metrics from its scene
+		void collectMetrics(int instance);
+
+		BuildFunction m_build;
+		IntegratorType m_integrator;
+
+		vector<Scene *> m_instances;
+		vector<Overrides> m_overrides;
+		vector<Metrics> m_metrics;
+
+		// Threads the instances are stepped on, made for the first run and remade when the thread count changes
+		WorkerPool * m_workers;
+
+		float m_lastRunTime;
+	};
+}
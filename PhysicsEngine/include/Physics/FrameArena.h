@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+using std::vector;
+/*
+	Linear allocator for the scratch memory of a fixed step, such as the collisions found and the spring forces.
+	Allocating moves an offset along one block and nothing is freed on its own, the scene resets the whole arena at the end
+	of each step. Allocation is safe from several threads at once. When a step needs more than the block holds, the rest
+	is allocated separately and the block is grown to fit at the next reset, so a steady scene settles on a single block.
+*/
+namespace Physics
+{
+	class FrameArena
+	{
+	public:
+		// Constructor, capacity is the size of the first block in bytes
+		FrameArena(size_t capacity = 64 * 1024);
+
+		// Destructor
+		~FrameArena();
+
+		// Returns uninitialised memory that stays valid until the next reset
+		void * allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+		template <typename T>
+		inline T * allocate(size_t count) { return (T *)allocate(count * sizeof(T), alignof(T)); }
+
+		// Frees everything allocated since the last reset
+		void reset();
+
+		// In debug mode freed memory is filled with POISON so anything still reading it is easy to spot
+		// It is on by default in debug builds
+		static const unsigned char POISON = 0xDD;
+		inline void setPoisonFreed(bool poisonFreed) { m_poisonFreed = poisonFreed; }
+		inline bool getPoisonFreed() const { return m_poisonFreed; }
+
+		// Stats, in bytes. The high water mark is the most used by a single step
+		inline size_t getUsed() const { return m_offset + m_overflowBytes; }
+		inline size_t getCapacity() const { return m_capacity; }
+		inline size_t getHighWaterMark() const { return m_highWaterMark; }
+
+		// Everything the arena holds on to, the block and any allocations that didn't fit in it
+		inline size_t getMemoryBytes() const { return m_capacity + m_overflowBytes + m_overflowBlocks.capacity() * sizeof(void *); }
+
+		// The number of steps that needed more than the block held
+		inline int getOverflowCount() const { return m_overflowCount; }
+
+	private:
+		char * m_block;
+		size_t m_capacity;
+		std::atomic<size_t> m_offset;
+
+		// Allocations that didn't fit in the block
+		std::mutex m_overflowMutex;
+		vector<void *> m_overflowBlocks;
+		size_t m_overflowBytes;
+
+		size_t m_highWaterMark;
+		int m_overflowCount;
+		bool m_poisonFreed;
+	};
+
+	// Lets standard containers take their memory from a frame arena, freeing does nothing until the arena is reset
+	template <typename T>
+	struct ArenaAllocator
+	{
+		typedef T value_type;
+
+		ArenaAllocator(FrameArena * arena) : arena(arena) {}
+		template <typename U> ArenaAllocator(const ArenaAllocator<U> & other) : arena(other.arena) {}
+
+		inline T * allocate(size_t count) { return arena->allocate<T>(count); }
+		inline void deallocate(T *, size_t) {}
+
+		template <typename U> bool operator==(const ArenaAllocator<U> & other) const { return arena == other.arena; }
+		template <typename U> bool operator!=(const ArenaAllocator<U> & other) const { return arena != other.arena; }
+
+		FrameArena * arena;
+	};
+
+	template <typename T>
+	using ArenaVector = vector<T, ArenaAllocator<T>>;
+}
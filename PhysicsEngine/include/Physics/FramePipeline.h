@@ -0,0 +1,97 @@
+#pragma once
+#include "Precision.h"
+#include "RenderSnapshot.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <glm/glm.hpp>
+/*
+	Steps a scene a frame ahead of what is drawn, so the step for the next frame runs while the current one is drawn,
+	uploaded and presented.
+	Each frame waitForStep waits for the step begun the frame before and makes its snapshot the one to draw, then
+	beginStep starts the next step on the pipeline's thread and returns straight away, and the frame is drawn from the
+	snapshot while that step runs. This gives the following ordering:
+	- From waitForStep to beginStep no step is running, and the scene can be read and changed directly, by debug
+	  windows for example. From beginStep to the next waitForStep only the pipeline's thread may touch the scene, apart
+	  from sending it commands and taking spawn results, see Scene::pushCommand.
+	- Commands pushed between waitForStep and beginStep are applied by the step beginStep begins, so input handled
+	  there is picked up by the next step. Commands pushed while a step runs may be applied by that step or the next.
+	- The snapshot drawn in a frame is the scene after the step begun in the frame before, so what is drawn is one
+	  frame behind the scene. That is what the overlap costs.
+	- Since every snapshot is drawn exactly one frame after it was taken, it is drawn at the interpolation alpha it was
+	  taken at, which moves on by one frame's time each frame. Adding the time since it was taken as well, as
+	  SimulationThread snapshots do, would hold each one at the end of its step and make uneven jumps between them.
+	- The snapshot is taken on the pipeline's thread at the end of its step into the other of two snapshots, so the one
+	  being drawn isn't written until after the next waitForStep and needs no locking.
+	Unlike SimulationThread, which steps at the scene's fixed rate whatever the frame rate, the pipeline runs exactly one
+	update per frame with the frame's time, the same updates as stepping the scene in the frame would.
+*/
+namespace Physics
+{
+	// When the last step ran, in the snapshot clock, and how long the frame that waited for it was held up
+	struct PipelineStepTimes
+	{
+		RenderSnapshot::Clock::time_point start;
+		RenderSnapshot::Clock::time_point end;
+		float waitTime;		// Milliseconds waitForStep waited
+	};
+
+	template <typename Real>
+	class BasicFramePipeline
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicScene<Real> Scene;
+
+		// Constructor, starts the pipeline's thread and takes a snapshot of the scene so there is one to draw before the
+		// first step. The scene isn't owned and must outlive the pipeline
+		BasicFramePipeline(Scene * scene);
+
+		// Destructor, waits for the step in progress and stops the thread, after which the scene can be used directly again
+		~BasicFramePipeline();
+
+		// Starts updating the scene by deltaTime on the pipeline's thread, with its level of detail measured from lodFocus.
+		// Waits for the previous step first if it hasn't been waited for
+		void beginStep(float deltaTime, const Vector & lodFocus);
+
+		// Waits for the step in progress, if there is one, and makes its snapshot the one to draw
+		void waitForStep();
+
+		// Getters
+		inline bool isStepping() const { return m_stepping; }
+		inline Scene * getScene() const { return m_scene; }
+
+		// The snapshot of the last step waited for, unchanged until the next waitForStep
+		inline const RenderSnapshot & getSnapshot() const { return m_snapshots[m_front]; }
+
+		// Times of the last step waited for
+		inline const PipelineStepTimes & getStepTimes() const { return m_stepTimes; }
+
+	private:
+		// The loop the thread runs, a step each time one is begun, until the pipeline is destroyed
+		void run();
+
+		Scene * m_scene;
+		std::thread m_thread;
+
+		// Hands steps to the thread and back
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		bool m_stepRequested;		// Set by beginStep, cleared by the thread as it starts the step
+		bool m_stepDone;			// Set by the thread once the step and its snapshot are done
+		bool m_stopping;
+
+		// Whether a step has been begun and not waited for, only used by the thread calling beginStep and waitForStep
+		bool m_stepping;
+
+		// What the step begun is to do, written before it is requested
+		float m_deltaTime;
+		Vector m_lodFocus;
+
+		// The snapshot being drawn is m_snapshots[m_front], a step writes the other
+		RenderSnapshot m_snapshots[2];
+		int m_front;
+
+		PipelineStepTimes m_stepTimes;
+	};
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "MemoryAccounting.h"
+#include <cstdint>
+#include <vector>
+using std::vector;
+/*
+	Generational handles for the objects and springs of a scene.
+	A handle names a slot and the generation the slot was on when the handle was made. Removing the item moves the slot
+	to its next generation, so old handles stop resolving instead of pointing at whatever reuses the slot.
+	HandleMap maps slots to indices in the scene's dense arrays. Removing an item moves the last item into its place, the
+	map does the same so the caller only has to swap and pop its own arrays with the index it is given. Many items can be
+	removed at once by compacting instead, and a handle can be reserved before its item is added to the dense arrays.
+*/
+namespace Physics
+{
+	template <typename T>
+	struct Handle
+	{
+		uint32_t slot = 0;
+		uint32_t generation = 0;	// Generation 0 is never used, so a default handle is never valid
+
+		inline bool operator==(const Handle & other) const { return slot == other.slot && generation == other.generation; }
+		inline bool operator!=(const Handle & other) const { return !(*this == other); }
+	};
+
+	template <typename T>
+	class HandleMap
+	{
+	public:
+		// Makes a handle for a new item at the end of the dense arrays
+		Handle<T> add()
+		{
+			Handle<T> handle = reserve();
+			assign(handle);
+			return handle;
+		}
+
+		// Makes a handle for an item that isn't in the dense arrays yet, it doesn't resolve until it is assigned
+		Handle<T> reserve()
+		{
+			// Reuse a free slot if there is one
+			MemoryScope scope(MemoryCategory::HANDLES);
+			uint32_t slot;
+			if (!m_freeSlots.empty())
+			{
+				slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else
+			{
+				slot = (uint32_t)m_slots.size();
+				m_slots.push_back(Slot());
+			}
+			m_slots[slot].index = UNASSIGNED;
+
+			Handle<T> handle;
+			handle.slot = slot;
+			handle.generation = m_slots[slot].generation;
+			return handle;
+		}
+
+		// Puts the item of a reserved handle at the end of the dense arrays
+		void assign(Handle<T> handle)
+		{
+			MemoryScope scope(MemoryCategory::HANDLES);
+			m_slots[handle.slot].index = (uint32_t)m_denseSlots.size();
+			m_denseSlots.push_back(handle.slot);
+		}
+
+		// Frees the handle's slot and moves the last item's slot to the removed index, which is returned
+		// The caller moves its last item into that index too
+		int remove(Handle<T> handle)
+		{
+			int index = getIndex(handle);
+			if (index < 0) return -1;
+
+			MemoryScope scope(MemoryCategory::HANDLES);
+			m_slots[handle.slot].generation++;
+			m_freeSlots.push_back(handle.slot);
+
+			m_denseSlots[index] = m_denseSlots.back();
+			m_slots[m_denseSlots[index]].index = index;
+			m_denseSlots.pop_back();
+			return index;
+		}
+
+		// Removes every item marked in removed, which is in the same order as the dense arrays, keeping the rest in order
+		// The caller compacts its own arrays the same way
+		void compact(const vector<bool> & removed)
+		{
+			MemoryScope scope(MemoryCategory::HANDLES);
+			uint32_t write = 0;
+			for (uint32_t index = 0; index < (uint32_t)m_denseSlots.size(); index++)
+			{
+				uint32_t slot = m_denseSlots[index];
+				if (removed[index])
+				{
+					m_slots[slot].generation++;
+					m_freeSlots.push_back(slot);
+					continue;
+				}
+				m_slots[slot].index = write;
+				m_denseSlots[write++] = slot;
+			}
+			m_denseSlots.resize(write);
+		}
+
+		// The dense index of the handle's item, or -1 if it has been removed or not assigned yet
+		inline int getIndex(Handle<T> handle) const
+		{
+			if (handle.slot >= m_slots.size() || m_slots[handle.slot].generation != handle.generation) return -1;
+			if (m_slots[handle.slot].index == UNASSIGNED) return -1;
+			return (int)m_slots[handle.slot].index;
+		}
+
+		// The handle of the item at a dense index
+		inline Handle<T> getHandle(int index) const
+		{
+			Handle<T> handle;
+			handle.slot = m_denseSlots[index];
+			handle.generation = m_slots[handle.slot].generation;
+			return handle;
+		}
+
+		// The bytes the map holds on to
+		inline size_t getMemoryBytes() const { return getVectorBytes(m_slots) + getVectorBytes(m_freeSlots) + getVectorBytes(m_denseSlots); }
+
+	private:
+		// The index of a reserved slot that hasn't been assigned yet
+		static const uint32_t UNASSIGNED = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			uint32_t index = 0;			// Index of the item in the dense arrays
+			uint32_t generation = 1;	// Incremented every time the item in the slot is removed
+		};
+		vector<Slot> m_slots;
+		vector<uint32_t> m_freeSlots;
+		vector<uint32_t> m_denseSlots;	// The slot of each item in the dense arrays
+	};
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include "BodyStore.h"
+#include <glm/glm.hpp>
+#include <vector>
+using glm::vec3;
+using std::vector;
+/*
+	Integrator policies used by the scene to advance its objects through one fixed step.
+	Each policy is a type with a static step function. The scene picks one when it is constructed, so the
+	integration is inlined into a single loop over the bodies instead of being called through each object.
+	The step functions are templates over the precision of the store, see Precision.h.
+	The bodies stepped are given as indices into the scene's BodyStore, so the loops only touch the arrays they use.
+	evaluateForces is called by the policy whenever it needs the acceleration of every object at the current
+	positions and velocities, it accumulates gravity, friction and spring forces into the objects' accelerations.
+	forEach(count, body) calls body(begin, end) over ranges covering 0 to count, possibly in parallel, so the loop
+	bodies must only touch the bodies in their range.
+*/
+namespace Physics
+{
+	// Identifies which integrator policy a scene is constructed with
+	enum class IntegratorType { SYMPLECTIC_EULER, VELOCITY_VERLET, RK4 };
+
+	// State the scene keeps between steps for integrators that have to remember the start of the step
+	template <typename Real>
+	struct IntegratorScratch
+	{
+		vector<glm::tvec3<Real>> position;		// Position at the start of the step
+		vector<glm::tvec3<Real>> velocity;		// Velocity at the start of the step
+		vector<glm::tvec3<Real>> positionSum;	// Weighted sum of the position derivatives of each stage
+		vector<glm::tvec3<Real>> velocitySum;	// Weighted sum of the velocity derivatives of each stage
+	};
+
+	// Semi-implicit Euler, velocity is updated first and the new velocity moves the position
+	// One force evaluation per step
+	struct SymplecticEuler
+	{
+		// The largest angular frequency times time step an undamped spring stays stable at
+		static constexpr float stabilityLimit = 2.0f;
+
+		template <typename Real, typename Forces, typename ForEach>
+		static void step(BasicBodyStore<Real> & bodies, const vector<int> & indices, Real deltaTime, Forces evaluateForces, ForEach forEach, IntegratorScratch<Real> &)
+		{
+			typedef glm::tvec3<Real> Vector;
+			evaluateForces();
+			forEach(indices.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					int body = indices[i];
+					if (!bodies.getIsStatic(body))
+					{
+						bodies.setVelocity(body, bodies.getVelocity(body) + bodies.getAcceleration(body) * deltaTime);
+						bodies.setPosition(body, bodies.getPosition(body) + bodies.getVelocity(body) * deltaTime);
+					}
+					bodies.setAcceleration(body, Vector());
+				}
+			});
+		}
+	};
+
+	// Velocity Verlet (kick, drift, kick), second order and symplectic
+	// Two force evaluations per step, the second one at the new positions
+	struct VelocityVerlet
+	{
+		// The largest angular frequency times time step an undamped spring stays stable at
+		static constexpr float stabilityLimit = 2.0f;
+
+		template <typename Real, typename Forces, typename ForEach>
+		static void step(BasicBodyStore<Real> & bodies, const vector<int> & indices, Real deltaTime, Forces evaluateForces, ForEach forEach, IntegratorScratch<Real> &)
+		{
+			typedef glm::tvec3<Real> Vector;
+			Real halfStep = deltaTime * Real(0.5);
+
+			// Half kick with the acceleration at the start of the step, then drift the full step
+			evaluateForces();
+			forEach(indices.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					int body = indices[i];
+					if (!bodies.getIsStatic(body))
+					{
+						bodies.setVelocity(body, bodies.getVelocity(body) + bodies.getAcceleration(body) * halfStep);
+						bodies.setPosition(body, bodies.getPosition(body) + bodies.getVelocity(body) * deltaTime);
+					}
+					bodies.setAcceleration(body, Vector());
+				}
+			});
+
+			// Half kick with the acceleration at the end of the step
+			evaluateForces();
+			forEach(indices.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					int body = indices[i];
+					if (!bodies.getIsStatic(body))
+					{
+						bodies.setVelocity(body, bodies.getVelocity(body) + bodies.getAcceleration(body) * halfStep);
+					}
+					bodies.setAcceleration(body, Vector());
+				}
+			});
+		}
+	};
+
+	// Classic fourth order Runge-Kutta, accurate for the stiff springs of the cloth but not symplectic
+	// Four force evaluations per step
+	struct RungeKutta4
+	{
+		// The largest angular frequency times time step an undamped spring stays stable at
+		static constexpr float stabilityLimit = 2.8f;
+
+		template <typename Real, typename Forces, typename ForEach>
+		static void step(BasicBodyStore<Real> & bodies, const vector<int> & indices, Real deltaTime, Forces evaluateForces, ForEach forEach, IntegratorScratch<Real> & scratch)
+		{
+			typedef glm::tvec3<Real> Vector;
+			size_t count = indices.size();
+			scratch.position.resize(count);
+			scratch.velocity.resize(count);
+			scratch.positionSum.assign(count, Vector());
+			scratch.velocitySum.assign(count, Vector());
+
+			// Remember where the step started
+			forEach(count, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					scratch.position[i] = bodies.getPosition(indices[i]);
+					scratch.velocity[i] = bodies.getVelocity(indices[i]);
+				}
+			});
+
+			// Each stage is evaluated at the start state plus the previous stage's derivative times the offset,
+			// and contributes to the final derivative with its weight
+			const Real stageOffset[4] = { Real(0.5), Real(0.5), Real(1), Real(0) };
+			const Real stageWeight[4] = { Real(1), Real(2), Real(2), Real(1) };
+
+			for (int stage = 0; stage < 4; stage++)
+			{
+				evaluateForces();
+				forEach(count, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						int body = indices[i];
+						if (!bodies.getIsStatic(body))
+						{
+							// The derivative of position is the velocity and the derivative of velocity is the acceleration
+							Vector positionDerivative = bodies.getVelocity(body);
+							Vector velocityDerivative = bodies.getAcceleration(body);
+							scratch.positionSum[i] += positionDerivative * stageWeight[stage];
+							scratch.velocitySum[i] += velocityDerivative * stageWeight[stage];
+
+							// Move to the state the next stage is evaluated at
+							if (stage < 3)
+							{
+								bodies.setPosition(body, scratch.position[i] + positionDerivative * (deltaTime * stageOffset[stage]));
+								bodies.setVelocity(body, scratch.velocity[i] + velocityDerivative * (deltaTime * stageOffset[stage]));
+							}
+						}
+						bodies.setAcceleration(body, Vector());
+					}
+				});
+			}
+
+			// Combine the stages
+			forEach(count, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					int body = indices[i];
+					if (!bodies.getIsStatic(body))
+					{
+						bodies.setPosition(body, scratch.position[i] + scratch.positionSum[i] * (deltaTime / Real(6)));
+						bodies.setVelocity(body, scratch.velocity[i] + scratch.velocitySum[i] * (deltaTime / Real(6)));
+					}
+				}
+			});
+		}
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+/*
+	Memory use of the physics and rendering subsystems, by category.
+	Subsystems report the bytes they hold on to, worked out from the capacity of their arrays, pools and buffers, so the
+	figures are there in every build. A report keeps the largest figure reported for each category as its peak, sizing
+	a production scene from the peaks of a run leaves room for every moment of it.
+	With PHYSICS_TRACK_ALLOCATIONS the allocation tracker also charges each heap allocation to the category of the
+	memory scope its thread is in, keeping the live and peak bytes and the number of allocations of every category.
+	Allocations made outside any scope are charged to OTHER.
+*/
+namespace Physics
+{
+	enum class MemoryCategory
+	{
+		BODIES,			// The body store
+		OBJECTS,		// Objects, their pools and the arrays that track them
+		SPRINGS,		// Springs, their pool and the arrays that track them
+		CLOTHS,			// Compact cloths
+		HANDLES,		// Handle maps
+		COMMANDS,		// Queued adds and removes
+		SUBSYSTEMS,		// Islands, levels of detail, spring arrays and tethers built from the objects and springs
+		FRAME_ARENA,	// Scratch for collisions and spring forces
+		RENDERING,		// Gizmo buffers
+		OTHER,
+		COUNT
+	};
+
+	struct MemoryUsage
+	{
+		size_t liveBytes;
+		size_t peakBytes;
+		uint64_t allocationCount;
+	};
+
+	// Name of a category for display
+	const char * getMemoryCategoryName(MemoryCategory category);
+
+	// The bytes a vector holds on to, for working out reported figures
+	template <typename Vector>
+	inline size_t getVectorBytes(const Vector & vector) { return vector.capacity() * sizeof(typename Vector::value_type); }
+	inline size_t getVectorBytes(const std::vector<bool> & vector) { return vector.capacity() / 8; }
+
+	// Charges the heap allocations its thread makes while it exists to a category. Scopes nest, the innermost one wins
+	class MemoryScope
+	{
+	public:
+		explicit MemoryScope(MemoryCategory category);
+		~MemoryScope();
+		MemoryScope(const MemoryScope &) = delete;
+		MemoryScope & operator=(const MemoryScope &) = delete;
+
+		// The category of the thread's innermost scope, OTHER outside any scope
+		static MemoryCategory getCurrentCategory();
+
+	private:
+		MemoryCategory m_previous;
+	};
+
+	// Reported live and peak bytes for each category, AllocationTracker::getUsage has the tracked figures
+	class MemoryReport
+	{
+	public:
+		// Constructor, every category starts at zero
+		MemoryReport();
+
+		// Sets the bytes a category holds now, raising its peak if needed
+		void setLiveBytes(MemoryCategory category, size_t bytes);
+
+		// Getters
+		inline const MemoryUsage & getUsage(MemoryCategory category) const { return m_usage[(int)category]; }
+		size_t getTotalLiveBytes() const;
+		size_t getTotalPeakBytes() const;		// The sum of the peaks, which needn't have been at the same time
+
+	private:
+		// The allocation count is unused, it is only counted by the tracker
+		MemoryUsage m_usage[(int)MemoryCategory::COUNT];
+	};
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "BodyStore.h"
 #include <glm/glm.hpp>
 #include <vector>
 using glm::vec3;
@@ -7,83 +8,105 @@ using glm::vec4;
 
 namespace Physics
 {
-	// Forward declaration
-	class Sphere;
-	class Plane;
-	class AABB;
-
 	// ShapeType enum to identify the shape of the object
 	enum class ShapeType {SPHERE, PLANE, AABB};
 
 	/*
 	The object class is a base class for objects in the scene such as spheres and planes.
 	This class is pure virtual as it is not intended to instantiated on its own
+	An object is a view of its body in a BodyStore, where its position, velocity, mass and colour are kept. Until it is
+	added to a scene it has a store of its own, adding it moves its body into the scene's store and removing it moves it back
+	Real is the precision of the object's state, see Precision.h
 	*/
-	class Object
+	template <typename Real>
+	class BasicObject
 	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicBodyStore<Real> BodyStore;
+		typedef BasicObject<Real> Object;
+		typedef BasicSphere<Real> Sphere;
+		typedef BasicPlane<Real> Plane;
+		typedef BasicAABB<Real> AABB;
+
 	protected:
-		// Protected constructor
-		Object(ShapeType shape, vec3 pos, float mass, vec4 color, bool isStatic);
+		// Protected constructor, the body is added to bodies if given, otherwise the object gets a store of its own
+		BasicObject(ShapeType shape, Vector pos, Real mass, vec4 color, bool isStatic, BodyStore * bodies = nullptr);
 	public:
-		// Update takes deltaTime as an parameter and is responsible for updating the position of the object based on acceleration and velocity
-		void update(float deltaTime);
-		
 		// This function is used to apply a force to the object, increasing the acceleration relative to the mass
-		void applyForce(const vec3 & force);
+		void applyForce(const Vector & force);
 
 		// Used to add immediate force without taking into account mass and deltaTime
-		void applyImpulse(const vec3 & impulse);
+		void applyImpulse(const Vector & impulse);
 
 		// Pure virtual draw function as different objects will draw differently
-		virtual void draw() = 0;
+		// Alpha is how far between the previous and current fixed step the frame is, used to blend the two states
+		virtual void draw(float alpha) = 0;
+
+		// Copies the current position into the previous position, called by the scene before each fixed step
+		inline void storePreviousPosition() { m_bodies->storePreviousPosition(m_body); }
+
+		// Returns the position blended between the previous and current fixed step by alpha (0 = previous, 1 = current)
+		inline Vector getInterpolatedPosition(float alpha) const { return glm::mix(getPreviousPosition(), getPosition(), Real(alpha)); }
+
+		// Moves the object's body into another store, or into a store of its own if bodies is null
+		void setBodyStore(BodyStore * bodies);
+
+		// The store the object's body is in and its index there
+		inline BodyStore * getBodyStore() const { return m_bodies; }
+		inline int getBody() const { return m_body; }
 		
 		// Virtual destructor as this is a base class
-		virtual ~Object();
+		virtual ~BasicObject();
 
 		// This function returns a boolean if this object is colliding with the object passed through as an object pointer
 		// A reference to a collision normal variable is passed through to be edited when the collision detection is calculated
-		virtual bool isColliding(Object * other, vec3 & collisionNormal);
+		virtual bool isColliding(Object * other, Vector & collisionNormal);
 
 
 		// Getters
-		inline const vec3 & getPosition() const { return m_position; }
-		inline const vec3 & getVelocity() const { return m_velocity; }
-		inline const vec3 & getAcceleration() const { return m_acceleration; }
-		inline const float getMass() const { return m_mass; }
-		inline const float getFriction() const { return m_friction; }
+		inline Vector getPosition() const { return m_bodies->getPosition(m_body); }
+		inline Vector getPreviousPosition() const { return m_bodies->getPreviousPosition(m_body); }
+		inline Vector getVelocity() const { return m_bodies->getVelocity(m_body); }
+		inline Vector getAcceleration() const { return m_bodies->getAcceleration(m_body); }
+		inline const Real getMass() const { return m_bodies->getMass(m_body); }
+		inline const Real getFriction() const { return m_bodies->getFriction(m_body); }
 		inline const ShapeType getShapeType() const { return m_shape; }
-		inline const float getElasticity() const { return m_elasticity; }
-		inline const bool getIsStatic() const { return m_isStatic; }
+		inline const Real getElasticity() const { return m_bodies->getElasticity(m_body); }
+		inline const bool getIsStatic() const { return m_bodies->getIsStatic(m_body); }
+		inline int getLODLevel() const { return m_bodies->getLODLevel(m_body); }
+		inline const vec4 & getColor() const { return m_bodies->getColor(m_body); }
 
-		// Setters
-		inline void setPosition(const vec3 & pos) { m_position = pos; }
-		inline void setVelocity(const vec3 & vel) { m_velocity = vel; }
-		inline void setAcceleration(const vec3 & acc) { m_acceleration = acc; }
-		inline void setMass(float mass) { m_mass = mass; }
-		inline void setFriction(float friction) { m_friction = friction; }
-		inline void setElasticity(float elasticity) { m_elasticity = elasticity;}
+		// Setters, the stable spring step of a scene depends on mass and friction, so objects that have been added to one
+		// have them changed through it, see Scene::setFriction
+		inline void setPosition(const Vector & pos) { m_bodies->setPosition(m_body, pos); }
+		inline void setVelocity(const Vector & vel) { m_bodies->setVelocity(m_body, vel); }
+		inline void setAcceleration(const Vector & acc) { m_bodies->setAcceleration(m_body, acc); }
+		inline void setMass(Real mass) { m_bodies->setMass(m_body, mass); }
+		inline void setFriction(Real friction) { m_bodies->setFriction(m_body, friction); }
+		inline void setElasticity(Real elasticity) { m_bodies->setElasticity(m_body, elasticity); }
+		inline void setLODLevel(int level) { m_bodies->setLODLevel(m_body, level); }
+		inline void setColor(const vec4 & color) { m_bodies->setColor(m_body, color); }
 
 	protected:
-		vec3 m_position;			// The position of the object
-		vec3 m_velocity;			// The current velocity of the object
-		vec3 m_acceleration;		// The acceleration of the object
+		// The store keeps the index up to date when it moves the body
+		friend class BasicBodyStore<Real>;
+
+		BodyStore * m_bodies;		// The store the object's state is kept in
+		int m_body;					// The index of the object's body in the store
+		bool m_ownsBodies;			// Whether the store is the object's own, rather than a scene's
 		ShapeType m_shape;			// The shape type of the object
-		float m_mass = 1.0f;		// The mass of the object
-		float m_friction = 0.3f;	// A value between 0 and 1 to determine how much velocity is lost each tick
-		float m_elasticity = 1.f;	// Determines how much of the collision velocity is retained 
-		vec4 m_color;				// The RBG colour of the object
-		bool m_isStatic;			// Bool to determine if the object is static
 
 		// These functions check whether the respective objects are colliding
 		// They are called from the isColliding method after both objects are identified
 		// The collision normal reference is further passed into these functions because the collision will be calculate and the collision normal can be assigned
-		bool isCollidingSphereSphere(Sphere * objA, Sphere * objB, vec3 &collisionNormal);
-		bool isCollidingPlaneSphere(Plane * objA, Sphere * objB, vec3 &collisionNormal);
+		bool isCollidingSphereSphere(Sphere * objA, Sphere * objB, Vector & collisionNormal);
+		bool isCollidingPlaneSphere(Plane * objA, Sphere * objB, Vector & collisionNormal);
 
 		// TODO: Implement these collision function
-		bool isCollidingPlaneAABB(Plane * objA, AABB * objB, vec3 &collisionNormal);
-		bool isCollidingAABBAABB(AABB * objA, AABB * objB, vec3 &collisionNormal);
-		bool isCollidingSphereAABB(Sphere * objA, AABB * objB, vec3 &collisionNormal);
+		bool isCollidingPlaneAABB(Plane * objA, AABB * objB, Vector & collisionNormal);
+		bool isCollidingAABBAABB(AABB * objA, AABB * objB, Vector & collisionNormal);
+		bool isCollidingSphereAABB(Sphere * objA, AABB * objB, Vector & collisionNormal);
 	};
 }
 
@@ -7,28 +7,34 @@ using glm::vec3;
 */
 namespace Physics
 {
-	class Plane : public Object
+	template <typename Real>
+	class BasicPlane : public BasicObject<Real>
 	{
 	public:
+		typedef typename BasicObject<Real>::Vector Vector;
+
 		// Constructor requires a distance, direction, and colour
-		Plane(float distance, vec3 direction, vec4 color);
-		~Plane();
+		BasicPlane(Real distance, Vector direction, vec4 color);
+		~BasicPlane();
 		
 		// Draws the plane using gizmos; renders two triangles to show a complete rectangle
-		void draw();
+		void draw(float alpha);
+
+		// Draws a plane facing direction at distance along it, for drawing planes that have been copied out of the scene
+		static void drawPlane(const vec3 & direction, float distance, const vec4 & color);
 		
 		// Getter
-		inline const vec3 & getDirection() const { return m_direction; }
-		inline const float getDistance() const { return m_distance; }
+		inline const Vector & getDirection() const { return m_direction; }
+		inline const Real getDistance() const { return m_distance; }
 
 		// Setter
-		inline void setDirection(const vec3 & direction) { m_direction = direction; }
+		inline void setDirection(const Vector & direction) { m_direction = direction; }
 
 	protected:
 		// The direction that the plane is facing
-		vec3 m_direction;
+		Vector m_direction;
 		
 		// The distance that the plane is towards the direction
-		float m_distance;
+		Real m_distance;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using std::vector;
+/*
+	Slab allocator for one type of object.
+	Objects are constructed in blocks of BlockSize slots, so objects of the same type sit next to each other instead of
+	being spread over the heap. Destroyed objects put their slot on a free list and the next object created reuses it.
+	Blocks are only freed when the pool is, every object created must have been destroyed by then.
+*/
+namespace Physics
+{
+	template <typename T, size_t BlockSize = 256>
+	class Pool
+	{
+	public:
+		// Constructor
+		Pool() : m_freeList(nullptr), m_liveCount(0)
+		{
+		}
+
+		// Destructor, frees the blocks
+		~Pool()
+		{
+			for (auto block : m_blocks)
+			{
+				::operator delete(block);
+			}
+		}
+
+		// Constructs an object in a free slot, adding a block if there are none
+		template <typename... Args>
+		T * create(Args &&... args)
+		{
+			if (m_freeList == nullptr)
+			{
+				addBlock();
+			}
+			Slot * slot = m_freeList;
+			m_freeList = slot->next;
+			m_liveCount++;
+			return new (slot) T(std::forward<Args>(args)...);
+		}
+
+		// Destroys an object created by this pool and frees its slot for reuse
+		void destroy(T * object)
+		{
+			object->~T();
+			Slot * slot = (Slot *)object;
+			slot->next = m_freeList;
+			m_freeList = slot;
+			m_liveCount--;
+		}
+
+		// Getters
+		inline size_t getLiveCount() const { return m_liveCount; }
+		inline size_t getCapacity() const { return m_blocks.size() * BlockSize; }
+		inline size_t getMemoryBytes() const { return m_blocks.size() * BlockSize * sizeof(Slot) + m_blocks.capacity() * sizeof(Slot *); }
+
+	private:
+		// A slot either holds an object or the next free slot
+		union Slot
+		{
+			Slot * next;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		};
+
+		void addBlock()
+		{
+			Slot * block = (Slot *)::operator new(sizeof(Slot) * BlockSize);
+			m_blocks.push_back(block);
+
+			// Link the slots backwards so they are handed out in address order
+			for (size_t i = BlockSize; i > 0; i--)
+			{
+				block[i - 1].next = m_freeList;
+				m_freeList = &block[i - 1];
+			}
+		}
+
+		vector<Slot *> m_blocks;
+		Slot * m_freeList;
+		size_t m_liveCount;
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+/*
+	The precision the physics is simulated at.
+	The body store, objects, constraints and scene are templates over Real, the scalar type of their state and maths, and
+	use glm::tvec3<Real> as their vector type. A scene and everything in it share one precision, which is chosen at compile
+	time, so the loops of a step are compiled for it instead of checking which one they are using.
+	Float is the default and is what the plain names refer to. Double keeps objects far from the origin precise, at the cost
+	of twice the bytes per body. Both are instantiated in the library.
+*/
+namespace Physics
+{
+	template <typename Real> class BasicBodyStore;
+	template <typename Real> class BasicObject;
+	template <typename Real> class BasicSphere;
+	template <typename Real> class BasicPlane;
+	template <typename Real> class BasicAABB;
+	template <typename Real> class BasicConstraint;
+	template <typename Real> class BasicSpring;
+	template <typename Real> class BasicTether;
+	template <typename Real> class BasicCloth;
+	template <typename Real> class BasicScene;
+	template <typename Real> class BasicSimulationThread;
+	template <typename Real> class BasicFramePipeline;
+	template <typename Real> struct BasicSimulationCommand;
+	template <typename Real> struct BasicSpawnResult;
+	template <typename Real> class BasicEnsemble;
+	template <typename Real> struct BasicEnsembleOverrides;
+	template <typename Real> struct BasicEnsembleMetrics;
+	template <typename Real> class BasicClothEnsemble;
+
+	// Single precision
+	typedef BasicBodyStore<float> BodyStore;
+	typedef BasicObject<float> Object;
+	typedef BasicSphere<float> Sphere;
+	typedef BasicPlane<float> Plane;
+	typedef BasicAABB<float> AABB;
+	typedef BasicConstraint<float> Constraint;
+	typedef BasicSpring<float> Spring;
+	typedef BasicTether<float> Tether;
+	typedef BasicCloth<float> Cloth;
+	typedef BasicScene<float> Scene;
+	typedef BasicSimulationThread<float> SimulationThread;
+	typedef BasicFramePipeline<float> FramePipeline;
+	typedef BasicSimulationCommand<float> SimulationCommand;
+	typedef BasicSpawnResult<float> SpawnResult;
+	typedef BasicEnsemble<float> Ensemble;
+	typedef BasicEnsembleOverrides<float> EnsembleOverrides;
+	typedef BasicEnsembleMetrics<float> EnsembleMetrics;
+	typedef BasicClothEnsemble<float> ClothEnsemble;
+
+	// Double precision, for worlds too large for float
+	typedef BasicBodyStore<double> DoubleBodyStore;
+	typedef BasicObject<double> DoubleObject;
+	typedef BasicSphere<double> DoubleSphere;
+	typedef BasicPlane<double> DoublePlane;
+	typedef BasicAABB<double> DoubleAABB;
+	typedef BasicConstraint<double> DoubleConstraint;
+	typedef BasicSpring<double> DoubleSpring;
+	typedef BasicTether<double> DoubleTether;
+	typedef BasicCloth<double> DoubleCloth;
+	typedef BasicScene<double> DoubleScene;
+	typedef BasicSimulationThread<double> DoubleSimulationThread;
+	typedef BasicFramePipeline<double> DoubleFramePipeline;
+	typedef BasicSimulationCommand<double> DoubleSimulationCommand;
+	typedef BasicSpawnResult<double> DoubleSpawnResult;
+	typedef BasicEnsemble<double> DoubleEnsemble;
+	typedef BasicEnsembleOverrides<double> DoubleEnsembleOverrides;
+	typedef BasicEnsembleMetrics<double> DoubleEnsembleMetrics;
+	typedef BasicClothEnsemble<double> DoubleClothEnsemble;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "Object.h"
+#include <chrono>
+#include <vector>
+#include <glm/glm.hpp>
+using glm::vec3;
+using glm::vec4;
+using std::vector;
+/*
+	A copy of everything the scene draws, taken after a fixed step so it can be drawn while the scene goes on stepping.
+	It keeps the previous and current position of each object, spring end and cloth particle, so drawing blends between
+	them the same way Scene::draw does. Positions are in float whatever the scene's precision, since drawing is.
+	Taking a snapshot into one that has been filled before reuses its arrays, so a scene that stays the same size stops
+	allocating for them once they have grown.
+*/
+namespace Physics
+{
+	// The scene's state when a snapshot was taken, for showing without touching the scene
+	struct SnapshotStats
+	{
+		unsigned int stepIndex;		// Fixed steps the scene had taken
+		int objectCount;
+		int springCount;
+		int particleCount;			// Particles of the compact cloths
+		float updateTime;			// Milliseconds the scene's last update took
+		int stepCount;				// Fixed steps the last update ran
+	};
+
+	class RenderSnapshot
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		// An object to draw. Spheres keep their radius in size.x, boxes their extents, and planes keep their normal in
+		// size and their distance along it in distance
+		struct ObjectEntry
+		{
+			ShapeType shape;
+			vec3 previous;
+			vec3 current;
+			vec3 size;
+			float distance;
+			vec4 color;
+
+			// The object's alpha is alphaOffset + alpha * alphaScale, which covers its whole block of fixed steps when its
+			// level of detail skips some, see Scene::getInterpolationAlpha
+			float alphaOffset;
+			float alphaScale;
+		};
+
+		// A spring's line, drawn at the alpha of its object A like Scene::draw does
+		struct SpringEntry
+		{
+			vec3 previousA, currentA;
+			vec3 previousB, currentB;
+			float alphaOffset;
+			float alphaScale;
+		};
+
+		// A compact cloth, its particles are count entries from first in the particle arrays
+		struct ClothEntry
+		{
+			int rows;
+			int columns;
+			int first;
+			vec4 color;
+		};
+
+		// Constructor
+		RenderSnapshot();
+
+		// Empties the snapshot for taking another, keeping its arrays
+		void clear();
+
+		// Adds what is drawn, used by Scene::captureSnapshot
+		void addObject(const ObjectEntry & object) { m_objects.push_back(object); }
+		void addSpring(const SpringEntry & spring) { m_springs.push_back(spring); }
+		void addCloth(int rows, int columns, const vec4 & color);
+		void addParticle(const vec3 & previous, const vec3 & current) { m_particlePrevious.push_back(previous); m_particleCurrent.push_back(current); }
+
+		// The scene's interpolation alpha and fixed time step when the snapshot was taken, and when that was
+		void setTiming(float alpha, float fixedTimeStep, Clock::time_point time);
+
+		// The interpolation alpha to draw the snapshot with at a time after it was taken. The time since then is added to
+		// its alpha, up to the current step, so drawing keeps moving until the next snapshot is taken
+		float getAlpha(Clock::time_point now) const;
+
+		// The interpolation alpha the snapshot was taken at, for snapshots drawn a fixed time after they were taken
+		inline float getAlpha() const { return m_alpha; }
+
+		// Draws everything in the snapshot with gizmos, blended between the previous and current fixed step by alpha
+		void draw(float alpha) const;
+
+		// Getters
+		inline const vector<ObjectEntry> & getObjects() const { return m_objects; }
+		inline const vector<SpringEntry> & getSprings() const { return m_springs; }
+		inline const vector<ClothEntry> & getCloths() const { return m_cloths; }
+		inline const SnapshotStats & getStats() const { return m_stats; }
+		inline SnapshotStats & getStats() { return m_stats; }
+
+		// Bytes the snapshot's arrays hold on to
+		size_t getMemoryBytes() const;
+
+	private:
+		vector<ObjectEntry> m_objects;
+		vector<SpringEntry> m_springs;
+		vector<ClothEntry> m_cloths;
+		vector<vec3> m_particlePrevious;
+		vector<vec3> m_particleCurrent;
+
+		SnapshotStats m_stats;
+		float m_alpha;
+		float m_fixedTimeStep;
+		Clock::time_point m_time;
+	};
+}
@@ -1,87 +1,616 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 #include <glm/glm.hpp>
+#include "AABB.h"
+#include "BodyStore.h"
+#include "Cloth.h"
+#include "FrameArena.h"
+#include "Handle.h"
+#include "Integrator.h"
+#include "MemoryAccounting.h"
+#include "Pool.h"
+#include "SimulationCommand.h"
+#include "Sphere.h"
+#include "SpscQueue.h"
+#include "Spring.h"
+#include "TaskGraph.h"
 
 using glm::vec3;
 using std::vector;
 
+namespace aie {
+	class GizmoBuffer;
+}
+
 namespace Physics {
-	class Object;
-	class Spring;
+	class WorkerPool;
+	class RenderSnapshot;
+
+	// Handles the scene gives out for its objects and springs
+	typedef Handle<Object> ObjectHandle;
+	typedef Handle<Spring> SpringHandle;
+
+	// The number of simulation levels of detail, level n is stepped every 2^n fixed steps
+	const int LOD_LEVELS = 3;
+
+	// How the objects in the scene are spread over the levels of detail
+	struct LODStats
+	{
+		int objectCount[LOD_LEVELS];	// Objects simulated at each level
+		int skippedSteps;				// Object steps the coarser levels skipped during the last update
+		float timeSaved;				// Estimated milliseconds the skipped steps would have cost
+	};
 
-	// A struct to hold collisions that have been detected to be passed to the collision resolution 
-	// function to be resolved. This holds pointers to the two objects that have collided and the collision normal.
-	struct Collision 
+	// The largest time steps the scene can currently take without becoming unstable, see Scene::analyseTimeStep
+	struct TimeStepAnalysis
 	{
-		Object * objA;
-		Object * objB;
-		vec3 collisionNormal;
+		float springTimeStep;	// Largest stable explicit step for the springs, FLT_MAX when there are none
+		float rigidTimeStep;	// Largest step before the fastest object moves further than its own size, FLT_MAX when nothing moves
 	};
 
 	/*
 		The scene class handles the physics objects
+		Real is the precision the scene and everything in it are simulated at, see Precision.h
 	*/
-	class Scene
+	template <typename Real>
+	class BasicScene
 	{
 	public:
-		// Constructor
-		Scene();
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicBodyStore<Real> BodyStore;
+		typedef BasicObject<Real> Object;
+		typedef BasicSphere<Real> Sphere;
+		typedef BasicAABB<Real> AABB;
+		typedef BasicPlane<Real> Plane;
+		typedef BasicSpring<Real> Spring;
+		typedef BasicTether<Real> Tether;
+		typedef BasicCloth<Real> Cloth;
+		typedef Handle<Object> ObjectHandle;
+		typedef Handle<Spring> SpringHandle;
+		typedef BasicSimulationCommand<Real> Command;
+		typedef BasicSpawnResult<Real> SpawnResult;
+
+		// The most commands, and spawn results, that can be waiting at once
+		static const size_t COMMAND_CAPACITY = 256;
+
+		// A struct to hold collisions that have been detected to be passed to the collision resolution 
+		// function to be resolved. This holds pointers to the two objects that have collided and the collision normal.
+		struct Collision 
+		{
+			Object * objA;
+			Object * objB;
+			Vector collisionNormal;
+		};
+
+		// Constructor, the integrator policy used to step the objects is chosen here and can't be changed afterwards
+		BasicScene(IntegratorType integrator = IntegratorType::SYMPLECTIC_EULER);
 
 		// Destructor
-		~Scene();
+		~BasicScene();
 
 		void update(float deltaTime);
+
+		// Draws all objects and springs blended between the previous and current fixed step using getInterpolationAlpha.
+		// A multithreaded scene draws chunks of them on its workers into gizmo buffers of their own, which are merged in
+		// chunk order so the gizmos are added in the same order as drawing on one thread
 		void draw();
 
+		// Copies everything draw would draw into a snapshot, so it can be drawn on another thread while the scene goes on
+		// stepping. The snapshot's timing is left for the caller to set
+		void captureSnapshot(RenderSnapshot & snapshot) const;
+
 		// Getter
-		inline const vec3 & getGravity() const { return m_gravity; };
-		inline const vec3 & getGlobalForce() const { return m_globalForce; }
+		inline const Vector & getGravity() const { return m_gravity; };
+		inline const Vector & getGlobalForce() const { return m_globalForce; }
+		inline Real getFixedTimeStep() const { return m_fixedTimeStep; }
+		inline IntegratorType getIntegrator() const { return m_integrator; }
+
+		// The spring subsystem takes this many substeps for every fixed step, see setSpringTimeStep
+		inline int getSpringSubsteps() const { return m_springSubsteps; }
+		inline Real getSpringTimeStep() const { return m_fixedTimeStep / m_springSubsteps; }
+
+		// How long the last call to update took in milliseconds and how many fixed steps it ran
+		inline float getLastUpdateTime() const { return m_lastUpdateTime; }
+		inline int getLastStepCount() const { return m_lastStepCount; }
+
+		// Bytes of body state the integration of an average fixed step of the last update read and wrote, counting
+		// every spring substep. Only the hot arrays of the body store are touched, see BodyStore::HOT_BYTES_PER_BODY
+		inline size_t getBodyBytesPerStep() const { return m_lastStepCount > 0 ? m_bodySteps * BodyStore::HOT_BYTES_PER_BODY / m_lastStepCount : 0; }
+
+		// The arena the scratch memory of each fixed step is taken from, for its stats and debug mode
+		inline FrameArena & getFrameArena() { return m_frameArena; }
+
+		// Heap allocations made during the last update, only counted when PHYSICS_TRACK_ALLOCATIONS is defined
+		inline int getLastUpdateAllocations() const { return m_lastUpdateAllocations; }
+
+		// With the guard on, an update that allocates is counted and, if assertOnFailure is set, fails an assert. It is meant
+		// to be turned on once a scene has warmed up, after which stepping shouldn't allocate unless objects or springs are
+		// added or removed. Checks that report how many updates allocated turn the assert off so they can run to the end
+		inline void setAllocationGuard(bool enabled, bool assertOnFailure = true) { m_allocationGuard = enabled; m_allocationGuardAsserts = assertOnFailure; }
+		inline bool getAllocationGuard() const { return m_allocationGuard; }
+		inline int getAllocationGuardFailures() const { return m_allocationGuardFailures; }
+
+		// Works out the bytes each category of the scene holds on to from the capacity of its arrays and pools, keeping
+		// the peaks since the scene was created. Objects and springs not made by the create functions are counted by their
+		// pointers only, their own size is only seen by the allocation tracker
+		const MemoryReport & getMemoryReport();
+
+		// The fraction of a fixed step left over in the accumulated time, between 0 and 1
+		// Used to blend each object's previous and current position when rendering
+		inline float getInterpolationAlpha() const { return (float)(m_accumulatedTime / m_fixedTimeStep); }
+
+		// The interpolation alpha for a single object, which depends on how often its level of detail is stepped
+		float getInterpolationAlpha(const Object * object) const;
+
+		// Level of detail stats, updated every update
+		inline const LODStats & getLODStats() const { return m_lodStats; }
 
 		// Setter
-		inline void setGravity(const vec3& gravity) { m_gravity = gravity; }
-		inline void setGlobalForce(const vec3 & gForce) { m_globalForce = gForce; }
+		inline void setGravity(const Vector& gravity) { m_gravity = gravity; }
+		inline void setGlobalForce(const Vector & gForce) { m_globalForce = gForce; }
+		void setFixedTimeStep(Real timeStep);
+
+		// Objects connected by springs are stepped at their own, higher rate so stiff springs stay stable
+		// without forcing every other object to the same rate. The spring step is rounded down so that a whole
+		// number of spring substeps fit into each fixed step, where contacts and external forces are exchanged
+		void setSpringTimeStep(Real timeStep);
+
+		// Works out the largest stable time steps for the current springs and object velocities.
+		// The spring bound uses each object's total spring stiffness, damping and mass and the integrator's
+		// stability limit, the rigid bound stops the fastest objects moving further than their size in one step
+		TimeStepAnalysis analyseTimeStep() const;
+
+		// In auto mode the scene picks the largest safe fixed and spring time steps itself before every update,
+		// scaled down by the safety factor and kept within the time step limits
+		void setAutoTimeStep(bool enabled, Real safetyFactor = Real(0.5));
+		inline bool getAutoTimeStep() const { return m_autoTimeStep; }
+
+		// Simulation level of detail. Objects closer to the focus than the near distance are stepped every fixed step,
+		// objects up to the far distance every second step and the rest every fourth step, each with a time step that
+		// covers the steps it skipped. Objects connected by springs take the level of their closest member, and at the
+		// furthest level their detail springs are left out. Levels only change every fourth step, when all of them are in step
+		inline void setLODFocus(const Vector & focus) { m_lodFocus = focus; }
+		inline void setLODDistances(Real nearDistance, Real farDistance) { m_lodDistances[0] = nearDistance; m_lodDistances[1] = farDistance; }
+
+		// Long range attachments are generated for every island of springs with static objects in it, such as a pinned cloth.
+		// Each moving object is tethered to each pin at its shortest resting distance through the springs, times 1 + slack
+		void setLongRangeAttachments(bool enabled, Real slack = Real(0));
+		inline bool getLongRangeAttachments() const { return m_longRangeAttachments; }
+		inline int getTetherCount() const { return (int)m_tethers.size(); }
+
+		// How far the springs are stretched past their resting length, as a fraction of it
+		// Compressed springs count as zero, used to measure how well cloth holds its shape
+		Real getAverageSpringStretch() const;
+		Real getMaxSpringStretch() const;
 
-		// Add and remove object
-		void addObject(Object * object);
+		// The number of threads the parallel phases of a step (integration, forces and collision detection) are split over.
+		// Springs are reduced into each object in a fixed order, so the thread count never changes the results
+		void setThreadCount(int threadCount);
+		int getThreadCount() const;
+
+		// Each fixed step is run as a graph of tasks: the accelerations, then the rigid objects and the springs of each
+		// level, which share no objects and run at the same time, then collisions once they have all moved. Cloths don't
+		// touch the objects so their tasks overlap all of it. The graph of the last step is kept for its timings, and the
+		// scheduler stats are summed over the steps of the last update
+		inline const TaskGraph & getStepGraph() const { return m_stepGraph; }
+		inline const SchedulerStats & getSchedulerStats() const { return m_schedulerStats; }
+
+		// In deterministic mode contacts are always resolved in the same order whatever the thread count and timing,
+		// and a hash of every object's state is computed after each step so runs can be compared across machines
+		inline void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+		inline bool getDeterministic() const { return m_deterministic; }
+
+		// 64 bit hash of the positions and velocities of all objects after the last step, only updated in deterministic mode
+		inline uint64_t getStateHash() const { return m_stateHash; }
+
+		// With the symplectic Euler integrator, the spring substeps of each level are run back to back by a fused kernel
+		// over a packed copy of the objects and springs, which is only copied back once they are all done
+		inline void setFusedSpringKernel(bool enabled) { m_fusedSpringKernel = enabled; }
+		inline bool getFusedSpringKernel() const { return m_fusedSpringKernel; }
+
+		// The smallest and largest fixed time step auto mode will choose
+		inline void setTimeStepLimits(Real minTimeStep, Real maxTimeStep) { m_minTimeStep = minTimeStep; m_maxTimeStep = maxTimeStep; }
+
+		// Add and remove object. The scene owns the objects added to it, removing one deletes it along with the springs
+		// attached to it. Adds and removes are recorded in a queue and applied together by applyCommands, which update
+		// calls before the first fixed step and after each one, so they are safe to call at any time, even from inside a step.
+		// Removing by pointer looks the object up under the same lock applyCommands takes, so it is just as safe.
+		// The handle of an added object resolves once it has been applied, and handles of removed objects stop resolving
+		ObjectHandle addObject(Object * object);
+		void removeObject(ObjectHandle handle);
 		void removeObject(Object * object);
 
-		// Add and remove spring
-		void addSpring(Spring * spring);
+		// Add or remove many objects at once, recording them under a single lock. Handles, if given, receives a handle for
+		// each object added
+		void addObjects(Object * const * objects, size_t count, ObjectHandle * handles = nullptr);
+		void removeObjects(const ObjectHandle * handles, size_t count);
+
+		// The object a handle names, or null if it has been removed or not applied yet
+		Object * getObject(ObjectHandle handle) const;
+
+		// The objects and springs that have been applied, in the order they are stepped in
+		inline const vector<Object *> & getObjects() const { return m_objects; }
+		inline const vector<Spring *> & getSprings() const { return m_springs; }
+
+		// The handle of an object in the scene or waiting to be added to it, safe to call during a step
+		ObjectHandle getHandle(Object * object) const;
+
+		// Create spheres, boxes and springs in the scene's pools and add them to the scene
+		// Each type is kept together in its own blocks and the slots of removed ones are reused
+		Sphere * createSphere(Vector position, Real radius, Real mass, vec4 color, bool isStatic);
+		AABB * createAABB(Vector position, Vector halfExtent, Real mass, vec4 color, bool isStatic);
+		Spring * createSpring(Object * objA, Object * objB, Real restingLength, Real springCoefficient, Real damping);
+
+		// Add and remove spring, queued the same way as objects. Springs added with their objects are applied after them
+		SpringHandle addSpring(Spring * spring);
+		void removeSpring(SpringHandle handle);
 		void removeSpring(Spring * spring);
 
+		// Change the settings of a spring. Levels are stepped from arrays of their springs' settings that are only filled when
+		// the levels are rebuilt, so a spring in the scene is changed through these, between updates, to keep them current
+		void setSpringCoefficient(Spring * spring, Real springCoefficient);
+		void setRestingLength(Spring * spring, Real restingLength);
+
+		// Change the mass or friction of an object. The stable spring step depends on both, so an object in the scene is
+		// changed through these, between updates, for the step to follow
+		void setMass(Object * object, Real mass);
+		void setFriction(Object * object, Real friction);
+
+		// The spring a handle names, or null if it has been removed or not applied yet
+		Spring * getSpring(SpringHandle handle) const;
+
+		// Add and remove compact cloths, queued the same way as objects. The scene owns the cloths added to it
+		void addCloth(Cloth * cloth);
+		void removeCloth(Cloth * cloth);
+		inline const vector<Cloth *> & getCloths() const { return m_cloths; }
+
+		// Applies the queued adds, then the queued removes. All the removed objects and springs are taken out of the
+		// scene's arrays and body store in a single compaction pass, which keeps the order of the rest
+		void applyCommands();
+
+		// The number of adds and removes waiting for applyCommands
+		int getQueuedCommandCount() const;
+
+		// Sends a command to be applied at the start of the next fixed step, false if the command queue is full.
+		// The queue is a lock-free ring with a single producer, so only one thread may push commands and take spawn
+		// results, but it doesn't have to be the thread that updates the scene
+		bool pushCommand(const Command & command);
+
+		// Takes the handle of the next object made by a spawn command, false if there are none. Results that aren't taken
+		// are dropped once COMMAND_CAPACITY of them are waiting
+		bool popSpawnResult(SpawnResult & result);
+
+		// What the commands applied during the last update waited for
+		inline const CommandStats & getCommandStats() const { return m_commandStats; }
+
 		// Applies global force by applying the global force to all objects in the scene
 		void applyGlobalForce();
 
+		// Sum of the kinetic, gravitational and spring energy in the scene, used to measure integrator drift
+		Real getTotalEnergy() const;
+
 	protected:
 		// This vector will hold all the objects within the scene
+		// It is kept in the same order as the bodies in m_bodies, so an object's index here is its body's index
 		vector<Object *> m_objects;
 
-		// This vector will be populated with collisions that have happened to be resolved
-		vector<Collision> m_collisions;
+		// Handles of the objects and springs, and the springs attached to each object in the same order as m_objects
+		HandleMap<Object> m_objectHandles;
+		HandleMap<Spring> m_springHandles;
+		vector<vector<SpringHandle>> m_objectSprings;
+
+		// Springs applied before both of their objects were, attached to each object as it is applied
+		vector<SpringHandle> m_unattachedSprings;
+
+		// Pools for the objects and springs made with the create functions, and whether each object and spring, in the
+		// same order as m_objects and m_springs, came from one so it is given back to it rather than deleted
+		Pool<Sphere> m_spherePool;
+		Pool<AABB> m_aabbPool;
+		Pool<Spring> m_springPool;
+		vector<bool> m_pooledObjects;
+		vector<bool> m_pooledSprings;
+
+		// Adds and removes waiting to be applied. Objects and springs waiting to be added keep the handle reserved for them
+		// and whether they came from a pool. Recording is guarded by the mutex so any thread can do it
+		struct QueuedObject
+		{
+			Object * object;
+			ObjectHandle handle;
+			bool pooled;
+		};
+		struct QueuedSpring
+		{
+			Spring * spring;
+			SpringHandle handle;
+			bool pooled;
+		};
+		vector<QueuedObject> m_queuedObjects;
+		vector<QueuedSpring> m_queuedSprings;
+		vector<ObjectHandle> m_queuedObjectRemoves;
+		vector<SpringHandle> m_queuedSpringRemoves;
+		vector<Cloth *> m_queuedCloths;
+		vector<Cloth *> m_queuedClothRemoves;
+		mutable std::mutex m_commandMutex;
+
+		// Commands waiting for the next fixed step and the handles of the objects spawned by them, see pushCommand
+		SpscQueue<Command, COMMAND_CAPACITY> m_commandQueue;
+		SpscQueue<SpawnResult, COMMAND_CAPACITY> m_spawnResults;
+		std::atomic<int> m_droppedCommands;		// Counted by the thread pushing them
+		int m_droppedSpawnResults;				// Counted by the thread stepping the scene
+		CommandStats m_commandStats;
+
+		// Which objects and springs, in the same order as m_objects and m_springs, are removed by the current compaction
+		vector<bool> m_removedObjects;
+		vector<bool> m_removedSprings;
+
+		// The state of the objects' bodies, the objects are views into it while they are in the scene
+		BodyStore m_bodies;
+
+		// Scratch memory of the current fixed step, such as the collisions found and the spring forces, reset after each step
+		FrameArena m_frameArena;
 
 		// A vector to hold all the springs in the scene
 		vector<Spring *> m_springs;
 
+		// The compact cloths, stepped on their own after the objects each fixed step
+		vector<Cloth *> m_cloths;
+
+		// Objects connected to each other by springs, which are stepped together with the springs
+		struct Island
+		{
+			vector<Object *> objects;
+			vector<Spring *> springs;
+			vector<Tether *> tethers;
+			int lodLevel;
+			bool relaxing;		// Whether any of its springs still has a resting length offset from being restored
+		};
+
+		// The objects split by the rate they are stepped at, objects attached to a spring are stepped with their island
+		vector<Object *> m_rigidObjects;
+		vector<Island> m_islands;
+
+		// The springs attached to each object of a level, so each object can sum its spring forces in a fixed order.
+		// The springs of object i are entries offsets[i] to offsets[i + 1], each entry is the spring's index in the level
+		// times two, plus one if the object is the spring's object B
+		struct SpringAdjacency
+		{
+			vector<int> offsets;
+			vector<int> entries;
+		};
+
+		// What is stepped at each level of detail
+		vector<Object *> m_lodRigidObjects[LOD_LEVELS];
+		vector<Object *> m_lodSpringObjects[LOD_LEVELS];
+		vector<int> m_lodRigidBodies[LOD_LEVELS];		// The bodies of the objects above, which the integrators step
+		vector<int> m_lodSpringBodies[LOD_LEVELS];
+		vector<Spring *> m_lodSprings[LOD_LEVELS];
+		vector<Tether *> m_lodTethers[LOD_LEVELS];
+		SpringAdjacency m_lodSpringAdjacency[LOD_LEVELS];
+
+		// Scratch for building the adjacency, kept so rebuilding the levels doesn't allocate once they have been built
+		vector<int> m_levelIndex;		// Each body's index in the level being built
+		vector<int> m_adjacencyFilled;	// Entries filled in so far for each object
+
+		// The springs of a level as arrays for the spring kernel, sorted by the first of their objects in the level so the
+		// kernel reads the objects roughly in order. The indices and settings are filled when the level is rebuilt, after
+		// which a spring's settings are only written again when they change, see writeSpringSettings
+		struct SpringArrays
+		{
+			vector<int> bodyA;				// Indices into the store
+			vector<int> bodyB;
+			vector<int> localA;				// Indices into the level's spring objects
+			vector<int> localB;
+			AlignedVector<Real> restingLength;	// The settings the level is stepped with, the springs' own are only read
+			AlignedVector<Real> springCoefficient;	// when the level is rebuilt and by writeSpringSettings
+			AlignedVector<Real> damping;
+
+			// The force each spring applies to its object A, taken from the frame arena for each step
+			Real * forceX = nullptr;
+			Real * forceY = nullptr;
+			Real * forceZ = nullptr;
+		};
+		SpringArrays m_lodSpringArrays[LOD_LEVELS];
+		vector<int> m_springOrder;			// Scratch for sorting the springs of a level
+		vector<Spring *> m_sortedSprings;
+
+		// Packed state of a level's objects and tethers for the fused spring kernel. The tether indices are into the level's
+		// spring objects and are built with the level, the rest is copied in for each step
+		struct FusedSprings
+		{
+			AlignedVector<Real> positionX, positionY, positionZ;
+			AlignedVector<Real> velocityX, velocityY, velocityZ;
+			vector<Real> inverseMass;		// Zero for static objects
+			vector<Real> friction;
+			vector<int> tetherAnchor;
+			vector<int> tetherObject;
+			vector<Real> tetherMaxDistance;
+
+			inline Vector getPosition(int i) const { return Vector(positionX[i], positionY[i], positionZ[i]); }
+			inline Vector getVelocity(int i) const { return Vector(velocityX[i], velocityY[i], velocityZ[i]); }
+			inline void setPosition(int i, const Vector & position) { positionX[i] = position.x; positionY[i] = position.y; positionZ[i] = position.z; }
+			inline void setVelocity(int i, const Vector & velocity) { velocityX[i] = velocity.x; velocityY[i] = velocity.y; velocityZ[i] = velocity.z; }
+		};
+		FusedSprings m_lodFusedSprings[LOD_LEVELS];
+		bool m_fusedSpringKernel;
+
+		// Threads for the parallel phases, null when the scene is single threaded
+		WorkerPool * m_workers;
+
+		// A gizmo buffer for each chunk drawn in parallel, made as draw first needs them
+		vector<aie::GizmoBuffer *> m_gizmoBuffers;
+
+		// The tasks of the current fixed step, rebuilt every step, and the stats of the last update's steps
+		TaskGraph m_stepGraph;
+		SchedulerStats m_schedulerStats;
+
+		// Deterministic mode and the hash of the last step
+		bool m_deterministic;
+		uint64_t m_stateHash;
+
+		// The generated long range attachments, regenerated when springs or objects are removed or springs are added
+		vector<Tether *> m_tethers;
+		bool m_tethersDirty;
+		bool m_longRangeAttachments;
+		Real m_tetherSlack;
+
+		// Level of detail settings and stats
+		Vector m_lodFocus;
+		Real m_lodDistances[LOD_LEVELS - 1];
+		LODStats m_lodStats;
+
+		// Seconds for a restored detail spring's resting length offset to shrink by a factor of e
+		Real m_restingLengthRelaxTime;
+
+		// The number of fixed steps taken so far, used to decide which levels of detail step
+		unsigned int m_stepIndex;
+
+		// Object steps taken and time spent integrating in the current update, used to estimate the time saved by levels of detail
+		int m_objectSteps;
+
+		// Bodies integrated in the current update, counting each spring substep
+		int m_bodySteps;
+		float m_integrateTime;
+
+		// Set when objects or springs are added or removed so the split above is rebuilt before the next step
+		bool m_subsystemsDirty;
+
 		// A vector that determines the strength and direction of gravity
-		vec3 m_gravity;
+		Vector m_gravity;
 
 		// Global force applies to all object in the scene
-		vec3 m_globalForce;
+		Vector m_globalForce;
 
-		// This float determines what increments the updates happen in
-		float m_fixedTimeStep;
+		// This determines what increments the updates happen in
+		Real m_fixedTimeStep;
 
 		// Accumulated time is increased by delta time each update
-		float m_accumulatedTime;
+		Real m_accumulatedTime;
+
+		// The spring time step requested with setSpringTimeStep and the number of substeps it works out to
+		Real m_requestedSpringTimeStep;
+		int m_springSubsteps;
+
+		// Auto time step settings
+		bool m_autoTimeStep;
+		Real m_safetyFactor;
+		Real m_minTimeStep;
+		Real m_maxTimeStep;
+
+		// The spring bound only changes when springs or objects do, so it is cached for auto mode
+		Real m_springTimeStepBound;
+
+		// Stability limit of the integrator, see SymplecticEuler::stabilityLimit
+		Real m_stabilityLimit;
+
+		// Stats from the last update
+		float m_lastUpdateTime;
+		int m_lastStepCount;
+		int m_lastUpdateAllocations;
+
+		// Allocation guard and the number of updates it caught allocating
+		bool m_allocationGuard;
+		bool m_allocationGuardAsserts;
+		int m_allocationGuardFailures;
+
+		// Filled in by getMemoryReport
+		MemoryReport m_memoryReport;
+
+		// The integrator policy the scene was constructed with
+		IntegratorType m_integrator;
+
+		// Start of step state kept for the integrators that need it, one for each task that can run at the same time
+		IntegratorScratch<Real> m_lodRigidScratch[LOD_LEVELS];
+		IntegratorScratch<Real> m_lodSpringScratch[LOD_LEVELS];
 	private:
-		// This function applies gravity as a force to all objects
-		void applyGravity();
+		// Records an object or spring to add, the lock must be held
+		ObjectHandle queueObject(Object * object, bool pooled);
+		SpringHandle queueSpring(Spring * spring, bool pooled);
+
+		// Applies the commands in the command queue in the order they were sent, true if there were any
+		bool applyQueuedCommands();
+
+		// Rebuilds the subsystems and the spring bound if objects or springs have changed since they were built
+		void refreshSubsystems();
+
+		// Deletes an object or spring, or gives it back to its pool if it came from one
+		void destroyObject(Object * object, bool pooled);
+		void destroySpring(Spring * spring, bool pooled);
+
+		// Points at the addIntegrationTasks instantiation for m_integrator so the choice is only made once
+		void (BasicScene::*m_addIntegrationTasks)(Real deltaTime);
+
+		// Adds the tasks that advance all objects through one fixed step using the Integrator policy to the step graph
+		template <typename Integrator>
+		void addIntegrationTasks(Real deltaTime);
+
+		// Steps the rigid objects of a level once, and the objects attached to springs in substeps
+		template <typename Integrator>
+		void stepRigidObjects(int level, Real deltaTime);
+		template <typename Integrator>
+		void stepSprings(int level, Real deltaTime, int substeps);
+
+		// Accumulates gravity and friction into the acceleration of the objects, and the forces of the springs if there are any
+		void computeForces(const vector<int> & bodies, const SpringArrays * springs, const SpringAdjacency * adjacency);
+
+		// Runs the spring substeps of a level with symplectic Euler over its packed state, gravity, friction, spring forces
+		// and integration are done in one pass over the objects per substep
+		void stepSpringsFused(int level, Real deltaTime, int substeps);
+
+		// Calls body(begin, end) over ranges covering 0 to count, split over the worker threads in fixed size chunks
+		template <typename Body>
+		void parallelFor(size_t count, Body body);
+
+		// Hashes the positions and velocities of every object into m_stateHash
+		void computeStateHash();
+
+		// This function applies gravity as a force to the objects
+		void applyGravity(const vector<int> & bodies);
+
+		// Rebuilds m_rigidObjects and m_islands from the springs' endpoints
+		void updateSubsystems();
+
+		// Creates the long range attachments for every island that has static objects in it
+		void generateTethers();
+
+		// Moves objects and islands between levels of detail by their distance to the focus
+		void assignLOD();
+
+		// Fills the per level lists from the objects' and islands' levels
+		void rebuildLODLists();
+
+		// getHandle for callers that already hold m_commandMutex
+		ObjectHandle findHandle(Object * object) const;
+
+		// Copies a spring's settings into its level's arrays, if it is stepped
+		void writeSpringSettings(const Spring * spring);
+
+		// Attaches a spring to those of its objects that are in the scene and not yet attached, returns whether both are
+		bool attachSpring(SpringHandle handle, Spring * spring);
+
+		// Brings back an island's detail springs without adding energy to it
+		void restoreDetailSprings(Island & island);
+
+		// Moves the resting lengths offset by restoreDetailSprings back towards the ones the springs were given
+		void relaxRestingLengths(Real deltaTime);
+
+		// The number of spring substeps an island at the level takes each time it is stepped
+		int getSpringSubsteps(int level) const;
+
+		// The two halves of analyseTimeStep
+		Real computeSpringTimeStepBound() const;
+		Real computeRigidTimeStepBound() const;
+
+		// Sets the fixed and spring time steps from the bounds when auto mode is on
+		void applyAutoTimeStep();
 
-		// Checks collisions between all objects and populates the m_collisions vector
-		void checkCollision();
+		// Checks collisions between all objects and populates the collisions vector
+		void checkCollision(ArenaVector<Collision> & collisions);
 
-		// Resolves all collisions in the m_collisions vector
-		void resolveCollision();
+		// Resolves all collisions in the collisions vector
+		void resolveCollision(const ArenaVector<Collision> & collisions);
 	};
 }
 
@@ -0,0 +1,72 @@
+#pragma once
+#include "Handle.h"
+#include "Object.h"
+#include "Precision.h"
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+using glm::vec4;
+/*
+	Changes to a scene sent as values, so the thread handling input doesn't have to be the one stepping the scene.
+	Commands are pushed onto the scene's command queue, a lock-free ring with one producer, and applied in the order they
+	were sent at the start of the next fixed step, see Scene::pushCommand. Each is stamped with the time it was sent,
+	which stays with it so the scene can tell how long commands waited and report it with the spawned objects.
+	Commands are plain values with no pointers to anything the sender owns, so they can be copied into the ring.
+*/
+namespace Physics
+{
+	enum class CommandType { SPAWN, REMOVE, APPLY_IMPULSE, SET_GLOBAL_FORCE };
+
+	template <typename Real>
+	struct BasicSimulationCommand
+	{
+		typedef glm::tvec3<Real> Vector;
+		typedef std::chrono::steady_clock Clock;
+
+		CommandType type;
+		Clock::time_point time;			// When the command was sent
+
+		// Spawn: a sphere, taking its radius from size.x, or a box, taking its extents from size, created in the scene's
+		// pools with value as its velocity. The id is handed back with the handle of the object, see Scene::popSpawnResult
+		ShapeType shape;
+		uint32_t id;
+		Vector position;
+		Vector size;
+		Real mass;
+		vec4 color;
+
+		// Remove and apply impulse: the object they act on, which can be one spawned by an earlier command once its
+		// handle has come back. Commands for objects that have since been removed do nothing
+		Handle<BasicObject<Real>> target;
+
+		// The velocity of a spawn, the impulse to apply or the global force to set
+		Vector value;
+
+		// Make commands stamped with the current time
+		static BasicSimulationCommand spawnSphere(uint32_t id, const Vector & position, const Vector & velocity, Real radius, Real mass, const vec4 & color);
+		static BasicSimulationCommand spawnAABB(uint32_t id, const Vector & position, const Vector & velocity, const Vector & extents, Real mass, const vec4 & color);
+		static BasicSimulationCommand remove(Handle<BasicObject<Real>> target);
+		static BasicSimulationCommand applyImpulse(Handle<BasicObject<Real>> target, const Vector & impulse);
+		static BasicSimulationCommand setGlobalForce(const Vector & force);
+	};
+
+	// The handle of an object made by a spawn command, with the id it was sent with and when it was sent and applied
+	template <typename Real>
+	struct BasicSpawnResult
+	{
+		uint32_t id;
+		Handle<BasicObject<Real>> handle;
+		typename BasicSimulationCommand<Real>::Clock::time_point time;
+		unsigned int stepIndex;			// The fixed step the spawn was applied at the start of
+	};
+
+	// What the commands applied during the last update waited for, from being sent to the start of their fixed step
+	struct CommandStats
+	{
+		int appliedCount;
+		int droppedCount;		// Commands refused because the queue was full, since the scene was created
+		int droppedResultCount;	// Spawn results lost because the sender wasn't taking them, since the scene was created
+		float averageLatency;	// Milliseconds
+		float maxLatency;
+	};
+}
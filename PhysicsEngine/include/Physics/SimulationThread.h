@@ -0,0 +1,65 @@
+#pragma once
+#include "Precision.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <thread>
+#include <glm/glm.hpp>
+/*
+	Steps a scene on a thread of its own at the scene's fixed rate, so drawing and stepping don't hold each other up.
+	After every update that ran a fixed step the thread takes a render snapshot of the scene and publishes it through a
+	triple buffer, and the render thread draws the latest one without locking, see RenderSnapshot and TripleBuffer.
+	While the thread is running it is the only one that may touch the scene, apart from sending it commands and taking
+	spawn results, which go through the scene's lock-free command queue, see Scene::pushCommand. The level of detail focus
+	is set through another triple buffer and picked up at the start of the thread's next update. There must be only one
+	thread sending commands and setting the focus, and one drawing.
+*/
+namespace Physics
+{
+	template <typename Real>
+	class BasicSimulationThread
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicScene<Real> Scene;
+
+		// The longest time a single update covers, a thread that falls further behind than this drops the rest
+		// rather than trying to catch up all at once
+		static const float MAX_UPDATE_TIME;
+
+		// Constructor, the scene isn't owned and must outlive the thread
+		BasicSimulationThread(Scene * scene);
+
+		// Destructor, stops the thread
+		~BasicSimulationThread();
+
+		// Starts and stops stepping. Starting publishes a snapshot of the scene straight away so there is always one to
+		// draw, stopping waits for the update in progress to finish, after which the scene can be used directly again
+		void start();
+		void stop();
+		inline bool isRunning() const { return m_thread.joinable(); }
+
+		// The point the scene's levels of detail are measured from
+		void setLODFocus(const Vector & focus);
+
+		// The latest published snapshot, which stays valid and unchanged until the next call
+		inline const RenderSnapshot & acquireSnapshot() { return m_snapshots.acquire(); }
+
+		// The scene being stepped, only to be used for commands while the thread is running
+		inline Scene * getScene() const { return m_scene; }
+
+	private:
+		// The loop the thread runs until it is stopped
+		void run();
+
+		// Takes a snapshot of the scene into the write buffer and publishes it
+		void publishSnapshot(RenderSnapshot::Clock::time_point time);
+
+		Scene * m_scene;
+		std::thread m_thread;
+		std::atomic<bool> m_running;
+
+		TripleBuffer<Vector> m_lodFocus;
+		TripleBuffer<RenderSnapshot> m_snapshots;
+	};
+}
@@ -5,26 +5,29 @@ using glm::vec3;
 using glm::vec4;
 namespace Physics
 {
-	class Sphere : public Object
+	template <typename Real>
+	class BasicSphere : public BasicObject<Real>
 	{
 	public:
-		// Constructor
-		Sphere(vec3 position, float radius, float mass, vec4 color, bool isStatic);
+		typedef typename BasicObject<Real>::Vector Vector;
+		typedef typename BasicObject<Real>::BodyStore BodyStore;
+
+		// Constructor, bodies is the store to add the body to, see Object
+		BasicSphere(Vector position, Real radius, Real mass, vec4 color, bool isStatic, BodyStore * bodies = nullptr);
 
 		// Destructor
-		~Sphere();
+		~BasicSphere();
 		
 		// Draws the sphere using gizmos
-		void draw();
+		void draw(float alpha);
 
 		// Getter
-		inline float getRadius() const { return m_radius; };
+		inline Real getRadius() const { return m_radius; };
 
 		// Setter
-		inline void setRadius(float radius) { m_radius = radius; }
+		inline void setRadius(Real radius) { m_radius = radius; }
 	protected:
 		// The radius of the sphere
-		float m_radius;
+		Real m_radius;
 	};
 }
-
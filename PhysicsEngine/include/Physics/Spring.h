@@ -1,25 +1,66 @@
 #pragma once
 #include "Constraint.h"
+#include <glm/glm.hpp>
+using glm::vec3;
 namespace Physics
 {
-	class Object;
-	class Spring : public Constraint
+	template <typename Real>
+	class BasicSpring : public BasicConstraint<Real>
 	{
 	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicObject<Real> Object;
+
 		// Constructor
-		Spring(Object * objA, Object * objB, float restingLength, float springCoefficient, float damping);
+		BasicSpring(Object * objA, Object * objB, Real restingLength, Real springCoefficient, Real damping);
 
 		// Destructor
-		~Spring();
+		~BasicSpring();
+
+		// Update and draw, alpha blends the endpoints between the previous and current fixed step
+		void update(Real deltaTime);
+
+		// The force the spring applies to object A, object B receives the opposite
+		// Doesn't change either object so springs can be evaluated in parallel
+		Vector computeForce() const;
+
+		void draw(float alpha);
+
+		// Energy stored in the spring by being stretched or compressed from its resting length
+		Real getPotentialEnergy() const;
+
+		// Getters, the resting length is the one the spring was given, the effective one adds the scene's temporary offset
+		inline Real getRestingLength() const { return m_restingLength; }
+		inline Real getRestingLengthOffset() const { return m_restingLengthOffset; }
+		inline Real getEffectiveRestingLength() const { return m_restingLength + m_restingLengthOffset; }
+		inline Real getSpringCoefficient() const { return m_springCoefficient; }
+		inline Real getDamping() const { return m_damping; }
+		inline bool getIsDetail() const { return m_isDetail; }
+
+		// Setters, a scene steps its springs from its own arrays of their settings, so springs that have been added to one are
+		// changed through it, see Scene::setSpringCoefficient
+		inline void setRestingLength(Real restingLength) { m_restingLength = restingLength; }
+		inline void setSpringCoefficient(Real springCoefficient) { m_springCoefficient = springCoefficient; }
+
+		// The scene offsets the resting length while restoring detail springs and relaxes the offset back to 0 afterwards
+		inline void setRestingLengthOffset(Real offset) { m_restingLengthOffset = offset; }
+
+		// Detail springs, such as the shear springs of a cloth, are dropped when the scene simulates them at the lowest level of detail
+		inline void setIsDetail(bool isDetail) { m_isDetail = isDetail; }
 
-		// Update and draw
-		void update(float deltaTime);
-		void draw();
+		// The level of detail the scene steps the spring at and its index in that level's arrays, -1 if it isn't stepped
+		inline int getLODLevel() const { return m_lodLevel; }
+		inline int getLODIndex() const { return m_lodIndex; }
+		inline void setLODSlot(int level, int index) { m_lodLevel = level; m_lodIndex = index; }
 
 	protected:
-		float m_restingLength;		// At this length, the spring doesn't apply force
-		float m_springCoefficient;	// How strongly the spring will try return to resting length
-		float m_damping;			// Internal spring friction
+		Real m_restingLength;		// At this length, the spring doesn't apply force
+		Real m_restingLengthOffset = Real(0);	// Added to the resting length until the scene has relaxed it away
+		Real m_springCoefficient;	// How strongly the spring will try return to resting length
+		Real m_damping;			// Internal spring friction
+		bool m_isDetail = false;	// Whether the spring can be left out of far away cloth
+		int m_lodLevel = -1;		// Where the scene keeps the spring's settings
+		int m_lodIndex = -1;
 	};
 }
 
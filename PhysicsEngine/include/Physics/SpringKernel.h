@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+/*
+	The spring force kernel, shared by the scene's spring steps.
+	Springs are given as arrays: the indices of the two bodies each spring connects, then its resting length, spring
+	coefficient and damping. Body state is read through the indices from one array per axis. The kernel writes the force
+	each spring applies to its body A into force arrays in spring order, body B's force is the opposite. Adding the forces
+	up for each body is left to the caller, so it can be done in a fixed order.
+	Float is worked out four springs at a time with SSE where the target has it. The operations are the same as the scalar
+	loop and Spring::computeForce and in the same order, so the forces match them exactly. Double uses the scalar loop.
+*/
+namespace Physics
+{
+	template <typename Real>
+	struct SpringBatch
+	{
+		// The springs
+		const int * bodyA;
+		const int * bodyB;
+		const Real * restingLength;
+		const Real * springCoefficient;
+		const Real * damping;
+
+		// The bodies the indices refer to
+		const Real * positionX;
+		const Real * positionY;
+		const Real * positionZ;
+		const Real * velocityX;
+		const Real * velocityY;
+		const Real * velocityZ;
+
+		// The force of each spring on its body A, written by the kernel
+		Real * forceX;
+		Real * forceY;
+		Real * forceZ;
+	};
+
+	// Works out the forces of springs begin to end of the batch
+	template <typename Real>
+	void computeSpringForces(const SpringBatch<Real> & batch, size_t begin, size_t end);
+
+	// The same one spring at a time, what the kernel falls back to without SIMD
+	template <typename Real>
+	void computeSpringForcesScalar(const SpringBatch<Real> & batch, size_t begin, size_t end);
+
+	// Whether computeSpringForces uses SIMD for this precision on this target
+	template <typename Real>
+	bool isSpringKernelVectorized();
+
+	// Microbenchmark of the float kernel against the scalar loop, on the springs of a rows by columns cloth whose
+	// particles have been jittered. Times are the average milliseconds to work out every spring's force once
+	struct SpringKernelBenchmark
+	{
+		int springCount;
+		float scalarTime;
+		float kernelTime;
+		bool vectorized;
+		bool matches;		// Whether both gave exactly the same forces
+	};
+	SpringKernelBenchmark benchmarkSpringKernel(int rows, int columns, int iterations);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+/*
+	A fixed size queue for passing values from one thread to one other thread without locks.
+	The producer only writes the tail and the consumer only writes the head, each reads the other's with acquire so the
+	value in a slot is always written before the slot is seen. Pushing to a full queue fails rather than waiting, so the
+	producer decides whether to drop the value or try again later.
+	Capacity must be a power of two, and the queue holds that many values. Nothing is allocated after construction.
+*/
+namespace Physics
+{
+	template <typename T, size_t Capacity>
+	class SpscQueue
+	{
+	public:
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Queue capacity must be a power of two");
+
+		// Constructor
+		SpscQueue() : m_head(0), m_tail(0) {}
+
+		// Adds a value to the back, false if the queue is full. Only called by the producer
+		bool push(const T & value)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_head.load(std::memory_order_acquire) == Capacity) return false;
+			m_items[tail & (Capacity - 1)] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Takes the value at the front, false if the queue is empty. Only called by the consumer
+		bool pop(T & value)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) return false;
+			value = m_items[head & (Capacity - 1)];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// The number of values waiting, only exact when neither thread is using the queue
+		inline size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		inline bool empty() const { return size() == 0; }
+		static constexpr size_t getCapacity() { return Capacity; }
+
+	private:
+		// The head and tail are padded apart so the two threads don't keep taking the same cache line from each other.
+		// Padding rather than alignas, since new doesn't over align before C++17 and queues are kept inside heap objects
+		static const size_t CACHE_LINE = 64;
+		std::atomic<size_t> m_head;		// Next slot to pop, written by the consumer
+		char m_headPadding[CACHE_LINE];
+		std::atomic<size_t> m_tail;		// Next slot to push, written by the producer
+		char m_tailPadding[CACHE_LINE];
+		T m_items[Capacity];
+	};
+}
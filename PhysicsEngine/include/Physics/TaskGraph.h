@@ -0,0 +1,124 @@
+#pragma once
+#include "WorkerPool.h"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+using std::vector;
+/*
+	A set of data-parallel tasks with declared dependencies, run by a worker pool.
+	Each task is a job split into chunks like WorkerPool::run, and only starts once every task it depends on has finished.
+	Tasks that don't depend on each other run at the same time, their chunks are spread over the threads by work stealing.
+	The graph copies the jobs it is given into its own storage, so they must be trivially copyable, such as lambdas that
+	capture this and plain values. Whatever they refer to must stay alive until the graph has run.
+	Clearing a graph keeps its storage, so a graph rebuilt every step with the same shape doesn't allocate.
+*/
+namespace Physics
+{
+	// What running a graph cost. Thread time not spent in jobs is the scheduler's overhead, along with any time threads
+	// had nothing to do because of the graph's dependencies
+	struct SchedulerStats
+	{
+		int taskCount;
+		int chunkCount;			// Chunks of the tasks and of runs started inside them
+		int stealCount;
+		int threadCount;
+		float wallTime;			// Milliseconds from the start of the run to the end of the last task
+		float jobTime;			// Milliseconds the threads spent in jobs
+
+		inline float getOverheadTime() const { return wallTime * threadCount - jobTime; }
+	};
+
+	class TaskGraph
+	{
+	public:
+		// Constructor
+		TaskGraph();
+
+		// Removes every task, keeping the storage
+		void clear();
+
+		// Adds a task that runs job(chunk, thread) for chunks 0 to chunkCount - 1 and returns its index. The name is kept
+		// by pointer for the timeline, so it should be a literal
+		template <typename Job>
+		int add(const char * name, int chunkCount, const Job & job);
+
+		// Makes a task wait for another to finish. Dependencies must point back to a task added earlier, so the order the
+		// tasks were added in is always a valid order to run them in
+		void addDependency(int before, int after);
+
+		// Runs every task and returns when they have all finished. Without a pool the tasks are run one after another in
+		// the order they were added
+		void run(WorkerPool * workers);
+
+		// Getters
+		inline int getTaskCount() const { return (int)m_tasks.size(); }
+		inline const char * getTaskName(int task) const { return m_names[task]; }
+		inline const SchedulerStats & getLastRunStats() const { return m_stats; }
+
+		// When each task of the last run started and finished, in milliseconds from the start of the run, and the thread
+		// that finished it
+		inline float getTaskStart(int task) const { return m_startTimes[task]; }
+		inline float getTaskEnd(int task) const { return m_endTimes[task]; }
+		inline int getTaskThread(int task) const { return m_threads[task]; }
+
+	private:
+		friend class WorkerPool;
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Called by the pool when a task's first chunk starts and when its last chunk has finished
+		void onTaskStarted(int task);
+		void onTaskFinished(int task, int thread);
+
+		// Where each task's job is in the storage, rounded up so every job is suitably aligned
+		static const size_t JOB_ALIGNMENT = alignof(std::max_align_t);
+		vector<WorkerPool::Task> m_tasks;
+		vector<size_t> m_jobOffsets;
+		vector<std::max_align_t> m_jobStorage;
+		vector<const char *> m_names;
+
+		// The tasks waiting for each task, as offsets into the list of waiting tasks, built when the graph is run
+		vector<int> m_dependencyBefore;
+		vector<int> m_dependencyAfter;
+		vector<int> m_dependentOffsets;
+		vector<int> m_dependents;
+
+		// Tasks of the current run that haven't finished
+		std::atomic<int> m_remainingTasks;
+
+		// Timing of the last run
+		Clock::time_point m_runStart;
+		vector<float> m_startTimes;
+		vector<float> m_endTimes;
+		vector<int> m_threads;
+		SchedulerStats m_stats;
+	};
+
+	template <typename Job>
+	int TaskGraph::add(const char * name, int chunkCount, const Job & job)
+	{
+		static_assert(std::is_trivially_copyable<Job>::value && std::is_trivially_destructible<Job>::value, "Task graph jobs are copied byte for byte");
+		static_assert(alignof(Job) <= JOB_ALIGNMENT, "Task graph jobs can't be over aligned");
+
+		// The job is copied to the end of the storage, which can move as it grows, so the task's pointer to it is only set
+		// when the graph is run
+		size_t offset = m_jobStorage.size();
+		m_jobStorage.resize(offset + (sizeof(Job) + JOB_ALIGNMENT - 1) / JOB_ALIGNMENT);
+		memcpy(&m_jobStorage[offset], &job, sizeof(Job));
+		m_jobOffsets.push_back(offset);
+
+		WorkerPool::Task task;
+		task.function = &WorkerPool::invokeJob<Job>;
+		task.job = nullptr;
+		task.chunkCount = chunkCount;
+		task.remainingChunks = 0;
+		task.graph = this;
+		task.index = (int)m_tasks.size();
+		task.pendingDependencies = 0;
+		task.started = false;
+		m_tasks.push_back(task);
+		m_names.push_back(name);
+		return task.index;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Constraint.h"
+#include <glm/glm.hpp>
+/*
+	A long range attachment, a one sided constraint that stops an object getting further than a maximum distance from an anchor.
+	The scene generates these from every object of a pinned cloth to each of its pins, so stretch doesn't have to travel
+	through every spring in between before the cloth stops sagging.
+*/
+namespace Physics
+{
+	template <typename Real>
+	class BasicTether : public BasicConstraint<Real>
+	{
+	public:
+		typedef glm::tvec3<Real> Vector;
+		typedef BasicObject<Real> Object;
+
+		// Constructor, objA is the anchor and objB the object kept within maxDistance of it
+		BasicTether(Object * anchor, Object * object, Real maxDistance);
+
+		// Destructor
+		~BasicTether();
+
+		// Projects the object back onto the sphere around the anchor and removes its velocity away from the anchor
+		// Does nothing while the object is within the maximum distance
+		void apply();
+
+		// Getter
+		inline Real getMaxDistance() const { return m_maxDistance; }
+
+	protected:
+		Real m_maxDistance;		// The furthest the object can be from the anchor
+	};
+}
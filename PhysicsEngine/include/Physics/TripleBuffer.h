@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+/*
+	Three copies of a value for handing the latest version of it from one thread to another without locks.
+	The writer fills its buffer and publishes it, which swaps it with the middle buffer. The reader acquires, which swaps
+	its buffer with the middle one if something newer was published since its last acquire. The writer and reader never
+	hold the same buffer, so the reader can keep using what it acquired until its next acquire while the writer goes on
+	writing, and neither ever waits for the other. Versions the reader didn't get to in time are skipped.
+	The buffers are reused, so a value that keeps its capacity, such as a vector, stops allocating once it has grown.
+*/
+namespace Physics
+{
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		// Constructor
+		TripleBuffer() : m_write(0), m_middle(1), m_read(2) {}
+
+		// The buffer the writer fills, it keeps whatever was in it the last time it was the middle or read buffer
+		inline T & getWriteBuffer() { return m_buffers[m_write]; }
+
+		// Hands the write buffer to the reader and takes the middle one to write to next
+		void publish()
+		{
+			m_write = m_middle.exchange(m_write | NEW_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+
+		// Takes the latest published buffer if there is a new one, then returns the reader's buffer. Before anything has
+		// been published this is a default constructed T
+		const T & acquire()
+		{
+			if (m_middle.load(std::memory_order_relaxed) & NEW_BIT)
+			{
+				m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & INDEX_MASK;
+			}
+			return m_buffers[m_read];
+		}
+
+		// Whether the writer has published since the reader's last acquire
+		inline bool hasNew() const { return (m_middle.load(std::memory_order_relaxed) & NEW_BIT) != 0; }
+
+	private:
+		// The middle index has a bit set when it holds a buffer the reader hasn't taken yet
+		static const int INDEX_MASK = 3;
+		static const int NEW_BIT = 4;
+
+		T m_buffers[3];
+		int m_write;				// Only used by the writer
+		std::atomic<int> m_middle;
+		int m_read;					// Only used by the reader
+	};
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+/*
+	A fixed set of worker threads the scene splits its parallel work over, scheduled by work stealing.
+	Work is handed out as numbered chunks, each chunk is run exactly once by one of the threads. Every thread has its own
+	deque of chunk ranges. A thread takes the newest range from the back of its own deque, splitting it in half and
+	pushing the upper half back until a single chunk is left, and threads that run out steal the oldest, largest range
+	from the front of another thread's deque.
+	Runs can be started from inside a chunk. The thread that starts one pushes its chunks onto its own deque and keeps
+	taking and stealing work until they are all done, so jobs nest without blocking a thread. Task graphs are run the same
+	way, a task's chunks are pushed once every task it depends on has finished, see TaskGraph.
+	Which thread runs a chunk depends on scheduling, so callers that need deterministic results write each chunk's output
+	to its own slot.
+*/
+namespace Physics
+{
+	class TaskGraph;
+
+	// Counters of the work the pool ran, summed over its threads
+	struct WorkerStats
+	{
+		int chunkCount;		// Chunks run
+		int stealCount;		// Ranges taken from another thread's deque
+		double jobTime;		// Milliseconds spent running jobs, not counting time a job spent waiting for a run it started
+	};
+
+	class WorkerPool
+	{
+	public:
+		typedef void (*JobFunction)(const void * job, int chunk, int thread);
+
+		// A data-parallel job being run, whose chunks are handed out as ranges
+		struct Task
+		{
+			Task() {}
+			Task(const Task & other);
+
+			JobFunction function;
+			const void * job;
+			int chunkCount;
+			std::atomic<int> remainingChunks;
+
+			// Only used by task graphs, null and zero for a plain run
+			TaskGraph * graph;
+			int index;
+			std::atomic<int> pendingDependencies;
+			std::atomic<bool> started;
+		};
+
+		// Constructor, threadCount includes the thread calling run so threadCount - 1 workers are started
+		WorkerPool(int threadCount);
+
+		// Destructor, stops and joins the workers
+		~WorkerPool();
+
+		// Runs job(chunk, thread) for every chunk from 0 to chunkCount - 1 and returns once they have all finished
+		// A thread from outside the pool takes part as thread 0, workers are numbered from 1 and keep their number when
+		// they start a run from inside a chunk
+		// The job is called through a plain function pointer rather than a std::function, so running one never allocates
+		template <typename Job>
+		inline void run(int chunkCount, const Job & job) { runJob(chunkCount, &invokeJob<Job>, &job); }
+
+		// Runs every task of a graph in an order that respects its dependencies, see TaskGraph::run
+		void run(TaskGraph & graph);
+
+		// Getters
+		inline int getThreadCount() const { return (int)m_workers.size() + 1; }
+		WorkerStats getStats() const;
+
+		// Calls a job of type Job
+		template <typename Job>
+		static void invokeJob(const void * job, int chunk, int thread) { (*(const Job *)job)(chunk, thread); }
+
+	private:
+		// A range of chunks of a task still to be run
+		struct WorkItem
+		{
+			Task * task;
+			int begin;
+			int end;
+		};
+
+		// The most ranges a deque holds. Splitting pushes one range per halving, so this is only reached by deeply nested
+		// runs, the range is run without splitting it further then
+		static const unsigned int DEQUE_CAPACITY = 256;
+
+		// A thread's deque and counters. The deque is guarded by its mutex, the counters are only written by the thread
+		struct ThreadState
+		{
+			std::mutex mutex;
+			WorkItem items[DEQUE_CAPACITY];
+			unsigned int front = 0;		// Stolen from
+			unsigned int back = 0;		// Pushed to and taken from by the thread itself
+
+			int chunkCount = 0;
+			int stealCount = 0;
+			double jobTime = 0.0;
+			double waitTime = 0.0;		// Time spent inside a job waiting for work of a run it started
+			int depth = 0;				// How many chunks the thread is nested inside
+		};
+
+		// Runs the job through the function
+		void runJob(int chunkCount, JobFunction function, const void * job);
+
+		// The pool and number a thread had before it started a run from outside this pool, which may be a worker of
+		// another pool, so they can be put back when the run ends
+		struct OutsideThread
+		{
+			const WorkerPool * pool;
+			int thread;
+		};
+
+		// Marks the start and end of a run started from outside the pool, the workers only look for work during one.
+		// Only one thread from outside may run the pool at a time, since it takes part as thread 0
+		OutsideThread beginRun();
+		void endRun(const OutsideThread & previous);
+
+		// The number of the calling thread, 0 for a thread from outside the pool
+		int getCurrentThread() const;
+
+		// Pushes a range onto the back of a thread's deque, false if it is full
+		bool push(int thread, const WorkItem & item);
+
+		// Takes a range from the back of the thread's own deque, or steals one from the front of another's
+		bool take(int thread, WorkItem & item);
+
+		// Takes and runs one range, false if there was no work anywhere
+		bool runOne(int thread);
+
+		// Runs a range, splitting off halves for other threads to steal while there is more than one chunk in it
+		void runItem(int thread, WorkItem item);
+
+		// Runs one chunk and finishes its task if it was the last
+		void runChunk(int thread, Task * task, int chunk);
+
+		// Pushes all of a task's chunks, a task without any is finished straight away
+		void pushTask(int thread, Task * task);
+
+		// Tells the graph a task has finished and pushes the tasks that were waiting for it
+		void finishTask(int thread, Task * task);
+
+		// Takes and runs work until done returns true
+		template <typename Done>
+		void runUntil(int thread, Done done);
+
+		// The loop each worker runs, sleeping between runs and taking work during them
+		void workerLoop(int thread);
+
+		vector<std::thread> m_workers;
+		ThreadState * m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_workReady;	// Signalled when a run starts or the pool is stopping
+		std::atomic<int> m_activeRuns;			// Runs started from outside the pool that haven't finished
+		bool m_stopping;
+	};
+}
@@ -1,13 +1,16 @@
 #pragma once
 
 #include "Application.h"
+#include "Physics/Handle.h"
+#include "Physics/Integrator.h"
+#include "Physics/Precision.h"
 #include <glm/mat4x4.hpp>
+#include <chrono>
+#include <cstdint>
 
 class Camera;
 namespace Physics {
-	class Scene;
-	class Sphere;
-	class Spring;
+	typedef Handle<Object> ObjectHandle;
 }
 
 
@@ -20,13 +23,92 @@ public:
 	virtual void shutdown();
 	virtual void update(float deltaTime);
 	virtual void draw();
+
+	// Steps the default scene, then the default scene with a large cloth, without opening a window, and checks that
+	// neither allocates once warmed up. Prints the results and returns whether both passed
+	bool runAllocationCheck();
+
+	// Steps an ensemble of default scenes, each with its own spring coefficient, elasticity and friction, without opening
+	// a window and prints each instance's metrics. Returns whether every instance stayed finite
+	static bool runEnsemble(int instanceCount, int steps, int threadCount);
+
+	// Steps the same scene, the default one with a large cloth, as a Scene and as a DoubleScene without opening a window
+	// and prints the time and body bytes of each. Returns whether both stayed finite
+	static bool runPrecisionBenchmark(int steps);
 protected:	
 	Camera *m_camera = nullptr;
 
+	// Creates the scene with the given integrator and fills it with the default objects, springs and cloth
+	void createScene(Physics::IntegratorType integrator);
+
+	// ImGui window showing the cost of the scene's update and how far its energy has drifted
+	// Changing the integrator here recreates the scene so integrators can be compared on the same setup
+	void drawDebugWindow();
+
+	// Starts or stops stepping the scene on its own thread. While it runs the scene is only drawn from its snapshots and
+	// the debug window only shows what they hold
+	void setSimulationThread(bool enabled);
+
+	// Starts or stops the pipelined frame, where each frame's step runs on the pipeline's thread while the frame before's
+	// snapshot is drawn, see FramePipeline. Only one of the pipeline and the simulation thread runs at a time
+	void setFramePipeline(bool enabled);
+
+	// ImGui window showing when each part of the last frame ran on the main thread and when its step ran, so the
+	// overlap of the pipelined frame can be seen
+	void drawFrameTimeline();
+
+	// ImGui window listing the memory of each category, as reported by the scene and, when it is compiled in, as
+	// counted by the allocation tracker, to size the capacities of production scenes
+	void drawMemoryWindow();
+
+	// Fills a scene of either precision with the default objects, springs and cloth and the settings they are simulated with
+	template <typename Real>
+	static void buildDefaultScene(Physics::BasicScene<Real> & scene, bool compactCloth);
+
 	// Function that creates cloth based on input parameters, spring variables have default values
-	void MakeCloth(int rows, int columns, glm::vec3 & origin,float radius = 0.1f, float springLength = 1.f, float springDiagonal = 1.4f, float springCoefficient = 10.f, float springDamping = 0.2f);
+	template <typename Real>
+	static void MakeCloth(Physics::BasicScene<Real> & scene, int rows, int columns, glm::vec3 & origin,float radius = 0.1f, float springLength = 1.f, float springDiagonal = 1.4f, float springCoefficient = 10.f, float springDamping = 0.2f);
+
+	// Steps the default scene with a large cloth at one precision for the precision benchmark and prints its times,
+	// returns whether it stayed finite
+	template <typename Real>
+	static bool runPrecisionPass(const char * precision, int steps);
 
 	Physics::Scene * m_scene = nullptr;
-	Physics::Sphere * m_sphere;
-	Physics::Spring * m_spring;
+
+	// Steps m_scene while it is running, see setSimulationThread
+	Physics::SimulationThread * m_simulationThread = nullptr;
+
+	// Steps m_scene a frame ahead of drawing while it exists, see setFramePipeline
+	Physics::FramePipeline * m_framePipeline = nullptr;
+
+	// When each part of a frame began, in the snapshot clock. A frame runs from the start of one update to the start of
+	// the next, the time after draw is ImGui, swapping the buffers and polling events
+	struct FrameTimes
+	{
+		typedef std::chrono::steady_clock::time_point TimePoint;
+		TimePoint start;		// Update
+		TimePoint draw;			// Building the frame's gizmos
+		TimePoint upload;		// Gizmos::draw uploading and drawing them
+		TimePoint present;		// Draw has returned
+		TimePoint end;
+		TimePoint stepStart;	// The step begun during the frame, which has finished by the next update when pipelined
+		TimePoint stepEnd;
+		float waitTime = 0.0f;	// Milliseconds the next frame waited for the step when pipelined
+		bool stepped = false;	// Whether the frame stepped the scene, the simulation thread steps on its own
+	};
+	FrameTimes m_frameTimes;		// The frame in progress
+	FrameTimes m_lastFrameTimes;	// The last finished frame
+	Physics::ObjectHandle m_sphere;	// The most recent sphere shot by the user
+	uint32_t m_nextSpawnId = 1;		// Sent with each spawn command to recognise the objects it spawned
+	uint32_t m_sphereSpawnId = 0;	// The spawn command of the most recent sphere, whose handle goes in m_sphere
+
+	// The global force last sent to the scene
+	glm::vec3 m_globalForce = glm::vec3(0);
+
+	// Energy of the scene when it was created, the difference to the current energy is the drift
+	float m_startEnergy = 0.0f;
+
+	// Whether the scene's cloth is a compact cloth rather than spheres and springs
+	bool m_compactCloth = false;
 };
\ No newline at end of file
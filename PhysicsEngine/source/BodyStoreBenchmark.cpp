@@ -0,0 +1,134 @@
+#include "BodyStoreBenchmark.h"
+#include "Physics/BodyStore.h"
+#include <chrono>
+using namespace Physics;
+
+// An object as it was laid out before the body store, a sphere with its shape, colour and virtual functions, which a
+// step loaded whole to reach its position and velocity
+struct LegacyBody
+{
+	virtual ~LegacyBody() {}
+
+	vec3 position;
+	vec3 previousPosition;
+	vec3 velocity;
+	vec3 acceleration;
+	int shape;
+	float mass;
+	float friction;
+	float elasticity;
+	vec4 color;
+	bool isStatic;
+	int lodLevel;
+	float radius;
+};
+
+// Steps an axis of every body in a store, streaming through its arrays. Static bodies are stepped by nothing rather than
+// skipped, so the loop has no branch and can be vectorised, and they are told apart by their inverse mass of zero so the
+// loop only reads arrays of floats. The arrays are all separate, which the compiler is told so it needn't check
+static void stepStoreAxis(float * __restrict position, float * __restrict previous, float * __restrict velocity, float * __restrict acceleration,
+	const float * __restrict inverseMass, const float * __restrict friction, float gravity, float timeStep, int bodyCount)
+{
+	for (int body = 0; body < bodyCount; body++)
+	{
+		float moving = inverseMass[body] == 0.0f ? 0.0f : 1.0f;
+		float bodyAcceleration = acceleration[body] + gravity;
+		bodyAcceleration -= velocity[body] * (friction[body] * inverseMass[body]);
+		previous[body] = position[body];
+		velocity[body] += bodyAcceleration * timeStep * moving;
+		position[body] += velocity[body] * timeStep * moving;
+		acceleration[body] = 0.0f;
+	}
+}
+
+BodyStoreBenchmark benchmarkBodyStore(int bodyCount, int steps)
+{
+	const vec3 gravity(0.0f, -9.8f, 0.0f);
+	const float timeStep = 0.01f;
+
+	// Bodies with a spread of masses and frictions, every tenth one static
+	vector<LegacyBody *> objects;
+	BodyStore store;
+	unsigned int seed = 12345;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (float)(seed >> 8) / (float)(1 << 24); };
+	for (int i = 0; i < bodyCount; i++)
+	{
+		vec3 position(random() * 100.0f, random() * 100.0f, random() * 100.0f);
+		float mass = 0.1f + random();
+		float friction = random() * 0.5f;
+		bool isStatic = i % 10 == 0;
+
+		LegacyBody * object = new LegacyBody();
+		object->position = position;
+		object->previousPosition = position;
+		object->velocity = vec3();
+		object->acceleration = vec3();
+		object->shape = 1;
+		object->mass = mass;
+		object->friction = friction;
+		object->elasticity = 1.0f;
+		object->color = vec4(1.0f);
+		object->isStatic = isStatic;
+		object->lodLevel = 0;
+		object->radius = 1.0f;
+		objects.push_back(object);
+
+		int body = store.add(nullptr, position, mass, vec4(1.0f), isStatic);
+		store.setFriction(body, friction);
+	}
+
+	// The scene's step for bodies that aren't on springs, on each layout. Friction is scaled by the inverse mass in both,
+	// which the objects work out from their mass each time and the store keeps
+	auto stepObjects = [&]()
+	{
+		for (auto object : objects)
+		{
+			object->previousPosition = object->position;
+			if (!object->isStatic)
+			{
+				object->acceleration += gravity;
+				object->acceleration -= object->velocity * (object->friction * (1.0f / object->mass));
+				object->velocity += object->acceleration * timeStep;
+				object->position += object->velocity * timeStep;
+			}
+			object->acceleration = vec3();
+		}
+	};
+	auto stepStore = [&]()
+	{
+		const float * inverseMass = store.getInverseMassArray();
+		const float * friction = store.getFrictionArray();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// Each axis is stepped on its own, so every loop streams through a few arrays
+			float * position = store.getPositionArray(axis);
+			float * previous = store.getPreviousPositionArray(axis);
+			float * velocity = store.getVelocityArray(axis);
+			float * acceleration = store.getAccelerationArray(axis);
+			stepStoreAxis(position, previous, velocity, acceleration, inverseMass, friction, gravity[axis], timeStep, bodyCount);
+		}
+	};
+	auto time = [steps](auto step)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < steps; i++)
+		{
+			step();
+		}
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+	};
+
+	BodyStoreBenchmark result;
+	result.bodyCount = bodyCount;
+	result.objectBytes = bodyCount * (sizeof(LegacyBody) + sizeof(LegacyBody *));
+	result.storeBytes = bodyCount * BodyStore::HOT_BYTES_PER_BODY;
+	result.objectTime = time(stepObjects);
+	result.storeTime = time(stepStore);
+	result.matches = true;
+	for (int i = 0; i < bodyCount; i++)
+	{
+		result.matches = result.matches && objects[i]->position == store.getPosition(i) && objects[i]->velocity == store.getVelocity(i);
+		delete objects[i];
+	}
+	return result;
+}
@@ -2,26 +2,34 @@
 #include <Gizmos.h>
 using namespace Physics;
 using glm::vec3;
-Physics::AABB::AABB(vec3  position, vec3 size, float mass, vec4 color, bool isStatic): m_extents(size), Object(ShapeType::AABB,position,mass, color, isStatic)
+template <typename Real>
+Physics::BasicAABB<Real>::BasicAABB(Vector  position, Vector size, Real mass, vec4 color, bool isStatic, BodyStore * bodies): m_extents(size), BasicObject<Real>(ShapeType::AABB,position,mass, color, isStatic, bodies)
 {
 }
 
-AABB::~AABB()
+template <typename Real>
+BasicAABB<Real>::~BasicAABB()
 {
 }
 
-void Physics::AABB::draw()
+template <typename Real>
+void Physics::BasicAABB<Real>::draw(float alpha)
 {
-	// Create a filled AABB
-	aie::Gizmos::addAABBFilled(m_position, m_extents, m_color);
+	// Create a filled AABB at the interpolated position
+	aie::Gizmos::addAABBFilled(vec3(this->getInterpolatedPosition(alpha)), vec3(m_extents), this->getColor());
 }
 
-vec3 Physics::AABB::getMin()
+template <typename Real>
+typename BasicAABB<Real>::Vector Physics::BasicAABB<Real>::getMin()
 {
-	return m_position - m_extents;
+	return this->getPosition() - m_extents;
 }
 
-vec3 Physics::AABB::getMax()
+template <typename Real>
+typename BasicAABB<Real>::Vector Physics::BasicAABB<Real>::getMax()
 {
-	return m_position + m_extents;
+	return this->getPosition() + m_extents;
 }
+
+template class Physics::BasicAABB<float>;
+template class Physics::BasicAABB<double>;
@@ -0,0 +1,86 @@
+#include "Physics/AllocationTracker.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+using namespace Physics;
+
+static std::atomic<uint64_t> s_allocationCount(0);
+static std::atomic<uint64_t> s_freeCount(0);
+
+// Tracked figures of each category
+struct CategoryCounters
+{
+	std::atomic<size_t> liveBytes;
+	std::atomic<size_t> peakBytes;
+	std::atomic<uint64_t> allocationCount;
+};
+static CategoryCounters s_categories[(int)MemoryCategory::COUNT];
+
+#ifdef PHYSICS_TRACK_ALLOCATIONS
+// Kept in front of each allocation, padded to the alignment malloc gives so the memory after it keeps that alignment
+struct alignas(alignof(std::max_align_t)) AllocationHeader
+{
+	size_t size;
+	int category;
+};
+
+// Every form of new and delete comes through these two
+void * operator new(size_t size)
+{
+	s_allocationCount++;
+	AllocationHeader * header = (AllocationHeader *)malloc(sizeof(AllocationHeader) + size);
+	if (header == nullptr) throw std::bad_alloc();
+
+	int category = (int)MemoryScope::getCurrentCategory();
+	header->size = size;
+	header->category = category;
+	CategoryCounters & counters = s_categories[category];
+	counters.allocationCount++;
+	size_t live = counters.liveBytes += size;
+	size_t peak = counters.peakBytes;
+	while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live))
+	{
+	}
+	return header + 1;
+}
+
+void operator delete(void * memory) noexcept
+{
+	if (memory == nullptr) return;
+	s_freeCount++;
+	AllocationHeader * header = (AllocationHeader *)memory - 1;
+	s_categories[header->category].liveBytes -= header->size;
+	free(header);
+}
+
+void * operator new[](size_t size) { return operator new(size); }
+void operator delete[](void * memory) noexcept { operator delete(memory); }
+void operator delete(void * memory, size_t) noexcept { operator delete(memory); }
+void operator delete[](void * memory, size_t) noexcept { operator delete(memory); }
+#endif
+
+bool Physics::AllocationTracker::isEnabled()
+{
+#ifdef PHYSICS_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t Physics::AllocationTracker::getAllocationCount()
+{
+	return s_allocationCount;
+}
+
+uint64_t Physics::AllocationTracker::getFreeCount()
+{
+	return s_freeCount;
+}
+
+MemoryUsage Physics::AllocationTracker::getUsage(MemoryCategory category)
+{
+	const CategoryCounters & counters = s_categories[(int)category];
+	return { counters.liveBytes, counters.peakBytes, counters.allocationCount };
+}
@@ -0,0 +1,175 @@
+#include "Physics/BodyStore.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/Object.h"
+using namespace Physics;
+
+// Moves the last element of an array into the given index and shrinks the array
+template <typename Array>
+static void removeAt(Array & array, int index)
+{
+	array[index] = array.back();
+	array.pop_back();
+}
+
+// Moves the elements that aren't removed to the front of an array, in order, and shrinks it
+template <typename Array>
+static void compactArray(Array & array, const vector<bool> & removed)
+{
+	size_t write = 0;
+	for (size_t i = 0; i < array.size(); i++)
+	{
+		if (!removed[i])
+		{
+			array[write++] = array[i];
+		}
+	}
+	array.resize(write);
+}
+
+template <typename Real>
+Physics::BasicBodyStore<Real>::BasicBodyStore()
+{
+}
+
+template <typename Real>
+BasicBodyStore<Real>::~BasicBodyStore()
+{
+}
+
+template <typename Real>
+int Physics::BasicBodyStore<Real>::add(Object * owner, const Vector & position, Real mass, const vec4 & color, bool isStatic)
+{
+	MemoryScope scope(MemoryCategory::BODIES);
+	m_positionX.push_back(position.x);
+	m_positionY.push_back(position.y);
+	m_positionZ.push_back(position.z);
+	m_previousX.push_back(position.x);
+	m_previousY.push_back(position.y);
+	m_previousZ.push_back(position.z);
+	m_velocityX.push_back(Real(0));
+	m_velocityY.push_back(Real(0));
+	m_velocityZ.push_back(Real(0));
+	m_accelerationX.push_back(Real(0));
+	m_accelerationY.push_back(Real(0));
+	m_accelerationZ.push_back(Real(0));
+	m_inverseMass.push_back(Real(0));
+	m_friction.push_back(Real(0.3));
+	m_isStatic.push_back(isStatic ? 1 : 0);
+	m_mass.push_back(Real(0));
+	m_elasticity.push_back(Real(1));
+	m_lodLevel.push_back(0);
+	m_color.push_back(color);
+	m_owner.push_back(owner);
+
+	// Sets the mass and inverse mass together
+	int body = size() - 1;
+	setMass(body, mass);
+	return body;
+}
+
+template <typename Real>
+int Physics::BasicBodyStore<Real>::moveFrom(BasicBodyStore & other, int index)
+{
+	// Copy the body across, then take it out of the other store
+	int body = add(other.getOwner(index), other.getPosition(index), other.getMass(index), other.getColor(index), other.getIsStatic(index));
+	m_previousX[body] = other.m_previousX[index];
+	m_previousY[body] = other.m_previousY[index];
+	m_previousZ[body] = other.m_previousZ[index];
+	setVelocity(body, other.getVelocity(index));
+	setAcceleration(body, other.getAcceleration(index));
+	setFriction(body, other.getFriction(index));
+	setElasticity(body, other.getElasticity(index));
+	setLODLevel(body, other.getLODLevel(index));
+	other.remove(index);
+	return body;
+}
+
+template <typename Real>
+void Physics::BasicBodyStore<Real>::remove(int index)
+{
+	removeAt(m_positionX, index);
+	removeAt(m_positionY, index);
+	removeAt(m_positionZ, index);
+	removeAt(m_previousX, index);
+	removeAt(m_previousY, index);
+	removeAt(m_previousZ, index);
+	removeAt(m_velocityX, index);
+	removeAt(m_velocityY, index);
+	removeAt(m_velocityZ, index);
+	removeAt(m_accelerationX, index);
+	removeAt(m_accelerationY, index);
+	removeAt(m_accelerationZ, index);
+	removeAt(m_inverseMass, index);
+	removeAt(m_friction, index);
+	removeAt(m_isStatic, index);
+	removeAt(m_mass, index);
+	removeAt(m_elasticity, index);
+	removeAt(m_lodLevel, index);
+	removeAt(m_color, index);
+	removeAt(m_owner, index);
+
+	// Tell the object of the body that was moved where it is now
+	if (index < size())
+	{
+		m_owner[index]->m_body = index;
+	}
+}
+
+template <typename Real>
+void Physics::BasicBodyStore<Real>::compact(const vector<bool> & removed)
+{
+	// Detach the objects of the removed bodies so deleting them doesn't touch the store
+	int firstRemoved = size();
+	for (int body = size() - 1; body >= 0; body--)
+	{
+		if (removed[body])
+		{
+			m_owner[body]->m_bodies = nullptr;
+			m_owner[body]->m_body = -1;
+			firstRemoved = body;
+		}
+	}
+
+	compactArray(m_positionX, removed);
+	compactArray(m_positionY, removed);
+	compactArray(m_positionZ, removed);
+	compactArray(m_previousX, removed);
+	compactArray(m_previousY, removed);
+	compactArray(m_previousZ, removed);
+	compactArray(m_velocityX, removed);
+	compactArray(m_velocityY, removed);
+	compactArray(m_velocityZ, removed);
+	compactArray(m_accelerationX, removed);
+	compactArray(m_accelerationY, removed);
+	compactArray(m_accelerationZ, removed);
+	compactArray(m_inverseMass, removed);
+	compactArray(m_friction, removed);
+	compactArray(m_isStatic, removed);
+	compactArray(m_mass, removed);
+	compactArray(m_elasticity, removed);
+	compactArray(m_lodLevel, removed);
+	compactArray(m_color, removed);
+	compactArray(m_owner, removed);
+
+	// Tell the objects that moved where they are now, the ones before the first removed body haven't moved
+	for (int body = firstRemoved; body < size(); body++)
+	{
+		m_owner[body]->m_body = body;
+	}
+}
+
+template <typename Real>
+size_t Physics::BasicBodyStore<Real>::getMemoryBytes() const
+{
+	size_t bytes = getVectorBytes(m_positionX) + getVectorBytes(m_positionY) + getVectorBytes(m_positionZ);
+	bytes += getVectorBytes(m_previousX) + getVectorBytes(m_previousY) + getVectorBytes(m_previousZ);
+	bytes += getVectorBytes(m_velocityX) + getVectorBytes(m_velocityY) + getVectorBytes(m_velocityZ);
+	bytes += getVectorBytes(m_accelerationX) + getVectorBytes(m_accelerationY) + getVectorBytes(m_accelerationZ);
+	bytes += getVectorBytes(m_inverseMass) + getVectorBytes(m_friction) + getVectorBytes(m_isStatic);
+	bytes += getVectorBytes(m_mass) + getVectorBytes(m_elasticity) + getVectorBytes(m_lodLevel);
+	bytes += getVectorBytes(m_color) + getVectorBytes(m_owner);
+	return bytes;
+}
+
+template class Physics::BasicBodyStore<float>;
+template class Physics::BasicBodyStore<double>;
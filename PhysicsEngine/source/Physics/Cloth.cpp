@@ -0,0 +1,371 @@
+#include "Physics/Cloth.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/SpringKernel.h"
+#include "Gizmos.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+using namespace Physics;
+
+template <typename Real>
+const int BasicCloth<Real>::ROW_OFFSET[DIRECTIONS] = { 0, 1, 1, 1 };
+template <typename Real>
+const int BasicCloth<Real>::COLUMN_OFFSET[DIRECTIONS] = { 1, 0, 1, -1 };
+
+// Constructor
+template <typename Real>
+Physics::BasicCloth<Real>::BasicCloth(int rows, int columns, const Vector & origin, Real spacing, Real particleMass, Real springCoefficient, Real damping, const vec4 & color, bool compactVelocity) :
+	m_rows(rows), m_columns(columns), m_particleMass(particleMass), m_inverseMass(Real(1) / particleMass), m_friction(Real(0.3)),
+	m_springCoefficient(springCoefficient), m_damping(damping), m_structuralLength(spacing), m_shearLength(spacing * std::sqrt(Real(2))),
+	m_color(color), m_compactVelocity(compactVelocity)
+{
+	assert(rows > 0 && columns > 0);
+	MemoryScope scope(MemoryCategory::CLOTHS);
+
+	// Lay the particles out on the grid, still
+	int count = rows * columns;
+	m_positionX.resize(count);
+	m_positionY.resize(count);
+	m_positionZ.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		m_positionX[i] = origin.x + (i / columns) * spacing;
+		m_positionY[i] = origin.y + (i % columns) * spacing;
+		m_positionZ[i] = origin.z;
+	}
+	m_previousX = m_positionX;
+	m_previousY = m_positionY;
+	m_previousZ = m_positionZ;
+	if (m_compactVelocity)
+	{
+		m_halfVelocityX.assign(count, glm::packHalf1x16(0.0f));
+		m_halfVelocityY.assign(count, glm::packHalf1x16(0.0f));
+		m_halfVelocityZ.assign(count, glm::packHalf1x16(0.0f));
+	}
+	else
+	{
+		m_velocityX.assign(count, Real(0));
+		m_velocityY.assign(count, Real(0));
+		m_velocityZ.assign(count, Real(0));
+	}
+
+	m_rowStructuralLength.assign(columns, m_structuralLength);
+	m_rowShearLength.assign(columns, m_shearLength);
+	m_rowSpringCoefficient.assign(columns, m_springCoefficient);
+	m_rowDamping.assign(columns, m_damping);
+	m_columnIndex.resize(2 * columns + 1);
+	for (int i = 0; i < (int)m_columnIndex.size(); i++)
+	{
+		m_columnIndex[i] = i;
+	}
+
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_springForce[direction][axis] = nullptr;
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::setPinned(int row, int column)
+{
+	int particle = row * m_columns + column;
+	if (std::find(m_pinned.begin(), m_pinned.end(), particle) != m_pinned.end()) return;
+	m_pinned.push_back(particle);
+	setVelocity(particle, Vector());
+}
+
+template <typename Real>
+typename BasicCloth<Real>::Vector Physics::BasicCloth<Real>::getVelocity(int particle) const
+{
+	if (m_compactVelocity)
+	{
+		return Vector(glm::unpackHalf1x16(m_halfVelocityX[particle]), glm::unpackHalf1x16(m_halfVelocityY[particle]), glm::unpackHalf1x16(m_halfVelocityZ[particle]));
+	}
+	return Vector(m_velocityX[particle], m_velocityY[particle], m_velocityZ[particle]);
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::setVelocity(int particle, const Vector & velocity)
+{
+	if (m_compactVelocity)
+	{
+		m_halfVelocityX[particle] = glm::packHalf1x16((float)velocity.x);
+		m_halfVelocityY[particle] = glm::packHalf1x16((float)velocity.y);
+		m_halfVelocityZ[particle] = glm::packHalf1x16((float)velocity.z);
+		return;
+	}
+	m_velocityX[particle] = velocity.x;
+	m_velocityY[particle] = velocity.y;
+	m_velocityZ[particle] = velocity.z;
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::setSpringCoefficient(Real springCoefficient)
+{
+	// The kernel reads the row's copy, which is the same length so it isn't reallocated
+	m_springCoefficient = springCoefficient;
+	m_rowSpringCoefficient.assign(m_columns, springCoefficient);
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::beginStep(FrameArena & arena)
+{
+	int count = getParticleCount();
+
+	// Keep the state from before this step so draw can blend between the two
+	std::copy(m_positionX.begin(), m_positionX.end(), m_previousX.begin());
+	std::copy(m_positionY.begin(), m_positionY.end(), m_previousY.begin());
+	std::copy(m_positionZ.begin(), m_positionZ.end(), m_previousZ.begin());
+
+	// Particles on the edges aren't the first particle of some kinds of spring. Their forces are never written, so they
+	// are zeroed once here and every particle can add the same entries up without checking which springs it has
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			Real * force = arena.allocate<Real>(count);
+			for (int row = 0; row < m_rows; row++)
+			{
+				if (row + ROW_OFFSET[direction] >= m_rows)
+				{
+					std::fill(force + row * m_columns, force + (row + 1) * m_columns, Real(0));
+				}
+				else if (COLUMN_OFFSET[direction] > 0)
+				{
+					force[row * m_columns + m_columns - 1] = Real(0);
+				}
+				else if (COLUMN_OFFSET[direction] < 0)
+				{
+					force[row * m_columns] = Real(0);
+				}
+			}
+			m_springForce[direction][axis] = force;
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::computeSpringForces(size_t begin, size_t end)
+{
+	// Compact velocities are unpacked a row at a time into this thread's scratch, along with the row above since the
+	// springs of a row reach up to the particle above and to the right. The scratch only grows with the widest cloth
+	static thread_local AlignedVector<Real> rowVelocity[3];
+	size_t count = (size_t)getParticleCount();
+	for (size_t row = begin / m_columns; row < (size_t)m_rows && row * m_columns < end; row++)
+	{
+		size_t rowStart = row * m_columns;
+		const Real * velocity[3] = { nullptr, nullptr, nullptr };
+		if (m_compactVelocity)
+		{
+			size_t rowCount = glm::min((size_t)(2 * m_columns), count - rowStart);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const uint16_t * halfVelocity = axis == 0 ? m_halfVelocityX.data() : axis == 1 ? m_halfVelocityY.data() : m_halfVelocityZ.data();
+				rowVelocity[axis].resize(2 * m_columns);
+				for (size_t i = 0; i < rowCount; i++)
+				{
+					rowVelocity[axis][i] = glm::unpackHalf1x16(halfVelocity[rowStart + i]);
+				}
+				velocity[axis] = rowVelocity[axis].data();
+			}
+		}
+		else
+		{
+			velocity[0] = m_velocityX.data() + rowStart;
+			velocity[1] = m_velocityY.data() + rowStart;
+			velocity[2] = m_velocityZ.data() + rowStart;
+		}
+
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			// The second particle of every spring of this kind is the same distance along the particles from the first
+			if (row + ROW_OFFSET[direction] >= (size_t)m_rows) continue;
+			int offset = ROW_OFFSET[direction] * m_columns + COLUMN_OFFSET[direction];
+			size_t firstColumn = (size_t)glm::max(0, -COLUMN_OFFSET[direction]);
+			size_t lastColumn = (size_t)(m_columns - glm::max(0, COLUMN_OFFSET[direction]));
+			size_t first = glm::max(firstColumn, begin > rowStart ? begin - rowStart : 0);
+			size_t last = glm::min(lastColumn, end - rowStart);
+			if (first >= last) continue;
+			const Real * restingLength = direction == RIGHT || direction == UP ? m_rowStructuralLength.data() : m_rowShearLength.data();
+
+			// As the kernel sees it, the row's particles are bodies 0 to columns and the springs are numbered by the column
+			// of their first particle
+			SpringBatch<Real> batch = { m_columnIndex.data(), m_columnIndex.data() + offset, restingLength, m_rowSpringCoefficient.data(), m_rowDamping.data(),
+				m_positionX.data() + rowStart, m_positionY.data() + rowStart, m_positionZ.data() + rowStart,
+				velocity[0], velocity[1], velocity[2],
+				m_springForce[direction][0] + rowStart, m_springForce[direction][1] + rowStart, m_springForce[direction][2] + rowStart };
+			Physics::computeSpringForces(batch, first, last);
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::integrateParticles(Real deltaTime, const Vector & gravity, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		Vector velocity = getVelocity((int)i);
+
+		// Friction, then the springs the particle is first in, then the opposite of those it is second in, always in the
+		// same order
+		Vector force = -velocity * m_friction;
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			force += Vector(m_springForce[direction][0][i], m_springForce[direction][1][i], m_springForce[direction][2][i]);
+		}
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			size_t offset = (size_t)(ROW_OFFSET[direction] * m_columns + COLUMN_OFFSET[direction]);
+			if (i < offset) continue;
+			force -= Vector(m_springForce[direction][0][i - offset], m_springForce[direction][1][i - offset], m_springForce[direction][2][i - offset]);
+		}
+
+		velocity += (gravity + force * m_inverseMass) * deltaTime;
+		setVelocity((int)i, velocity);
+		m_positionX[i] += velocity.x * deltaTime;
+		m_positionY[i] += velocity.y * deltaTime;
+		m_positionZ[i] += velocity.z * deltaTime;
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::endSubstep()
+{
+	// Pinned particles were moved along with the rest, they go back to where they were at the start of the step
+	for (auto particle : m_pinned)
+	{
+		m_positionX[particle] = m_previousX[particle];
+		m_positionY[particle] = m_previousY[particle];
+		m_positionZ[particle] = m_previousZ[particle];
+		setVelocity(particle, Vector());
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::endStep()
+{
+	// The scratch goes when the arena is reset
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_springForce[direction][axis] = nullptr;
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicCloth<Real>::draw(float alpha) const
+{
+	// Draw a line for each structural spring between the interpolated positions of its particles
+	auto interpolated = [&](int i)
+	{
+		return vec3(Vector(m_previousX[i], m_previousY[i], m_previousZ[i]) + (getPosition(i) - Vector(m_previousX[i], m_previousY[i], m_previousZ[i])) * Real(alpha));
+	};
+	for (int row = 0; row < m_rows; row++)
+	{
+		for (int column = 0; column < m_columns; column++)
+		{
+			int i = row * m_columns + column;
+			if (column + 1 < m_columns)
+			{
+				aie::Gizmos::addLine(interpolated(i), interpolated(i + 1), m_color);
+			}
+			if (row + 1 < m_rows)
+			{
+				aie::Gizmos::addLine(interpolated(i), interpolated(i + m_columns), m_color);
+			}
+		}
+	}
+}
+
+template <typename Real>
+Real Physics::BasicCloth<Real>::getEnergy(const Vector & gravity) const
+{
+	Real energy = Real(0);
+	int count = getParticleCount();
+	for (int i = 0; i < count; i++)
+	{
+		// Kinetic energy, 1/2 m v^2, and gravitational potential energy relative to the origin, -m g.x
+		Vector velocity = getVelocity(i);
+		energy += Real(0.5) * m_particleMass * glm::dot(velocity, velocity);
+		energy -= m_particleMass * glm::dot(gravity, getPosition(i));
+	}
+
+	// Pinned particles are static, so they are taken back out. They don't move so only their potential energy was added
+	for (auto particle : m_pinned)
+	{
+		energy += m_particleMass * glm::dot(gravity, getPosition(particle));
+	}
+
+	// Energy stored in the springs, 1/2 k x^2 each
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		Real restingLength = direction == RIGHT || direction == UP ? m_structuralLength : m_shearLength;
+		for (int row = 0; row + ROW_OFFSET[direction] < m_rows; row++)
+		{
+			for (int column = glm::max(0, -COLUMN_OFFSET[direction]); column < m_columns - glm::max(0, COLUMN_OFFSET[direction]); column++)
+			{
+				int i = row * m_columns + column;
+				Real stretch = glm::distance(getPosition(i), getPosition(i + ROW_OFFSET[direction] * m_columns + COLUMN_OFFSET[direction])) - restingLength;
+				energy += Real(0.5) * m_springCoefficient * stretch * stretch;
+			}
+		}
+	}
+	return energy;
+}
+
+template <typename Real>
+uint64_t Physics::BasicCloth<Real>::hashState(uint64_t hash) const
+{
+	// The same FNV-1a over the words of each component as Scene::computeStateHash
+	auto hashVector = [&hash](const Vector & vector)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			uint32_t bits[sizeof(Real) / sizeof(uint32_t)];
+			memcpy(bits, &vector[i], sizeof(bits));
+			for (auto word : bits)
+			{
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+		}
+	};
+
+	int count = getParticleCount();
+	for (int i = 0; i < count; i++)
+	{
+		hashVector(getPosition(i));
+		hashVector(getVelocity(i));
+	}
+	return hash;
+}
+
+template <typename Real>
+size_t Physics::BasicCloth<Real>::getBytesPerParticle(bool compactVelocity)
+{
+	// Position and previous position, then the velocity
+	return 6 * sizeof(Real) + (compactVelocity ? 3 * sizeof(uint16_t) : 3 * sizeof(Real));
+}
+
+template <typename Real>
+size_t Physics::BasicCloth<Real>::getMemoryBytes() const
+{
+	size_t bytes = sizeof(*this);
+	bytes += (m_positionX.capacity() + m_positionY.capacity() + m_positionZ.capacity()) * sizeof(Real);
+	bytes += (m_previousX.capacity() + m_previousY.capacity() + m_previousZ.capacity()) * sizeof(Real);
+	bytes += (m_velocityX.capacity() + m_velocityY.capacity() + m_velocityZ.capacity()) * sizeof(Real);
+	bytes += (m_halfVelocityX.capacity() + m_halfVelocityY.capacity() + m_halfVelocityZ.capacity()) * sizeof(uint16_t);
+	bytes += m_pinned.capacity() * sizeof(int);
+	bytes += (m_rowStructuralLength.capacity() + m_rowShearLength.capacity() + m_rowSpringCoefficient.capacity() + m_rowDamping.capacity()) * sizeof(Real);
+	bytes += m_columnIndex.capacity() * sizeof(int);
+	return bytes;
+}
+
+template class Physics::BasicCloth<float>;
+template class Physics::BasicCloth<double>;
@@ -0,0 +1,511 @@
+#include "Physics/ClothEnsemble.h"
+#include "Physics/Cloth.h"
+#include "Physics/FrameArena.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/WorkerPool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+using namespace Physics;
+
+#if defined(__AVX__)
+#define PHYSICS_CLOTH_ENSEMBLE_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYSICS_CLOTH_ENSEMBLE_SSE
+#include <emmintrin.h>
+#endif
+
+template <typename Real>
+const int BasicClothEnsemble<Real>::ROW_OFFSET[DIRECTIONS] = { 0, 1, 1, 1 };
+template <typename Real>
+const int BasicClothEnsemble<Real>::COLUMN_OFFSET[DIRECTIONS] = { 1, 0, 1, -1 };
+
+// The operations the lane kernels are written in, for WIDTH lanes at a time. Each is the same single operation for every
+// lane, so the lanes come out exactly as the scalar cloth's would
+template <typename Real>
+struct ScalarLanes
+{
+	typedef Real Value;
+	static const int WIDTH = 1;
+	static inline Value load(const Real * values) { return *values; }
+	static inline void store(Real * values, Value value) { *values = value; }
+	static inline Value set(Real value) { return value; }
+	static inline Value zero() { return Real(0); }
+	static inline Value add(Value a, Value b) { return a + b; }
+	static inline Value sub(Value a, Value b) { return a - b; }
+	static inline Value mul(Value a, Value b) { return a * b; }
+	static inline Value div(Value a, Value b) { return a / b; }
+	static inline Value sqrt(Value a) { return std::sqrt(a); }
+	static inline Value negate(Value a) { return -a; }
+
+	// Value where mask isn't zero, zero where it is
+	static inline Value maskZero(Value mask, Value value) { return mask != Real(0) ? value : Real(0); }
+};
+
+#ifdef PHYSICS_CLOTH_ENSEMBLE_SSE
+struct SseLanes
+{
+	typedef __m128 Value;
+	static const int WIDTH = 4;
+	static inline Value load(const float * values) { return _mm_loadu_ps(values); }
+	static inline void store(float * values, Value value) { _mm_storeu_ps(values, value); }
+	static inline Value set(float value) { return _mm_set1_ps(value); }
+	static inline Value zero() { return _mm_setzero_ps(); }
+	static inline Value add(Value a, Value b) { return _mm_add_ps(a, b); }
+	static inline Value sub(Value a, Value b) { return _mm_sub_ps(a, b); }
+	static inline Value mul(Value a, Value b) { return _mm_mul_ps(a, b); }
+	static inline Value div(Value a, Value b) { return _mm_div_ps(a, b); }
+	static inline Value sqrt(Value a) { return _mm_sqrt_ps(a); }
+	static inline Value negate(Value a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+	static inline Value maskZero(Value mask, Value value) { return _mm_and_ps(_mm_cmpneq_ps(mask, _mm_setzero_ps()), value); }
+};
+#endif
+
+#ifdef PHYSICS_CLOTH_ENSEMBLE_AVX
+struct AvxLanes
+{
+	typedef __m256 Value;
+	static const int WIDTH = 8;
+	static inline Value load(const float * values) { return _mm256_loadu_ps(values); }
+	static inline void store(float * values, Value value) { _mm256_storeu_ps(values, value); }
+	static inline Value set(float value) { return _mm256_set1_ps(value); }
+	static inline Value zero() { return _mm256_setzero_ps(); }
+	static inline Value add(Value a, Value b) { return _mm256_add_ps(a, b); }
+	static inline Value sub(Value a, Value b) { return _mm256_sub_ps(a, b); }
+	static inline Value mul(Value a, Value b) { return _mm256_mul_ps(a, b); }
+	static inline Value div(Value a, Value b) { return _mm256_div_ps(a, b); }
+	static inline Value sqrt(Value a) { return _mm256_sqrt_ps(a); }
+	static inline Value negate(Value a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+	static inline Value maskZero(Value mask, Value value) { return _mm256_and_ps(_mm256_cmp_ps(mask, _mm256_setzero_ps(), _CMP_NEQ_UQ), value); }
+};
+#endif
+
+// The widest operations the target has for each precision
+template <typename Real>
+struct LaneOperations
+{
+	typedef ScalarLanes<Real> Type;
+};
+#if defined(PHYSICS_CLOTH_ENSEMBLE_AVX)
+template <>
+struct LaneOperations<float>
+{
+	typedef AvxLanes Type;
+};
+#elif defined(PHYSICS_CLOTH_ENSEMBLE_SSE)
+template <>
+struct LaneOperations<float>
+{
+	typedef SseLanes Type;
+};
+#endif
+
+// Works out the force of one spring on its first particle in every lane, the same steps as the spring kernel's scalar loop
+template <typename Ops, typename Real, int LANES>
+static inline void computeLaneSpringForce(Real * const * position, Real * const * velocity, Real * const * force, size_t a, size_t b,
+	Real restingLength, const Real * springCoefficient, const Real * damping)
+{
+	for (int lane = 0; lane < LANES; lane += Ops::WIDTH)
+	{
+		size_t laneA = a * LANES + lane;
+		size_t laneB = b * LANES + lane;
+		typename Ops::Value springX = Ops::sub(Ops::load(position[0] + laneA), Ops::load(position[0] + laneB));
+		typename Ops::Value springY = Ops::sub(Ops::load(position[1] + laneA), Ops::load(position[1] + laneB));
+		typename Ops::Value springZ = Ops::sub(Ops::load(position[2] + laneA), Ops::load(position[2] + laneB));
+		typename Ops::Value distance = Ops::sqrt(Ops::add(Ops::add(Ops::mul(springX, springX), Ops::mul(springY, springY)), Ops::mul(springZ, springZ)));
+		typename Ops::Value stretch = Ops::sub(distance, Ops::set(restingLength));
+		typename Ops::Value coefficient = Ops::load(springCoefficient + lane);
+		typename Ops::Value springDamping = Ops::load(damping + lane);
+
+		// Particles on top of each other divide by zero, their lanes are masked out to leave no spring force
+		typename Ops::Value forceX = Ops::add(Ops::zero(), Ops::maskZero(distance, Ops::mul(Ops::mul(Ops::negate(Ops::div(springX, distance)), stretch), coefficient)));
+		typename Ops::Value forceY = Ops::add(Ops::zero(), Ops::maskZero(distance, Ops::mul(Ops::mul(Ops::negate(Ops::div(springY, distance)), stretch), coefficient)));
+		typename Ops::Value forceZ = Ops::add(Ops::zero(), Ops::maskZero(distance, Ops::mul(Ops::mul(Ops::negate(Ops::div(springZ, distance)), stretch), coefficient)));
+		forceX = Ops::add(forceX, Ops::mul(Ops::negate(Ops::sub(Ops::load(velocity[0] + laneA), Ops::load(velocity[0] + laneB))), springDamping));
+		forceY = Ops::add(forceY, Ops::mul(Ops::negate(Ops::sub(Ops::load(velocity[1] + laneA), Ops::load(velocity[1] + laneB))), springDamping));
+		forceZ = Ops::add(forceZ, Ops::mul(Ops::negate(Ops::sub(Ops::load(velocity[2] + laneA), Ops::load(velocity[2] + laneB))), springDamping));
+
+		Ops::store(force[0] + laneA, forceX);
+		Ops::store(force[1] + laneA, forceY);
+		Ops::store(force[2] + laneA, forceZ);
+	}
+}
+
+template <typename Real>
+Physics::BasicClothEnsemble<Real>::BasicClothEnsemble(int instanceCount, int rows, int columns, const Vector & origin, Real spacing, Real particleMass, Real springCoefficient, Real damping) :
+	m_instanceCount(instanceCount), m_rows(rows), m_columns(columns), m_structuralLength(spacing), m_shearLength(spacing * std::sqrt(Real(2)))
+{
+	assert(instanceCount > 0 && rows > 0 && columns > 0);
+	MemoryScope scope(MemoryCategory::CLOTHS);
+
+	m_blocks.resize((instanceCount + LANES - 1) / LANES);
+	size_t count = (size_t)rows * columns;
+	for (auto & block : m_blocks)
+	{
+		// Lay the particles out on the grid in every lane, still
+		block.positionX.resize(count * LANES);
+		block.positionY.resize(count * LANES);
+		block.positionZ.resize(count * LANES);
+		for (size_t i = 0; i < count; i++)
+		{
+			for (int lane = 0; lane < LANES; lane++)
+			{
+				block.positionX[i * LANES + lane] = origin.x + (int)(i / columns) * spacing;
+				block.positionY[i * LANES + lane] = origin.y + (int)(i % columns) * spacing;
+				block.positionZ[i * LANES + lane] = origin.z;
+			}
+		}
+		block.previousX = block.positionX;
+		block.previousY = block.positionY;
+		block.previousZ = block.positionZ;
+		block.velocityX.assign(count * LANES, Real(0));
+		block.velocityY.assign(count * LANES, Real(0));
+		block.velocityZ.assign(count * LANES, Real(0));
+
+		// Forces of springs that don't exist, on the edges, are never written so they stay zero
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				block.springForce[direction][axis].assign(count * LANES, Real(0));
+			}
+		}
+
+		for (int lane = 0; lane < LANES; lane++)
+		{
+			block.particleMass[lane] = particleMass;
+			block.inverseMass[lane] = Real(1) / particleMass;
+			block.springCoefficient[lane] = springCoefficient;
+			block.damping[lane] = damping;
+			block.friction[lane] = Real(0.3);
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::setPinned(int row, int column)
+{
+	int particle = row * m_columns + column;
+	if (std::find(m_pinned.begin(), m_pinned.end(), particle) != m_pinned.end()) return;
+	m_pinned.push_back(particle);
+	for (auto & block : m_blocks)
+	{
+		for (int lane = 0; lane < LANES; lane++)
+		{
+			block.velocityX[particle * LANES + lane] = Real(0);
+			block.velocityY[particle * LANES + lane] = Real(0);
+			block.velocityZ[particle * LANES + lane] = Real(0);
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::setSpringCoefficient(int instance, Real springCoefficient)
+{
+	m_blocks[instance / LANES].springCoefficient[instance % LANES] = springCoefficient;
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::setDamping(int instance, Real damping)
+{
+	m_blocks[instance / LANES].damping[instance % LANES] = damping;
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::setParticleMass(int instance, Real particleMass)
+{
+	m_blocks[instance / LANES].particleMass[instance % LANES] = particleMass;
+	m_blocks[instance / LANES].inverseMass[instance % LANES] = Real(1) / particleMass;
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::setFriction(int instance, Real friction)
+{
+	m_blocks[instance / LANES].friction[instance % LANES] = friction;
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::step(Real deltaTime, int substeps, const Vector & gravity, WorkerPool * workers)
+{
+	if (workers == nullptr)
+	{
+		for (auto & block : m_blocks)
+		{
+			stepBlock(block, deltaTime, substeps, gravity);
+		}
+		return;
+	}
+	workers->run((int)m_blocks.size(), [&](int chunk, int) { stepBlock(m_blocks[chunk], deltaTime, substeps, gravity); });
+}
+
+template <typename Real>
+void Physics::BasicClothEnsemble<Real>::stepBlock(Block & block, Real deltaTime, int substeps, const Vector & gravity)
+{
+	typedef typename LaneOperations<Real>::Type Ops;
+	typedef typename Ops::Value Value;
+	size_t count = (size_t)getParticleCount();
+
+	// Keep the state from before this step so pinned particles can be put back
+	std::copy(block.positionX.begin(), block.positionX.end(), block.previousX.begin());
+	std::copy(block.positionY.begin(), block.positionY.end(), block.previousY.begin());
+	std::copy(block.positionZ.begin(), block.positionZ.end(), block.previousZ.begin());
+
+	Real * position[3] = { block.positionX.data(), block.positionY.data(), block.positionZ.data() };
+	Real * velocity[3] = { block.velocityX.data(), block.velocityY.data(), block.velocityZ.data() };
+	Real * force[DIRECTIONS][3];
+	size_t offset[DIRECTIONS];
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			force[direction][axis] = block.springForce[direction][axis].data();
+		}
+		offset[direction] = (size_t)(ROW_OFFSET[direction] * m_columns + COLUMN_OFFSET[direction]);
+	}
+
+	Real substepTime = deltaTime / substeps;
+	const Value gravityX = Ops::set(gravity.x);
+	const Value gravityY = Ops::set(gravity.y);
+	const Value gravityZ = Ops::set(gravity.z);
+	const Value timeStep = Ops::set(substepTime);
+	for (int substep = 0; substep < substeps; substep++)
+	{
+		// The springs of each kind, by their first particle
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			Real restingLength = direction == RIGHT || direction == UP ? m_structuralLength : m_shearLength;
+			int firstColumn = glm::max(0, -COLUMN_OFFSET[direction]);
+			int lastColumn = m_columns - glm::max(0, COLUMN_OFFSET[direction]);
+			for (int row = 0; row + ROW_OFFSET[direction] < m_rows; row++)
+			{
+				for (int column = firstColumn; column < lastColumn; column++)
+				{
+					size_t i = (size_t)(row * m_columns + column);
+					computeLaneSpringForce<Ops, Real, LANES>(position, velocity, force[direction], i, i + offset[direction], restingLength, block.springCoefficient, block.damping);
+				}
+			}
+		}
+
+		// Friction, the springs each particle is first in, then the opposite of those it is second in, in Cloth's order
+		for (size_t i = 0; i < count; i++)
+		{
+			for (int lane = 0; lane < LANES; lane += Ops::WIDTH)
+			{
+				size_t index = i * LANES + lane;
+				Value velocityX = Ops::load(velocity[0] + index);
+				Value velocityY = Ops::load(velocity[1] + index);
+				Value velocityZ = Ops::load(velocity[2] + index);
+				Value friction = Ops::load(block.friction + lane);
+				Value forceX = Ops::mul(Ops::negate(velocityX), friction);
+				Value forceY = Ops::mul(Ops::negate(velocityY), friction);
+				Value forceZ = Ops::mul(Ops::negate(velocityZ), friction);
+				for (int direction = 0; direction < DIRECTIONS; direction++)
+				{
+					forceX = Ops::add(forceX, Ops::load(force[direction][0] + index));
+					forceY = Ops::add(forceY, Ops::load(force[direction][1] + index));
+					forceZ = Ops::add(forceZ, Ops::load(force[direction][2] + index));
+				}
+				for (int direction = 0; direction < DIRECTIONS; direction++)
+				{
+					if (i < offset[direction]) continue;
+					size_t other = index - offset[direction] * LANES;
+					forceX = Ops::sub(forceX, Ops::load(force[direction][0] + other));
+					forceY = Ops::sub(forceY, Ops::load(force[direction][1] + other));
+					forceZ = Ops::sub(forceZ, Ops::load(force[direction][2] + other));
+				}
+
+				Value inverseMass = Ops::load(block.inverseMass + lane);
+				velocityX = Ops::add(velocityX, Ops::mul(Ops::add(gravityX, Ops::mul(forceX, inverseMass)), timeStep));
+				velocityY = Ops::add(velocityY, Ops::mul(Ops::add(gravityY, Ops::mul(forceY, inverseMass)), timeStep));
+				velocityZ = Ops::add(velocityZ, Ops::mul(Ops::add(gravityZ, Ops::mul(forceZ, inverseMass)), timeStep));
+				Ops::store(velocity[0] + index, velocityX);
+				Ops::store(velocity[1] + index, velocityY);
+				Ops::store(velocity[2] + index, velocityZ);
+				Ops::store(position[0] + index, Ops::add(Ops::load(position[0] + index), Ops::mul(velocityX, timeStep)));
+				Ops::store(position[1] + index, Ops::add(Ops::load(position[1] + index), Ops::mul(velocityY, timeStep)));
+				Ops::store(position[2] + index, Ops::add(Ops::load(position[2] + index), Ops::mul(velocityZ, timeStep)));
+			}
+		}
+
+		// Pinned particles go back to where they were at the start of the step
+		for (auto particle : m_pinned)
+		{
+			for (int lane = 0; lane < LANES; lane++)
+			{
+				size_t index = (size_t)particle * LANES + lane;
+				block.positionX[index] = block.previousX[index];
+				block.positionY[index] = block.previousY[index];
+				block.positionZ[index] = block.previousZ[index];
+				block.velocityX[index] = Real(0);
+				block.velocityY[index] = Real(0);
+				block.velocityZ[index] = Real(0);
+			}
+		}
+	}
+}
+
+template <typename Real>
+typename BasicClothEnsemble<Real>::Vector Physics::BasicClothEnsemble<Real>::getPosition(int instance, int particle) const
+{
+	const Block & block = m_blocks[instance / LANES];
+	size_t index = (size_t)particle * LANES + instance % LANES;
+	return Vector(block.positionX[index], block.positionY[index], block.positionZ[index]);
+}
+
+template <typename Real>
+typename BasicClothEnsemble<Real>::Vector Physics::BasicClothEnsemble<Real>::getVelocity(int instance, int particle) const
+{
+	const Block & block = m_blocks[instance / LANES];
+	size_t index = (size_t)particle * LANES + instance % LANES;
+	return Vector(block.velocityX[index], block.velocityY[index], block.velocityZ[index]);
+}
+
+template <typename Real>
+Real Physics::BasicClothEnsemble<Real>::getEnergy(int instance, const Vector & gravity) const
+{
+	const Block & block = m_blocks[instance / LANES];
+	Real particleMass = block.particleMass[instance % LANES];
+	Real springCoefficient = block.springCoefficient[instance % LANES];
+
+	// The same sums as Cloth::getEnergy
+	Real energy = Real(0);
+	int count = getParticleCount();
+	for (int i = 0; i < count; i++)
+	{
+		Vector velocity = getVelocity(instance, i);
+		energy += Real(0.5) * particleMass * glm::dot(velocity, velocity);
+		energy -= particleMass * glm::dot(gravity, getPosition(instance, i));
+	}
+	for (auto particle : m_pinned)
+	{
+		energy += particleMass * glm::dot(gravity, getPosition(instance, particle));
+	}
+	for (int direction = 0; direction < DIRECTIONS; direction++)
+	{
+		Real restingLength = direction == RIGHT || direction == UP ? m_structuralLength : m_shearLength;
+		for (int row = 0; row + ROW_OFFSET[direction] < m_rows; row++)
+		{
+			for (int column = glm::max(0, -COLUMN_OFFSET[direction]); column < m_columns - glm::max(0, COLUMN_OFFSET[direction]); column++)
+			{
+				int i = row * m_columns + column;
+				Real stretch = glm::distance(getPosition(instance, i), getPosition(instance, i + ROW_OFFSET[direction] * m_columns + COLUMN_OFFSET[direction])) - restingLength;
+				energy += Real(0.5) * springCoefficient * stretch * stretch;
+			}
+		}
+	}
+	return energy;
+}
+
+template <typename Real>
+uint64_t Physics::BasicClothEnsemble<Real>::hashState(int instance, uint64_t hash) const
+{
+	// The same FNV-1a as Cloth::hashState
+	auto hashVector = [&hash](const Vector & vector)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			uint32_t bits[sizeof(Real) / sizeof(uint32_t)];
+			memcpy(bits, &vector[i], sizeof(bits));
+			for (auto word : bits)
+			{
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+		}
+	};
+
+	int count = getParticleCount();
+	for (int i = 0; i < count; i++)
+	{
+		hashVector(getPosition(instance, i));
+		hashVector(getVelocity(instance, i));
+	}
+	return hash;
+}
+
+template <typename Real>
+int Physics::BasicClothEnsemble<Real>::getSimdWidth()
+{
+	return LaneOperations<Real>::Type::WIDTH;
+}
+
+template <typename Real>
+size_t Physics::BasicClothEnsemble<Real>::getMemoryBytes() const
+{
+	size_t bytes = sizeof(*this) + getVectorBytes(m_blocks) + getVectorBytes(m_pinned);
+	for (auto & block : m_blocks)
+	{
+		bytes += getVectorBytes(block.positionX) + getVectorBytes(block.positionY) + getVectorBytes(block.positionZ);
+		bytes += getVectorBytes(block.previousX) + getVectorBytes(block.previousY) + getVectorBytes(block.previousZ);
+		bytes += getVectorBytes(block.velocityX) + getVectorBytes(block.velocityY) + getVectorBytes(block.velocityZ);
+		for (int direction = 0; direction < DIRECTIONS; direction++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				bytes += getVectorBytes(block.springForce[direction][axis]);
+			}
+		}
+	}
+	return bytes;
+}
+
+ClothEnsembleBenchmark Physics::benchmarkClothEnsemble(int instanceCount, int rows, int columns, int steps)
+{
+	// The app's cloth rig, pinned at the two top corners, with a different spring coefficient in every instance
+	const glm::vec3 origin(0, 10, 0);
+	const glm::vec3 gravity(0, -9.8f, 0);
+	const float timeStep = 1.0f / 60.0f;
+	const int substeps = 4;
+	auto springCoefficient = [](int instance) { return 5.0f + instance * 0.5f; };
+
+	ClothEnsemble ensemble(instanceCount, rows, columns, origin, 1.0f, 0.1f, 10.0f, 0.2f);
+	ensemble.setPinned(0, columns - 1);
+	ensemble.setPinned(rows - 1, columns - 1);
+	vector<Cloth *> cloths;
+	for (int instance = 0; instance < instanceCount; instance++)
+	{
+		ensemble.setSpringCoefficient(instance, springCoefficient(instance));
+		Cloth * cloth = new Cloth(rows, columns, origin, 1.0f, 0.1f, springCoefficient(instance), 0.2f, glm::vec4(1.0f));
+		cloth->setPinned(0, columns - 1);
+		cloth->setPinned(rows - 1, columns - 1);
+		cloths.push_back(cloth);
+	}
+
+	// The cloths side by side, one after another on one thread as the ensemble is
+	FrameArena arena;
+	auto forEach = [](size_t count, auto body) { body((size_t)0, count); };
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int step = 0; step < steps; step++)
+	{
+		for (auto cloth : cloths)
+		{
+			cloth->step(timeStep, substeps, gravity, arena, forEach);
+			arena.reset();
+		}
+	}
+	auto middle = std::chrono::high_resolution_clock::now();
+	for (int step = 0; step < steps; step++)
+	{
+		ensemble.step(timeStep, substeps, gravity);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	ClothEnsembleBenchmark result;
+	result.instanceCount = instanceCount;
+	result.simdWidth = ClothEnsemble::getSimdWidth();
+	result.clothTime = std::chrono::duration<float, std::milli>(middle - start).count();
+	result.ensembleTime = std::chrono::duration<float, std::milli>(end - middle).count();
+	result.matches = true;
+	for (int instance = 0; instance < instanceCount; instance++)
+	{
+		const uint64_t basis = 14695981039346656037ull;
+		result.matches = result.matches && ensemble.hashState(instance, basis) == cloths[instance]->hashState(basis);
+		delete cloths[instance];
+	}
+	return result;
+}
+
+template class Physics::BasicClothEnsemble<float>;
+template class Physics::BasicClothEnsemble<double>;
@@ -1,9 +1,14 @@
 #include "Physics/Constraint.h"
 using namespace Physics;
-Physics::Constraint::~Constraint()
+template <typename Real>
+Physics::BasicConstraint<Real>::~BasicConstraint()
 {
 }
-Physics::Constraint::Constraint(Object * objA, Object * objB): m_objA(objA), m_objB(objB)
+template <typename Real>
+Physics::BasicConstraint<Real>::BasicConstraint(Object * objA, Object * objB): m_objA(objA), m_objB(objB)
 {
 
 }
+
+template class Physics::BasicConstraint<float>;
+template class Physics::BasicConstraint<double>;
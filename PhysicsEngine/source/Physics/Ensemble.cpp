@@ -0,0 +1,132 @@
+#include "Physics/Ensemble.h"
+#include "Physics/Scene.h"
+#include "Physics/WorkerPool.h"
+#include <chrono>
+using namespace Physics;
+
+template <typename Real>
+Physics::BasicEnsemble<Real>::BasicEnsemble(BuildFunction build, IntegratorType integrator) :
+	m_build(build), m_integrator(integrator), m_workers(nullptr), m_lastRunTime(0.0f)
+{
+}
+
+template <typename Real>
+BasicEnsemble<Real>::~BasicEnsemble()
+{
+	for (auto instance : m_instances)
+	{
+		delete instance;
+	}
+	delete m_workers;
+}
+
+template <typename Real>
+int Physics::BasicEnsemble<Real>::addInstance(const Overrides & overrides)
+{
+	// Deterministic so the hash of an instance can be compared between runs
+	Scene * scene = new Scene(m_integrator);
+	scene->setDeterministic(true);
+	m_build(*scene);
+
+	// The overrides change what the template built, so it has to be applied first
+	scene->applyCommands();
+	applyOverrides(*scene, overrides);
+
+	m_instances.push_back(scene);
+	m_overrides.push_back(overrides);
+	m_metrics.push_back(Metrics());
+
+	int instance = (int)m_instances.size() - 1;
+	collectMetrics(instance);
+	m_metrics[instance].startEnergy = m_metrics[instance].energy;
+	return instance;
+}
+
+template <typename Real>
+void Physics::BasicEnsemble<Real>::applyOverrides(Scene & scene, const Overrides & overrides)
+{
+	if (overrides.springCoefficient >= Real(0))
+	{
+		for (auto spring : scene.getSprings())
+		{
+			scene.setSpringCoefficient(spring, overrides.springCoefficient);
+		}
+		for (auto cloth : scene.getCloths())
+		{
+			cloth->setSpringCoefficient(overrides.springCoefficient);
+		}
+	}
+	if (overrides.elasticity >= Real(0))
+	{
+		for (auto object : scene.getObjects())
+		{
+			object->setElasticity(overrides.elasticity);
+		}
+	}
+	if (overrides.friction >= Real(0))
+	{
+		for (auto object : scene.getObjects())
+		{
+			scene.setFriction(object, overrides.friction);
+		}
+		for (auto cloth : scene.getCloths())
+		{
+			cloth->setFriction(overrides.friction);
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicEnsemble<Real>::run(int steps, int threadCount)
+{
+	if (m_workers == nullptr || m_workers->getThreadCount() != threadCount)
+	{
+		delete m_workers;
+		m_workers = new WorkerPool(threadCount);
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// One chunk per instance, each instance is stepped start to finish by whichever thread takes it
+	m_workers->run((int)m_instances.size(), [this, steps](int instance, int)
+	{
+		auto instanceStart = std::chrono::high_resolution_clock::now();
+		Scene * scene = m_instances[instance];
+		for (int step = 0; step < steps; step++)
+		{
+			scene->applyGlobalForce();
+			scene->update((float)scene->getFixedTimeStep());
+		}
+		m_metrics[instance].stepCount += steps;
+		m_metrics[instance].runTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - instanceStart).count();
+		collectMetrics(instance);
+	});
+
+	m_lastRunTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+template <typename Real>
+float Physics::BasicEnsemble<Real>::getInstanceRunTime() const
+{
+	float total = 0.0f;
+	for (auto & metrics : m_metrics)
+	{
+		total += metrics.runTime;
+	}
+	return total;
+}
+
+template <typename Real>
+void Physics::BasicEnsemble<Real>::collectMetrics(int instance)
+{
+	Scene * scene = m_instances[instance];
+	Metrics & metrics = m_metrics[instance];
+	metrics.energy = scene->getTotalEnergy();
+	metrics.averageStretch = scene->getAverageSpringStretch();
+	metrics.maxStretch = scene->getMaxSpringStretch();
+	metrics.stateHash = scene->getStateHash();
+	metrics.objectCount = (int)scene->getObjects().size();
+}
+
+template class Physics::BasicEnsemble<float>;
+template class Physics::BasicEnsemble<double>;
@@ -0,0 +1,93 @@
+#include "Physics/FrameArena.h"
+#include "Physics/MemoryAccounting.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace Physics;
+
+// Rounds an address up to the alignment, which is a power of two
+static inline uintptr_t alignUp(uintptr_t address, size_t alignment)
+{
+	return (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+}
+
+Physics::FrameArena::FrameArena(size_t capacity) :
+	m_capacity(capacity), m_offset(0), m_overflowBytes(0), m_highWaterMark(0), m_overflowCount(0)
+{
+	MemoryScope scope(MemoryCategory::FRAME_ARENA);
+	m_block = (char *)::operator new(m_capacity);
+#ifdef _DEBUG
+	m_poisonFreed = true;
+#else
+	m_poisonFreed = false;
+#endif
+}
+
+FrameArena::~FrameArena()
+{
+	for (auto block : m_overflowBlocks)
+	{
+		::operator delete(block);
+	}
+	::operator delete(m_block);
+}
+
+void * Physics::FrameArena::allocate(size_t bytes, size_t alignment)
+{
+	// Claim the next aligned range of the block, retrying if another thread claimed it first
+	uintptr_t base = (uintptr_t)m_block;
+	size_t offset = m_offset.load();
+	size_t start;
+	do
+	{
+		start = alignUp(base + offset, alignment) - base;
+		if (start + bytes > m_capacity) break;
+	} while (!m_offset.compare_exchange_weak(offset, start + bytes));
+
+	if (start + bytes <= m_capacity)
+	{
+		return m_block + start;
+	}
+
+	// It doesn't fit, so allocate it on its own until the block is grown at the next reset
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	MemoryScope scope(MemoryCategory::FRAME_ARENA);
+	char * memory = (char *)::operator new(bytes + alignment);
+	m_overflowBlocks.push_back(memory);
+	m_overflowBytes += bytes + alignment;
+	return (void *)alignUp((uintptr_t)memory, alignment);
+}
+
+void Physics::FrameArena::reset()
+{
+	size_t used = getUsed();
+	m_highWaterMark = std::max(m_highWaterMark, used);
+
+	if (m_poisonFreed)
+	{
+		memset(m_block, POISON, std::min(m_offset.load(), m_capacity));
+	}
+
+	// Grow the block so a step like this one fits in it next time
+	if (!m_overflowBlocks.empty())
+	{
+		for (auto block : m_overflowBlocks)
+		{
+			::operator delete(block);
+		}
+		m_overflowBlocks.clear();
+		m_overflowBytes = 0;
+		m_overflowCount++;
+
+		MemoryScope scope(MemoryCategory::FRAME_ARENA);
+		::operator delete(m_block);
+		m_capacity = used + used / 2;
+		m_block = (char *)::operator new(m_capacity);
+		if (m_poisonFreed)
+		{
+			memset(m_block, POISON, m_capacity);
+		}
+	}
+
+	m_offset = 0;
+}
@@ -0,0 +1,103 @@
+#include "Physics/FramePipeline.h"
+#include "Physics/Scene.h"
+#include <chrono>
+using namespace Physics;
+
+template <typename Real>
+Physics::BasicFramePipeline<Real>::BasicFramePipeline(Scene * scene) :
+	m_scene(scene), m_stepRequested(false), m_stepDone(false), m_stopping(false), m_stepping(false), m_deltaTime(0.0f), m_front(0)
+{
+	// Drawn until the first step has been waited for
+	RenderSnapshot::Clock::time_point now = RenderSnapshot::Clock::now();
+	m_scene->captureSnapshot(m_snapshots[m_front]);
+	m_snapshots[m_front].setTiming(m_scene->getInterpolationAlpha(), (float)m_scene->getFixedTimeStep(), now);
+	m_stepTimes.start = now;
+	m_stepTimes.end = now;
+	m_stepTimes.waitTime = 0.0f;
+
+	m_thread = std::thread(&BasicFramePipeline::run, this);
+}
+
+template <typename Real>
+BasicFramePipeline<Real>::~BasicFramePipeline()
+{
+	waitForStep();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_signal.notify_all();
+	m_thread.join();
+}
+
+template <typename Real>
+void Physics::BasicFramePipeline<Real>::beginStep(float deltaTime, const Vector & lodFocus)
+{
+	waitForStep();
+
+	// The thread reads these once it has taken the request, which the lock orders after them
+	m_deltaTime = deltaTime;
+	m_lodFocus = lodFocus;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stepRequested = true;
+		m_stepDone = false;
+	}
+	m_signal.notify_all();
+	m_stepping = true;
+}
+
+template <typename Real>
+void Physics::BasicFramePipeline<Real>::waitForStep()
+{
+	if (!m_stepping) return;
+
+	RenderSnapshot::Clock::time_point waitStart = RenderSnapshot::Clock::now();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_signal.wait(lock, [this] { return m_stepDone; });
+	}
+	m_stepTimes.waitTime = std::chrono::duration<float, std::milli>(RenderSnapshot::Clock::now() - waitStart).count();
+
+	// The step wrote the back snapshot, which now becomes the one drawn
+	m_front = 1 - m_front;
+	m_stepping = false;
+}
+
+template <typename Real>
+void Physics::BasicFramePipeline<Real>::run()
+{
+	typedef RenderSnapshot::Clock Clock;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_signal.wait(lock, [this] { return m_stepRequested || m_stopping; });
+			if (m_stopping) return;
+			m_stepRequested = false;
+		}
+
+		// The same update the scene gets when it is stepped in the frame, commands are applied by the scene at its next step
+		Clock::time_point start = Clock::now();
+		m_scene->setLODFocus(m_lodFocus);
+		m_scene->applyGlobalForce();
+		m_scene->update(m_deltaTime);
+
+		// The front snapshot is being drawn, so the step's goes in the other
+		Clock::time_point end = Clock::now();
+		RenderSnapshot & snapshot = m_snapshots[1 - m_front];
+		m_scene->captureSnapshot(snapshot);
+		snapshot.setTiming(m_scene->getInterpolationAlpha(), (float)m_scene->getFixedTimeStep(), end);
+		m_stepTimes.start = start;
+		m_stepTimes.end = end;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stepDone = true;
+		}
+		m_signal.notify_all();
+	}
+}
+
+template class Physics::BasicFramePipeline<float>;
+template class Physics::BasicFramePipeline<double>;
@@ -0,0 +1,66 @@
+#include "Physics/MemoryAccounting.h"
+#include <algorithm>
+using namespace Physics;
+
+// The innermost scope of each thread. A plain value so reading it from operator new never allocates
+static thread_local MemoryCategory s_currentCategory = MemoryCategory::OTHER;
+
+static const char * s_categoryNames[(int)MemoryCategory::COUNT] =
+{
+	"Bodies", "Objects", "Springs", "Cloths", "Handles", "Commands", "Subsystems", "Frame arena", "Rendering", "Other"
+};
+
+const char * Physics::getMemoryCategoryName(MemoryCategory category)
+{
+	return s_categoryNames[(int)category];
+}
+
+Physics::MemoryScope::MemoryScope(MemoryCategory category) : m_previous(s_currentCategory)
+{
+	s_currentCategory = category;
+}
+
+Physics::MemoryScope::~MemoryScope()
+{
+	s_currentCategory = m_previous;
+}
+
+MemoryCategory Physics::MemoryScope::getCurrentCategory()
+{
+	return s_currentCategory;
+}
+
+Physics::MemoryReport::MemoryReport()
+{
+	for (auto & usage : m_usage)
+	{
+		usage = { 0, 0, 0 };
+	}
+}
+
+void Physics::MemoryReport::setLiveBytes(MemoryCategory category, size_t bytes)
+{
+	MemoryUsage & usage = m_usage[(int)category];
+	usage.liveBytes = bytes;
+	usage.peakBytes = std::max(usage.peakBytes, bytes);
+}
+
+size_t Physics::MemoryReport::getTotalLiveBytes() const
+{
+	size_t total = 0;
+	for (auto & usage : m_usage)
+	{
+		total += usage.liveBytes;
+	}
+	return total;
+}
+
+size_t Physics::MemoryReport::getTotalPeakBytes() const
+{
+	size_t total = 0;
+	for (auto & usage : m_usage)
+	{
+		total += usage.peakBytes;
+	}
+	return total;
+}
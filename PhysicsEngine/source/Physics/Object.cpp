@@ -8,21 +8,57 @@ using namespace Physics;
 using glm::vec3;
 
 // Constructor
-Physics::Object::Object(ShapeType shape, vec3 pos, float mass, vec4 color, bool isStatic) :
-	m_shape (shape), m_position(pos), m_mass(mass), m_color(color), m_isStatic(isStatic)
+template <typename Real>
+Physics::BasicObject<Real>::BasicObject(ShapeType shape, Vector pos, Real mass, vec4 color, bool isStatic, BodyStore * bodies) :
+	m_shape (shape)
 {
-	// Sets the velocity and acceleration to 0 on initialisation
-	m_velocity = vec3();
-	m_acceleration = vec3();
+	// Unless it is made straight into a scene's store, the object keeps its own body until it is added to a scene
+	// Velocity and acceleration start at 0
+	m_ownsBodies = bodies == nullptr;
+	m_bodies = m_ownsBodies ? new BodyStore() : bodies;
+	m_body = m_bodies->add(this, pos, mass, color, isStatic);
 }
 
 // Destructor
-Object::~Object()
+template <typename Real>
+BasicObject<Real>::~BasicObject()
 {
+	// Take the body out of the store it is in
+	if (m_ownsBodies)
+	{
+		delete m_bodies;
+	}
+	else if (m_bodies != nullptr)
+	{
+		// Unless the store has already compacted the body away
+		m_bodies->remove(m_body);
+	}
+}
+
+template <typename Real>
+void Physics::BasicObject<Real>::setBodyStore(BodyStore * bodies)
+{
+	// Moving out of a scene gives the object a store of its own again
+	bool ownsBodies = bodies == nullptr;
+	if (ownsBodies)
+	{
+		bodies = new BodyStore();
+	}
+	if (bodies == m_bodies) return;
+
+	BodyStore * previous = m_bodies;
+	m_body = bodies->moveFrom(*previous, m_body);
+	if (m_ownsBodies)
+	{
+		delete previous;
+	}
+	m_bodies = bodies;
+	m_ownsBodies = ownsBodies;
 }
 
 // This uses case statements to identify this object and the other object
-bool Physics::Object::isColliding(Object * other, vec3 & collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isColliding(Object * other, Vector & collisionNormal)
 {
 	// Case statement to identify this shape
 	switch (m_shape)
@@ -83,17 +119,18 @@ bool Physics::Object::isColliding(Object * other, vec3 & collisionNormal)
 	return false;
 }
 
-bool Physics::Object::isCollidingSphereSphere(Sphere * objA, Sphere * objB, vec3 &collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isCollidingSphereSphere(Sphere * objA, Sphere * objB, Vector & collisionNormal)
 {
 	// Checks that both object pointers are not null
 	assert(objA != nullptr);
 	assert(objB != nullptr);
 
 	// Find distance between centers
-	float distance = glm::distance(objB->getPosition(), objA->getPosition());
+	Real distance = glm::distance(objB->getPosition(), objA->getPosition());
 
 	// Add up the two radii
-	float radii = objA->getRadius() + objB->getRadius();
+	Real radii = objA->getRadius() + objB->getRadius();
 
 	// Checks if the distance is less than the radii
 	if (distance < radii)
@@ -109,11 +146,12 @@ bool Physics::Object::isCollidingSphereSphere(Sphere * objA, Sphere * objB, vec3
 
 }
 
-bool Physics::Object::isCollidingPlaneSphere(Plane * objA, Sphere * objB, vec3 &collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isCollidingPlaneSphere(Plane * objA, Sphere * objB, Vector & collisionNormal)
 {
 	// The distance is the dot product of the spherePosition and plane normal, minus the plane distance
 	// This projects the sphere distance onto the closest point on the plane
-	float distance = glm::dot(objB->getPosition(), objA->getDirection()) - objA->getDistance();
+	Real distance = glm::dot(objB->getPosition(), objA->getDirection()) - objA->getDistance();
 
 	// If the distance is less than the radius of the sphere, there is a collision
 	if (distance < objB->getRadius())
@@ -121,23 +159,18 @@ bool Physics::Object::isCollidingPlaneSphere(Plane * objA, Sphere * objB, vec3 &
 		// Assigns the collision normal, which for plane - sphere collison is always the plane normal
 		collisionNormal = objA->getDirection();
 
-		// Seperate the sphere from the plane if they are overlapping
-		objB->setPosition(objB->getPosition() + collisionNormal * (objB->getRadius() -  distance));
+		// The sphere is separated from the plane when the collision is resolved, so detection doesn't change any objects
 		return true;
 	}
 	return false;
 }
 
-bool Physics::Object::isCollidingPlaneAABB(Plane * objA, AABB * objB, vec3 & collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isCollidingPlaneAABB(Plane * objA, AABB * objB, Vector & collisionNormal)
 {
 	// Get the distance of the AABB from the plane
-	float distance = glm::dot(objB->getPosition(), objA->getDirection()) - objA->getDistance();
+	Real distance = glm::dot(objB->getPosition(), objA->getDirection()) - objA->getDistance();
 
-	// Calculate the "radius" of the AABB but projecting each axis along the plane normal
-	float radius =	glm::dot(objB->getExtents().x, objA->getDirection().x) +
-					glm::dot(objB->getExtents().y, objA->getDirection().y) +
-					glm::dot(objB->getExtents().z, objA->getDirection().z);
-	
 	// If it is not touching on every axis, there is no collision
 	if (distance > objB->getExtents().x || distance > objB->getExtents().y || distance > objB->getExtents().z)
 	{
@@ -148,23 +181,23 @@ bool Physics::Object::isCollidingPlaneAABB(Plane * objA, AABB * objB, vec3 & col
 		// The collision normal is the plane normal
 		collisionNormal = objA->getDirection();
 
-		// Separation 
-		objB->setPosition(objB->getPosition() + collisionNormal * (radius - distance));
+		// Separated when the collision is resolved
 		return true;
 	}
 	return false;
 }
 
-bool Physics::Object::isCollidingAABBAABB(AABB * objA, AABB * objB, vec3 & collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isCollidingAABBAABB(AABB * objA, AABB * objB, Vector & collisionNormal)
 {
 	// Displacement
-	vec3 distance = objB->getPosition() - objA->getPosition();
+	Vector distance = objB->getPosition() - objA->getPosition();
 
 	// Get the absolute value of the distance to account for objB being behind objA
-	vec3 absDistance = glm::abs(distance);
+	Vector absDistance = glm::abs(distance);
 
 	// The sum of the extents of both AABBs, 
-	vec3 totalExtents = objA->getExtents() + objB->getExtents();
+	Vector totalExtents = objA->getExtents() + objB->getExtents();
 
 	// If the distance is larger than the total extent on any axis, there is no collision
 	if (absDistance.x > totalExtents.x || absDistance.y > totalExtents.y || absDistance.z > totalExtents.z)
@@ -174,37 +207,38 @@ bool Physics::Object::isCollidingAABBAABB(AABB * objA, AABB * objB, vec3 & colli
 	}
 
 	// Get the overlap
-	glm::vec3 overlap = totalExtents - absDistance;
+	Vector overlap = totalExtents - absDistance;
 
 	// The axis with the smallest overlap is the axis the collision is happening on, thereby determining the collision normal
-	float smallestOverlap = glm::min(glm::min(overlap.x, overlap.y), overlap.z);
+	Real smallestOverlap = glm::min(glm::min(overlap.x, overlap.y), overlap.z);
 
 	if (smallestOverlap == overlap.x)
 	{ 
 		// Multiply the collision normal but the sign of the distance, if the distance is negative, the collision normal will be negated
-		collisionNormal = glm::vec3(1, 0, 0) * glm::sign(distance.x);
+		collisionNormal = Vector(1, 0, 0) * glm::sign(distance.x);
 	}
 	else if (smallestOverlap == overlap.y)
 	{
-		collisionNormal = glm::vec3(0, 1, 0) * glm::sign(distance.y);
+		collisionNormal = Vector(0, 1, 0) * glm::sign(distance.y);
 	}
 	else  // z
 	{
-		collisionNormal = glm::vec3(0, 0, 1) * glm::sign(distance.z);
+		collisionNormal = Vector(0, 0, 1) * glm::sign(distance.z);
 	}
 	return true;
 }
 
-bool Physics::Object::isCollidingSphereAABB(Sphere * objA, AABB * objB, vec3 & collisionNormal)
+template <typename Real>
+bool Physics::BasicObject<Real>::isCollidingSphereAABB(Sphere * objA, AABB * objB, Vector & collisionNormal)
 {
 	// Displacement
-	vec3 distance = objB->getPosition() - objA->getPosition();
+	Vector distance = objB->getPosition() - objA->getPosition();
 
 	// Get the absolute value of the distance to account for objB being behind objA
-	vec3 absDistance = glm::abs(distance);
+	Vector absDistance = glm::abs(distance);
 
 	// The sum of the extents of both AABBs, 
-	vec3 totalExtents = objA->getRadius() + objB->getExtents();
+	Vector totalExtents = objA->getRadius() + objB->getExtents();
 
 	// If the distance is larger than the total extent on any axis, there is no collision
 	if (absDistance.x > totalExtents.x || absDistance.y > totalExtents.y || absDistance.z > totalExtents.z)
@@ -214,54 +248,40 @@ bool Physics::Object::isCollidingSphereAABB(Sphere * objA, AABB * objB, vec3 & c
 	}
 
 	// Get the overlap
-	glm::vec3 overlap = totalExtents - absDistance;
+	Vector overlap = totalExtents - absDistance;
 
 	// The axis with the smallest overlap is the axis the collision is happening on, thereby determining the collision normal
-	float smallestOverlap = glm::min(glm::min(overlap.x, overlap.y), overlap.z);
+	Real smallestOverlap = glm::min(glm::min(overlap.x, overlap.y), overlap.z);
 
 	if (smallestOverlap == overlap.x)
 	{
-		collisionNormal = glm::vec3(1, 0, 0) * glm::sign(distance.x);
+		collisionNormal = Vector(1, 0, 0) * glm::sign(distance.x);
 	}
 	else if (smallestOverlap == overlap.y)
 	{
-		collisionNormal = glm::vec3(0, 1, 0) * glm::sign(distance.y);
+		collisionNormal = Vector(0, 1, 0) * glm::sign(distance.y);
 	}
 	else  // z
 	{
-		collisionNormal = glm::vec3(0, 0, 1) * glm::sign(distance.z);
+		collisionNormal = Vector(0, 0, 1) * glm::sign(distance.z);
 	}
 	return true;
 }
 
-void Object::update(float deltaTime)
-{
-	// If the object is not static, update
-	if (!m_isStatic)
-	{
-		// Apply friction (dampening)
-		applyForce(-m_velocity * m_friction);
-
-		// Increase velocity by acceleration times delta time
-		m_velocity += m_acceleration * deltaTime;
-
-		// Moves the object's position by velocity times delta time
-		m_position += m_velocity * deltaTime;
-
-		// Reset acceleration to zero
-		m_acceleration = vec3(); 
-	}
-}
-
-void Object::applyForce(const vec3 & force)
+template <typename Real>
+void Physics::BasicObject<Real>::applyForce(const Vector & force)
 {
-	// Increases acceleration by force divided my mass
+	// Increases acceleration by force divided my mass, static objects have an inverse mass of zero so aren't moved by forces
 	// Force = Mass * Acceleration
-	m_acceleration += force / m_mass; 
+	m_bodies->setAcceleration(m_body, getAcceleration() + force * m_bodies->getInverseMass(m_body));
 }
 
-void Physics::Object::applyImpulse(const vec3 & impulse)
+template <typename Real>
+void Physics::BasicObject<Real>::applyImpulse(const Vector & impulse)
 {
 	// Adds impulse to velocity, not altered by delta time
-	m_velocity += impulse;
+	setVelocity(getVelocity() + impulse);
 }
+
+template class Physics::BasicObject<float>;
+template class Physics::BasicObject<double>;
@@ -6,25 +6,35 @@
 using namespace Physics;
 using glm::vec3;
 
-Physics::Plane::Plane(float distance, vec3 direction, vec4 color) :  m_distance(distance), Object(Physics::ShapeType::PLANE, distance * direction, 0.f, color, true)
+template <typename Real>
+Physics::BasicPlane<Real>::BasicPlane(Real distance, Vector direction, vec4 color) :  m_distance(distance), BasicObject<Real>(Physics::ShapeType::PLANE, distance * direction, Real(0), color, true)
 {
 	// Ensures that the plane direction is normalised
 	m_direction = glm::normalize(direction);
 }
 
-Plane::~Plane()
+template <typename Real>
+BasicPlane<Real>::~BasicPlane()
 {
 }
 
-void Physics::Plane::draw()
+template <typename Real>
+void Physics::BasicPlane<Real>::draw(float)
+{
+	// Drawing is always done in float
+	drawPlane(vec3(m_direction), (float)m_distance, this->getColor());
+}
+
+template <typename Real>
+void Physics::BasicPlane<Real>::drawPlane(const vec3 & direction, float distance, const vec4 & color)
 {
 	// Float for how far the plane stretches from the center
 	float extents = 100.0f;
 
 	// Creates a rotational matrix based on the plane normal and up vector
-	glm::mat3 rot = glm::orientation(m_direction, vec3(0, 1, 0));
+	glm::mat3 rot = glm::orientation(direction, vec3(0, 1, 0));
 
-	glm::vec3 pos = m_direction * m_distance;
+	glm::vec3 pos = direction * distance;
 
 	// Calculates the vertices of the plane based on the extents and the rotation matrix
 	vec3 tr = pos + rot * vec3(extents, 0, extents);		// Top right
@@ -33,6 +43,9 @@ void Physics::Plane::draw()
 	vec3 tl = pos + rot * vec3(-extents, 0, extents);	// Top left
 
 	// Adds the triangles
-	aie::Gizmos::addTri(tr, br, bl, m_color);
-	aie::Gizmos::addTri(bl, tl, tr, m_color);
+	aie::Gizmos::addTri(tr, br, bl, color);
+	aie::Gizmos::addTri(bl, tl, tr, color);
 }
+
+template class Physics::BasicPlane<float>;
+template class Physics::BasicPlane<double>;
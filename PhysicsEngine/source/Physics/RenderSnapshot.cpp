@@ -0,0 +1,96 @@
+#include "Physics/RenderSnapshot.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/Plane.h"
+#include <Gizmos.h>
+using namespace Physics;
+
+Physics::RenderSnapshot::RenderSnapshot() :
+	m_stats(), m_alpha(0.0f), m_fixedTimeStep(1.0f), m_time()
+{
+}
+
+void Physics::RenderSnapshot::clear()
+{
+	m_objects.clear();
+	m_springs.clear();
+	m_cloths.clear();
+	m_particlePrevious.clear();
+	m_particleCurrent.clear();
+	m_stats = SnapshotStats();
+}
+
+void Physics::RenderSnapshot::addCloth(int rows, int columns, const vec4 & color)
+{
+	ClothEntry cloth = { rows, columns, (int)m_particleCurrent.size(), color };
+	m_cloths.push_back(cloth);
+}
+
+void Physics::RenderSnapshot::setTiming(float alpha, float fixedTimeStep, Clock::time_point time)
+{
+	m_alpha = alpha;
+	m_fixedTimeStep = fixedTimeStep;
+	m_time = time;
+}
+
+float Physics::RenderSnapshot::getAlpha(Clock::time_point now) const
+{
+	float elapsed = std::chrono::duration<float>(now - m_time).count();
+	return glm::clamp(m_alpha + elapsed / m_fixedTimeStep, 0.0f, 1.0f);
+}
+
+void Physics::RenderSnapshot::draw(float alpha) const
+{
+	// Draws the objects the same way their own draw functions do, at their own level of detail's alpha
+	for (auto & object : m_objects)
+	{
+		vec3 position = glm::mix(object.previous, object.current, object.alphaOffset + alpha * object.alphaScale);
+		switch (object.shape)
+		{
+		case ShapeType::SPHERE:
+			aie::Gizmos::addSphere(position, object.size.x, 12, 12, object.color);
+			break;
+		case ShapeType::AABB:
+			aie::Gizmos::addAABBFilled(position, object.size, object.color);
+			break;
+		case ShapeType::PLANE:
+			Plane::drawPlane(object.size, object.distance, object.color);
+			break;
+		}
+	}
+
+	// Draws the springs as lines between their blended ends
+	for (auto & spring : m_springs)
+	{
+		float springAlpha = spring.alphaOffset + alpha * spring.alphaScale;
+		aie::Gizmos::addLine(glm::mix(spring.previousA, spring.currentA, springAlpha), glm::mix(spring.previousB, spring.currentB, springAlpha), vec4(1.f, 1.f, 1.f, 1.f));
+	}
+
+	// Draws a line for each structural spring of the cloths, which are stepped every fixed step
+	for (auto & cloth : m_cloths)
+	{
+		auto interpolated = [&](int i)
+		{
+			return glm::mix(m_particlePrevious[cloth.first + i], m_particleCurrent[cloth.first + i], alpha);
+		};
+		for (int row = 0; row < cloth.rows; row++)
+		{
+			for (int column = 0; column < cloth.columns; column++)
+			{
+				int i = row * cloth.columns + column;
+				if (column + 1 < cloth.columns)
+				{
+					aie::Gizmos::addLine(interpolated(i), interpolated(i + 1), cloth.color);
+				}
+				if (row + 1 < cloth.rows)
+				{
+					aie::Gizmos::addLine(interpolated(i), interpolated(i + cloth.columns), cloth.color);
+				}
+			}
+		}
+	}
+}
+
+size_t Physics::RenderSnapshot::getMemoryBytes() const
+{
+	return getVectorBytes(m_objects) + getVectorBytes(m_springs) + getVectorBytes(m_cloths) + getVectorBytes(m_particlePrevious) + getVectorBytes(m_particleCurrent);
+}
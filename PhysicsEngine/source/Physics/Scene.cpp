@@ -2,128 +2,1976 @@
 #include "Physics/Object.h"
 #include "Physics/Sphere.h"
 #include "Physics/Plane.h"
+#include "Physics/AABB.h"
+#include "Physics/AllocationTracker.h"
+#include "Physics/Cloth.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/RenderSnapshot.h"
 #include "Physics/Spring.h"
+#include "Physics/SpringKernel.h"
+#include "Physics/Tether.h"
+#include "Physics/WorkerPool.h"
 #include <Gizmos.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace Physics;
 using glm::vec4;
 
-Scene::Scene()
+// The number of items each chunk of a parallel phase works on. It doesn't depend on the thread count
+// so the chunks, and the order their results are joined in, are the same however many threads there are
+static const size_t PARALLEL_CHUNK_SIZE = 64;
+
+template <typename Real>
+Physics::BasicScene<Real>::BasicScene(IntegratorType integrator) : m_integrator(integrator)
+{
+	// Default gravity just in case
+	m_gravity = Vector(Real(0), Real(-9.8), Real(0));
+
+	//Defaults for fixed time at 100fps
+	m_fixedTimeStep = Real(0.01);
+
+	// Springs default to the same rate as everything else
+	m_requestedSpringTimeStep = m_fixedTimeStep;
+	m_springSubsteps = 1;
+	m_subsystemsDirty = true;
+
+	// Auto time step is off until asked for, the limits keep it between 1000Hz and 30Hz
+	m_autoTimeStep = false;
+	m_safetyFactor = Real(0.5);
+	m_minTimeStep = Real(0.001);
+	m_maxTimeStep = Real(1) / Real(30);
+	m_springTimeStepBound = FLT_MAX;
+
+	// Level of detail is effectively off until distances are given
+	m_lodFocus = Vector();
+	m_lodDistances[0] = FLT_MAX;
+	m_lodDistances[1] = FLT_MAX;
+	m_lodStats = LODStats();
+	m_restingLengthRelaxTime = Real(1);
+	m_stepIndex = 0;
+	m_objectSteps = 0;
+	m_bodySteps = 0;
+
+	// Long range attachments are off until asked for
+	m_tethersDirty = false;
+	m_longRangeAttachments = false;
+	m_tetherSlack = Real(0);
+
+	// Single threaded and not deterministic until asked for
+	m_workers = nullptr;
+	m_schedulerStats = SchedulerStats();
+	m_deterministic = false;
+	m_stateHash = 0;
+
+	// Symplectic Euler scenes use the fused kernel for their springs
+	m_fusedSpringKernel = true;
+	m_integrateTime = 0.0f;
+
+	// Set accumulated time to 0
+	m_accumulatedTime = Real(0);
+
+	// Zero the global force
+	m_globalForce = Vector();
+
+	// No updates yet
+	m_lastUpdateTime = 0.0f;
+	m_lastStepCount = 0;
+	m_lastUpdateAllocations = 0;
+	m_allocationGuard = false;
+	m_allocationGuardAsserts = true;
+	m_allocationGuardFailures = 0;
+
+	// No commands sent yet
+	m_droppedCommands = 0;
+	m_droppedSpawnResults = 0;
+	m_commandStats = CommandStats();
+
+	// Select the integrate instantiation for the chosen policy
+	switch (m_integrator)
+	{
+	case IntegratorType::VELOCITY_VERLET:
+		m_addIntegrationTasks = &BasicScene::addIntegrationTasks<VelocityVerlet>;
+		m_stabilityLimit = VelocityVerlet::stabilityLimit;
+		break;
+	case IntegratorType::RK4:
+		m_addIntegrationTasks = &BasicScene::addIntegrationTasks<RungeKutta4>;
+		m_stabilityLimit = RungeKutta4::stabilityLimit;
+		break;
+	default:
+		m_addIntegrationTasks = &BasicScene::addIntegrationTasks<SymplecticEuler>;
+		m_stabilityLimit = SymplecticEuler::stabilityLimit;
+		break;
+	}
+}
+
+
+template <typename Real>
+Physics::BasicScene<Real>::~BasicScene()
+{
+	// Delete what was never applied
+	for (auto & queued : m_queuedSprings)
+	{
+		destroySpring(queued.spring, queued.pooled);
+	}
+	for (auto & queued : m_queuedObjects)
+	{
+		destroyObject(queued.object, queued.pooled);
+	}
+	for (auto cloth : m_queuedCloths)
+	{
+		delete cloth;
+	}
+
+	// Delete all cloths
+	for (auto cloth : m_cloths)
+	{
+		delete cloth;
+	}
+
+	// Delete all springs
+	for (size_t i = 0; i < m_springs.size(); i++)
+	{
+		destroySpring(m_springs[i], m_pooledSprings[i]);
+	}
+
+	// Delete the generated tethers
+	for (auto tether : m_tethers)
+	{
+		delete tether;
+	}
+
+	// Stop the worker threads
+	delete m_workers;
+
+	for (auto buffer : m_gizmoBuffers)
+	{
+		delete buffer;
+	}
+
+	// Delete all objects
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		destroyObject(m_objects[i], m_pooledObjects[i]);
+	}
+}
+
+template <typename Real>
+template <typename Body>
+void Physics::BasicScene<Real>::parallelFor(size_t count, Body body)
+{
+	// Small ranges aren't worth waking the workers for
+	if (m_workers == nullptr || count <= PARALLEL_CHUNK_SIZE)
+	{
+		body((size_t)0, count);
+		return;
+	}
+
+	int chunkCount = (int)((count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE);
+	m_workers->run(chunkCount, [&](int chunk, int)
+	{
+		size_t begin = chunk * PARALLEL_CHUNK_SIZE;
+		body(begin, glm::min(begin + PARALLEL_CHUNK_SIZE, count));
+	});
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::update(float deltaTime)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	uint64_t startAllocations = AllocationTracker::getAllocationCount();
+	m_lastStepCount = 0;
+	m_objectSteps = 0;
+	m_bodySteps = 0;
+	m_integrateTime = 0.0f;
+	m_lodStats.skippedSteps = 0;
+	m_schedulerStats = SchedulerStats();
+	m_schedulerStats.threadCount = getThreadCount();
+	m_commandStats = CommandStats();
+	m_commandStats.droppedCount = m_droppedCommands.load();
+	m_commandStats.droppedResultCount = m_droppedSpawnResults;
+
+	// Increase accumulated time by delta time
+	m_accumulatedTime += deltaTime;
+
+	// Apply what was added and removed since the last update, then make sure objects are stepped with the right subsystem
+	applyCommands();
+	refreshSubsystems();
+
+	// Choose the time steps for this update
+	if (m_autoTimeStep)
+	{
+		applyAutoTimeStep();
+	}
+
+	// Each iteration uses m_fixedTimeStep as delta time
+	// The loop continues until the sum of fixed time steps is equal to or less than m_accumulated time
+	while (m_accumulatedTime >= m_fixedTimeStep)
+	{
+		// Commands sent since the last step are applied at the start of this one, along with what they added and removed
+		if (applyQueuedCommands())
+		{
+			applyCommands();
+		}
+
+		// Objects and springs applied after the last step change the subsystems
+		refreshSubsystems();
+
+		// Levels of detail can only change when every level has just finished a step
+		if (m_stepIndex % (1 << (LOD_LEVELS - 1)) == 0)
+		{
+			assignLOD();
+		}
+
+		// Restored detail springs ease back to their own resting lengths
+		relaxRestingLengths(m_fixedTimeStep);
+
+		// Moves all objects with the scene's integrator, this also applies gravity, friction and springs
+		m_stepGraph.clear();
+		(this->*m_addIntegrationTasks)(m_fixedTimeStep);
+
+		// Collisions wait for every object to have moved
+		int collisionTask = m_stepGraph.add("Collisions", 1, [this](int, int)
+		{
+			// Collisions are only kept for the step, so they are taken from the frame arena
+			ArenaVector<Collision> collisions = ArenaVector<Collision>(ArenaAllocator<Collision>(&m_frameArena));
+
+			// Check for collisions
+			checkCollision(collisions);
+
+			// Resolve collisions
+			resolveCollision(collisions);
+		});
+		for (int task = 0; task < collisionTask; task++)
+		{
+			m_stepGraph.addDependency(task, collisionTask);
+		}
+
+		// Cloths take the finest level's spring substeps, whichever integrator the objects use
+		Real clothTimeStep = m_fixedTimeStep;
+		int clothSubsteps = getSpringSubsteps(0);
+		for (auto cloth : m_cloths)
+		{
+			m_stepGraph.add("Cloth", 1, [this, cloth, clothTimeStep, clothSubsteps](int, int)
+			{
+				auto forEach = [this](size_t count, auto body) { parallelFor(count, body); };
+				cloth->step(clothTimeStep, clothSubsteps, m_gravity, m_frameArena, forEach);
+			});
+		}
+
+		m_stepGraph.run(m_workers);
+
+		// Integration lasts until the last of its tasks has finished
+		float integrateTime = 0.0f;
+		for (int task = 0; task < m_stepGraph.getTaskCount(); task++)
+		{
+			if (task != collisionTask)
+			{
+				integrateTime = glm::max(integrateTime, m_stepGraph.getTaskEnd(task));
+			}
+		}
+		m_integrateTime += integrateTime;
+
+		const SchedulerStats & stepStats = m_stepGraph.getLastRunStats();
+		m_schedulerStats.taskCount += stepStats.taskCount;
+		m_schedulerStats.chunkCount += stepStats.chunkCount;
+		m_schedulerStats.stealCount += stepStats.stealCount;
+		m_schedulerStats.wallTime += stepStats.wallTime;
+		m_schedulerStats.jobTime += stepStats.jobTime;
+
+		// Decrement the accumulated time
+		m_accumulatedTime -= m_fixedTimeStep;
+
+		// Everything taken from the arena during the step is finished with
+		m_frameArena.reset();
+
+		// Anything added or removed during the step is applied between steps
+		applyCommands();
+
+		// Record the state so runs can be compared
+		if (m_deterministic)
+		{
+			computeStateHash();
+		}
+
+		m_lastStepCount++;
+		m_stepIndex++;
+	}
+
+	// Estimate how long the skipped object steps would have taken from the average cost of the ones that were taken
+	m_lodStats.timeSaved = m_objectSteps > 0 ? m_lodStats.skippedSteps * m_integrateTime / m_objectSteps : 0.0f;
+
+	m_lastUpdateTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	// Counts allocations on every thread, so the scene's own workers are included
+	m_lastUpdateAllocations = (int)(AllocationTracker::getAllocationCount() - startAllocations);
+	if (m_allocationGuard && m_lastUpdateAllocations > 0)
+	{
+		m_allocationGuardFailures++;
+		assert(!m_allocationGuardAsserts && "Scene::update allocated with the allocation guard on");
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::refreshSubsystems()
+{
+	if (!m_subsystemsDirty) return;
+	updateSubsystems();
+
+	// New springs or objects change the stable spring step
+	m_springTimeStepBound = computeSpringTimeStepBound();
+}
+
+template <typename Real>
+template <typename Integrator>
+void Physics::BasicScene<Real>::addIntegrationTasks(Real deltaTime)
+{
+	// Forces applied from outside the step, such as the global force, have been accumulated as acceleration
+	// They are turned into velocity first so the integrator only has to deal with the forces it evaluates itself
+	// This is a synchronisation point, so both subsystems receive them for the whole step
+	// Every body in the store is in the scene, so this runs straight along the arrays
+	size_t bodyCount = m_bodies.size();
+	int chunkCount = (int)((bodyCount + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE);
+	int accelerationTask = m_stepGraph.add("Accelerations", chunkCount, [this, deltaTime, bodyCount](int chunk, int)
+	{
+		size_t begin = chunk * PARALLEL_CHUNK_SIZE;
+		size_t end = glm::min(begin + PARALLEL_CHUNK_SIZE, bodyCount);
+		for (int body = (int)begin; body < (int)end; body++)
+		{
+			if (!m_bodies.getIsStatic(body))
+			{
+				m_bodies.setVelocity(body, m_bodies.getVelocity(body) + m_bodies.getAcceleration(body) * deltaTime);
+			}
+			m_bodies.setAcceleration(body, Vector());
+		}
+	});
+
+	static const char * RIGID_TASK_NAMES[LOD_LEVELS] = { "Rigid objects 0", "Rigid objects 1", "Rigid objects 2" };
+	static const char * SPRING_TASK_NAMES[LOD_LEVELS] = { "Springs 0", "Springs 1", "Springs 2" };
+	for (int level = 0; level < LOD_LEVELS; level++)
+	{
+		size_t rigidCount = m_lodRigidBodies[level].size();
+		size_t springCount = m_lodSpringBodies[level].size();
+
+		// Each level is stepped every 2^level fixed steps, with a time step that covers all of them
+		int interval = 1 << level;
+		if (m_stepIndex % interval != 0)
+		{
+			m_lodStats.skippedSteps += (int)(rigidCount + springCount);
+			continue;
+		}
+		Real levelTimeStep = deltaTime * interval;
+		m_objectSteps += (int)(rigidCount + springCount);
+
+		// Objects attached to springs take several smaller steps that together cover the same time
+		int substeps = getSpringSubsteps(level);
+		Real springTimeStep = levelTimeStep / substeps;
+		m_bodySteps += (int)(rigidCount + springCount * substeps);
+
+		// The rigid objects and the islands share no bodies, so their tasks can run at the same time
+		int rigidTask = m_stepGraph.add(RIGID_TASK_NAMES[level], 1, [this, level, levelTimeStep](int, int)
+		{
+			stepRigidObjects<Integrator>(level, levelTimeStep);
+		});
+		int springTask = m_stepGraph.add(SPRING_TASK_NAMES[level], 1, [this, level, springTimeStep, substeps](int, int)
+		{
+			stepSprings<Integrator>(level, springTimeStep, substeps);
+		});
+		m_stepGraph.addDependency(accelerationTask, rigidTask);
+		m_stepGraph.addDependency(accelerationTask, springTask);
+	}
+}
+
+template <typename Real>
+template <typename Integrator>
+void Physics::BasicScene<Real>::stepRigidObjects(int level, Real deltaTime)
+{
+	vector<int> & rigidBodies = m_lodRigidBodies[level];
+
+	// Keep the state from before this step so draw can blend between the two
+	parallelFor(rigidBodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			m_bodies.storePreviousPosition(rigidBodies[i]);
+		}
+	});
+
+	// Objects that aren't attached to springs take a single step
+	auto forEach = [this](size_t count, auto body) { parallelFor(count, body); };
+	Integrator::step(m_bodies, rigidBodies, deltaTime, [&]() { computeForces(rigidBodies, nullptr, nullptr); }, forEach, m_lodRigidScratch[level]);
+}
+
+template <typename Real>
+template <typename Integrator>
+void Physics::BasicScene<Real>::stepSprings(int level, Real deltaTime, int substeps)
+{
+	vector<int> & springBodies = m_lodSpringBodies[level];
+	vector<Spring *> & springs = m_lodSprings[level];
+	SpringArrays & springArrays = m_lodSpringArrays[level];
+	SpringAdjacency & adjacency = m_lodSpringAdjacency[level];
+
+	parallelFor(springBodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			m_bodies.storePreviousPosition(springBodies[i]);
+		}
+	});
+
+	// The spring forces are only needed for this level's substeps
+	springArrays.forceX = m_frameArena.allocate<Real>(springs.size());
+	springArrays.forceY = m_frameArena.allocate<Real>(springs.size());
+	springArrays.forceZ = m_frameArena.allocate<Real>(springs.size());
+	if (m_fusedSpringKernel && std::is_same<Integrator, SymplecticEuler>::value)
+	{
+		stepSpringsFused(level, deltaTime, substeps);
+		return;
+	}
+
+	auto forEach = [this](size_t count, auto body) { parallelFor(count, body); };
+	for (int i = 0; i < substeps; i++)
+	{
+		Integrator::step(m_bodies, springBodies, deltaTime, [&]() { computeForces(springBodies, &springArrays, &adjacency); }, forEach, m_lodSpringScratch[level]);
+
+		// Pull anything that has moved too far from its pins back
+		for (auto tether : m_lodTethers[level])
+		{
+			tether->apply();
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::stepSpringsFused(int level, Real deltaTime, int substeps)
+{
+	vector<int> & bodies = m_lodSpringBodies[level];
+	SpringArrays & springs = m_lodSpringArrays[level];
+	SpringAdjacency & adjacency = m_lodSpringAdjacency[level];
+	FusedSprings & fused = m_lodFusedSprings[level];
+
+	// Copy the state in
+	parallelFor(bodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			fused.setPosition((int)i, m_bodies.getPosition(bodies[i]));
+			fused.setVelocity((int)i, m_bodies.getVelocity(bodies[i]));
+			fused.inverseMass[i] = m_bodies.getInverseMass(bodies[i]);
+			fused.friction[i] = m_bodies.getFriction(bodies[i]);
+		}
+	});
+
+	// The kernel reads the packed state through the springs' indices into the level
+	SpringBatch<Real> batch = { springs.localA.data(), springs.localB.data(), springs.restingLength.data(), springs.springCoefficient.data(), springs.damping.data(),
+		fused.positionX.data(), fused.positionY.data(), fused.positionZ.data(), fused.velocityX.data(), fused.velocityY.data(), fused.velocityZ.data(),
+		springs.forceX, springs.forceY, springs.forceZ };
+
+	for (int substep = 0; substep < substeps; substep++)
+	{
+		// The force of each spring on its object A
+		parallelFor(springs.localA.size(), [&](size_t begin, size_t end)
+		{
+			computeSpringForces(batch, begin, end);
+		});
+
+		// Gravity, friction and the spring forces, then the symplectic Euler step, in one pass over the objects
+		parallelFor(bodies.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (fused.inverseMass[i] == Real(0)) continue;
+
+				Vector velocity = fused.getVelocity((int)i);
+				Vector force = -velocity * fused.friction[i];
+				for (int entry = adjacency.offsets[i]; entry < adjacency.offsets[i + 1]; entry++)
+				{
+					int spring = adjacency.entries[entry];
+					Vector springForce(springs.forceX[spring >> 1], springs.forceY[spring >> 1], springs.forceZ[spring >> 1]);
+					force += (spring & 1) ? -springForce : springForce;
+				}
+				velocity += (m_gravity + force * fused.inverseMass[i]) * deltaTime;
+				fused.setVelocity((int)i, velocity);
+				fused.setPosition((int)i, fused.getPosition((int)i) + velocity * deltaTime);
+			}
+		});
+
+		// Pull anything that has moved too far from its pins back, the same as Tether::apply
+		for (size_t i = 0; i < fused.tetherObject.size(); i++)
+		{
+			int object = fused.tetherObject[i];
+			int anchor = fused.tetherAnchor[i];
+			if (fused.inverseMass[object] == Real(0)) continue;
+
+			Vector offset = fused.getPosition(object) - fused.getPosition(anchor);
+			Real distance = glm::length(offset);
+			if (distance <= fused.tetherMaxDistance[i]) continue;
+
+			Vector direction = offset / distance;
+			fused.setPosition(object, fused.getPosition(anchor) + direction * fused.tetherMaxDistance[i]);
+			Real outwardSpeed = glm::dot(fused.getVelocity(object) - fused.getVelocity(anchor), direction);
+			if (outwardSpeed > Real(0))
+			{
+				fused.setVelocity(object, fused.getVelocity(object) - direction * outwardSpeed);
+			}
+		}
+	}
+
+	// Copy the state back out
+	parallelFor(bodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			m_bodies.setPosition(bodies[i], fused.getPosition((int)i));
+			m_bodies.setVelocity(bodies[i], fused.getVelocity((int)i));
+			m_bodies.setAcceleration(bodies[i], Vector());
+		}
+	});
+}
+
+template <typename Real>
+int Physics::BasicScene<Real>::getSpringSubsteps(int level) const
+{
+	if (level == 0)
+	{
+		return m_springSubsteps;
+	}
+
+	// Coarser levels scale the spring step up with the level, but never past what the springs can take
+	Real levelTimeStep = m_fixedTimeStep * (1 << level);
+	Real springTimeStep = glm::min(getSpringTimeStep() * (1 << level), glm::max(getSpringTimeStep(), m_springTimeStepBound * m_safetyFactor));
+	return glm::max(1, (int)std::ceil(levelTimeStep / springTimeStep - Real(0.001)));
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::computeForces(const vector<int> & bodies, const SpringArrays * springs, const SpringAdjacency * adjacency)
+{
+	// Applies gravity to the objects
+	applyGravity(bodies);
+
+	// Apply friction (dampening) as a force against the velocity
+	parallelFor(bodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			int body = bodies[i];
+			if (!m_bodies.getIsStatic(body))
+			{
+				m_bodies.setAcceleration(body, m_bodies.getAcceleration(body) - m_bodies.getVelocity(body) * (m_bodies.getFriction(body) * m_bodies.getInverseMass(body)));
+			}
+		}
+	});
+
+	if (springs == nullptr) return;
+
+	// Springs apply their force to both objects they connect. The forces are worked out for every spring first,
+	// then each object adds up the forces of its own springs, so no two threads write to the same object and the
+	// forces are always added in the same order
+	SpringBatch<Real> batch = { springs->bodyA.data(), springs->bodyB.data(), springs->restingLength.data(), springs->springCoefficient.data(), springs->damping.data(),
+		m_bodies.getPositionArray(0), m_bodies.getPositionArray(1), m_bodies.getPositionArray(2),
+		m_bodies.getVelocityArray(0), m_bodies.getVelocityArray(1), m_bodies.getVelocityArray(2),
+		springs->forceX, springs->forceY, springs->forceZ };
+	parallelFor(springs->bodyA.size(), [&](size_t begin, size_t end)
+	{
+		computeSpringForces(batch, begin, end);
+	});
+	parallelFor(bodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			int body = bodies[i];
+			Vector force = Vector();
+			for (int entry = adjacency->offsets[i]; entry < adjacency->offsets[i + 1]; entry++)
+			{
+				// Object B receives the opposite of the force on object A
+				int spring = adjacency->entries[entry];
+				Vector springForce(springs->forceX[spring >> 1], springs->forceY[spring >> 1], springs->forceZ[spring >> 1]);
+				force += (spring & 1) ? -springForce : springForce;
+			}
+			// Static bodies have an inverse mass of zero, so they aren't moved
+			m_bodies.setAcceleration(body, m_bodies.getAcceleration(body) + force * m_bodies.getInverseMass(body));
+		}
+	});
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setThreadCount(int threadCount)
+{
+	delete m_workers;
+	m_workers = threadCount > 1 ? new WorkerPool(threadCount) : nullptr;
+}
+
+template <typename Real>
+int Physics::BasicScene<Real>::getThreadCount() const
+{
+	return m_workers != nullptr ? m_workers->getThreadCount() : 1;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::computeStateHash()
+{
+	// FNV-1a over the bits of every position and velocity component, a word at a time
+	uint64_t hash = 14695981039346656037ull;
+	auto hashVector = [&hash](const Vector & vector)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			// A double component is two words
+			uint32_t bits[sizeof(Real) / sizeof(uint32_t)];
+			memcpy(bits, &vector[i], sizeof(bits));
+			for (auto word : bits)
+			{
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+		}
+	};
+
+	for (auto object : m_objects)
+	{
+		hashVector(object->getPosition());
+		hashVector(object->getVelocity());
+	}
+	for (auto cloth : m_cloths)
+	{
+		hash = cloth->hashState(hash);
+	}
+	m_stateHash = hash;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setFixedTimeStep(Real timeStep)
+{
+	m_fixedTimeStep = timeStep;
+
+	// Keep the spring rate as close as possible to what was asked for
+	setSpringTimeStep(m_requestedSpringTimeStep);
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setSpringTimeStep(Real timeStep)
+{
+	m_requestedSpringTimeStep = timeStep;
+
+	// Round the number of substeps up so the springs never step at more than the requested time step,
+	// the small tolerance stops 1/60 and 1/240 turning into 5 substeps through rounding error
+	m_springSubsteps = (int)std::ceil(m_fixedTimeStep / timeStep - Real(0.001));
+	if (m_springSubsteps < 1)
+	{
+		m_springSubsteps = 1;
+	}
+}
+
+template <typename Real>
+TimeStepAnalysis Physics::BasicScene<Real>::analyseTimeStep() const
+{
+	TimeStepAnalysis analysis;
+	analysis.springTimeStep = computeSpringTimeStepBound();
+	analysis.rigidTimeStep = computeRigidTimeStepBound();
+	return analysis;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setAutoTimeStep(bool enabled, Real safetyFactor)
+{
+	m_autoTimeStep = enabled;
+	m_safetyFactor = safetyFactor;
+
+	// Recalculate the spring bound on the next update
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+Real Physics::BasicScene<Real>::computeSpringTimeStepBound() const
+{
+	// Per object, the sum over its springs of stiffness and damping divided by the mass each spring sees.
+	// By Gershgorin's theorem the fastest mode of the whole spring network can't oscillate faster than the
+	// largest of these sums, so it bounds every spring's frequency without solving for the modes
+	struct SpringLoad
+	{
+		Real stiffness = Real(0);	// Sum of k * (1/mA + 1/mB), omega squared
+		Real damping = Real(0);	// Sum of c * (1/mA + 1/mB) plus friction / m, in 1/s
+	};
+	std::unordered_map<Object *, SpringLoad> loads;
+
+	for (auto spring : m_springs)
+	{
+		Object * objA = spring->getObjectA();
+		Object * objB = spring->getObjectB();
+
+		// Static objects don't move so they add nothing to the inverse mass
+		Real inverseMassA = objA->getIsStatic() ? Real(0) : Real(1) / objA->getMass();
+		Real inverseMassB = objB->getIsStatic() ? Real(0) : Real(1) / objB->getMass();
+		Real inverseMass = inverseMassA + inverseMassB;
+
+		if (!objA->getIsStatic())
+		{
+			loads[objA].stiffness += spring->getSpringCoefficient() * inverseMass;
+			loads[objA].damping += spring->getDamping() * inverseMass;
+		}
+		if (!objB->getIsStatic())
+		{
+			loads[objB].stiffness += spring->getSpringCoefficient() * inverseMass;
+			loads[objB].damping += spring->getDamping() * inverseMass;
+		}
+	}
+
+	Real bound = FLT_MAX;
+	for (auto & load : loads)
+	{
+		if (load.second.stiffness <= Real(0)) continue;
+
+		// Friction damps the object as well
+		Real damping = load.second.damping + load.first->getFriction() / load.first->getMass();
+
+		// For an explicit integrator a damped oscillator is stable while
+		// dt <= limit / omega * (sqrt(1 + zeta^2) - zeta), where zeta is the damping ratio
+		Real omega = std::sqrt(load.second.stiffness);
+		Real zeta = damping / (Real(2) * omega);
+		Real timeStep = m_stabilityLimit / omega * (std::sqrt(Real(1) + zeta * zeta) - zeta);
+		bound = glm::min(bound, timeStep);
+	}
+	return bound;
+}
+
+template <typename Real>
+Real Physics::BasicScene<Real>::computeRigidTimeStepBound() const
+{
+	// Like the CFL condition, no object should travel further than its own size in a step or it can pass through others
+	Real bound = FLT_MAX;
+	for (auto object : m_objects)
+	{
+		if (object->getIsStatic()) continue;
+
+		Real speed = glm::length(object->getVelocity());
+		if (speed <= Real(0)) continue;
+
+		// The smallest distance from the centre of the object to its surface
+		Real size = Real(0);
+		switch (object->getShapeType())
+		{
+		case ShapeType::SPHERE:
+			size = ((Sphere *)object)->getRadius();
+			break;
+		case ShapeType::AABB:
+		{
+			const Vector & extents = ((AABB *)object)->getExtents();
+			size = glm::min(glm::min(extents.x, extents.y), extents.z);
+			break;
+		}
+		default:
+			continue;
+		}
+		bound = glm::min(bound, size / speed);
+	}
+	return bound;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::applyAutoTimeStep()
+{
+	// The rigid bodies take the largest safe step within the limits
+	Real fixedTimeStep = glm::clamp(computeRigidTimeStepBound() * m_safetyFactor, m_minTimeStep, m_maxTimeStep);
+
+	// The springs take the largest stable step, but never more than the fixed step
+	Real springTimeStep = glm::min(m_springTimeStepBound * m_safetyFactor, fixedTimeStep);
+
+	if (fixedTimeStep != m_fixedTimeStep || springTimeStep != m_requestedSpringTimeStep)
+	{
+		m_fixedTimeStep = fixedTimeStep;
+		setSpringTimeStep(springTimeStep);
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::updateSubsystems()
+{
+	MemoryScope scope(MemoryCategory::SUBSYSTEMS);
+
+	// Find the islands of objects connected by springs with a union-find over the springs
+	std::unordered_map<Object *, int> objectIndex;
+	for (int i = 0; i < (int)m_objects.size(); i++)
+	{
+		objectIndex[m_objects[i]] = i;
+	}
+
+	vector<int> parent(m_objects.size());
+	for (int i = 0; i < (int)parent.size(); i++)
+	{
+		parent[i] = i;
+	}
+	auto findRoot = [&parent](int i)
+	{
+		while (parent[i] != i)
+		{
+			// Path halving keeps the trees flat
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+
+	vector<bool> attached(m_objects.size(), false);
+	for (auto spring : m_springs)
+	{
+		// Springs attached to objects that aren't in the scene can't be stepped
+		auto iterA = objectIndex.find(spring->getObjectA());
+		auto iterB = objectIndex.find(spring->getObjectB());
+		if (iterA == objectIndex.end() || iterB == objectIndex.end()) continue;
+
+		attached[iterA->second] = true;
+		attached[iterB->second] = true;
+		parent[findRoot(iterA->second)] = findRoot(iterB->second);
+	}
+
+	// Every object attached to a spring is stepped with its island, the rest are stepped on their own
+	m_rigidObjects.clear();
+	m_islands.clear();
+	std::unordered_map<int, int> islandIndex;
+	for (int i = 0; i < (int)m_objects.size(); i++)
+	{
+		if (!attached[i])
+		{
+			m_rigidObjects.push_back(m_objects[i]);
+			continue;
+		}
+
+		int root = findRoot(i);
+		if (islandIndex.count(root) == 0)
+		{
+			islandIndex[root] = (int)m_islands.size();
+			m_islands.push_back(Island());
+			m_islands.back().lodLevel = LOD_LEVELS - 1;
+			m_islands.back().relaxing = false;
+		}
+		Island & island = m_islands[islandIndex[root]];
+		island.objects.push_back(m_objects[i]);
+
+		// An island takes the finest level of the objects in it, new objects start at level 0
+		island.lodLevel = glm::min(island.lodLevel, m_objects[i]->getLODLevel());
+	}
+	for (auto spring : m_springs)
+	{
+		auto iter = objectIndex.find(spring->getObjectA());
+		if (iter == objectIndex.end() || objectIndex.count(spring->getObjectB()) == 0) continue;
+		Island & island = m_islands[islandIndex[findRoot(iter->second)]];
+		island.springs.push_back(spring);
+		island.relaxing |= spring->getRestingLengthOffset() != Real(0);
+	}
+	for (auto & island : m_islands)
+	{
+		for (auto object : island.objects)
+		{
+			object->setLODLevel(island.lodLevel);
+		}
+	}
+
+	// Regenerate the tethers if the springs have changed, otherwise hand the existing ones back to their islands
+	if (m_tethersDirty)
+	{
+		generateTethers();
+	}
+	else
+	{
+		for (auto tether : m_tethers)
+		{
+			auto iter = objectIndex.find(tether->getObjectB());
+			if (iter == objectIndex.end()) continue;
+			m_islands[islandIndex[findRoot(iter->second)]].tethers.push_back(tether);
+		}
+	}
+
+	rebuildLODLists();
+	m_subsystemsDirty = false;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setLongRangeAttachments(bool enabled, Real slack)
+{
+	m_longRangeAttachments = enabled;
+	m_tetherSlack = slack;
+	m_tethersDirty = true;
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::generateTethers()
+{
+	MemoryScope scope(MemoryCategory::SUBSYSTEMS);
+
+	for (auto tether : m_tethers)
+	{
+		delete tether;
+	}
+	m_tethers.clear();
+	m_tethersDirty = false;
+
+	if (!m_longRangeAttachments) return;
+
+	for (auto & island : m_islands)
+	{
+		// Index the island's objects and connect them by their springs
+		std::unordered_map<Object *, int> localIndex;
+		for (int i = 0; i < (int)island.objects.size(); i++)
+		{
+			localIndex[island.objects[i]] = i;
+		}
+		vector<vector<std::pair<int, Real>>> neighbours(island.objects.size());
+		for (auto spring : island.springs)
+		{
+			int a = localIndex[spring->getObjectA()];
+			int b = localIndex[spring->getObjectB()];
+			neighbours[a].push_back(std::make_pair(b, spring->getRestingLength()));
+			neighbours[b].push_back(std::make_pair(a, spring->getRestingLength()));
+		}
+
+		for (int pin = 0; pin < (int)island.objects.size(); pin++)
+		{
+			if (!island.objects[pin]->getIsStatic()) continue;
+
+			// Dijkstra from the pin gives the shortest resting distance through the springs to every object,
+			// which is as far as the object can get from the pin without stretching a spring
+			vector<Real> distance(island.objects.size(), FLT_MAX);
+			typedef std::pair<Real, int> QueueEntry;
+			std::priority_queue<QueueEntry, vector<QueueEntry>, std::greater<QueueEntry>> queue;
+			distance[pin] = Real(0);
+			queue.push(QueueEntry(Real(0), pin));
+			while (!queue.empty())
+			{
+				QueueEntry entry = queue.top();
+				queue.pop();
+				if (entry.first > distance[entry.second]) continue;
+				for (auto & neighbour : neighbours[entry.second])
+				{
+					Real throughEntry = entry.first + neighbour.second;
+					if (throughEntry < distance[neighbour.first])
+					{
+						distance[neighbour.first] = throughEntry;
+						queue.push(QueueEntry(throughEntry, neighbour.first));
+					}
+				}
+			}
+
+			for (int i = 0; i < (int)island.objects.size(); i++)
+			{
+				if (island.objects[i]->getIsStatic() || distance[i] == FLT_MAX) continue;
+				Tether * tether = new Tether(island.objects[pin], island.objects[i], distance[i] * (Real(1) + m_tetherSlack));
+				m_tethers.push_back(tether);
+				island.tethers.push_back(tether);
+			}
+		}
+	}
+}
+
+template <typename Real>
+Real Physics::BasicScene<Real>::getAverageSpringStretch() const
+{
+	if (m_springs.empty()) return Real(0);
+
+	Real total = Real(0);
+	for (auto spring : m_springs)
+	{
+		Real length = glm::distance(spring->getObjectA()->getPosition(), spring->getObjectB()->getPosition());
+		total += glm::max(Real(0), length - spring->getRestingLength()) / spring->getRestingLength();
+	}
+	return total / m_springs.size();
+}
+
+template <typename Real>
+Real Physics::BasicScene<Real>::getMaxSpringStretch() const
+{
+	Real maximum = Real(0);
+	for (auto spring : m_springs)
+	{
+		Real length = glm::distance(spring->getObjectA()->getPosition(), spring->getObjectB()->getPosition());
+		maximum = glm::max(maximum, (length - spring->getRestingLength()) / spring->getRestingLength());
+	}
+	return maximum;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::assignLOD()
+{
+	// The level for a distance from the focus
+	auto levelForDistance = [this](Real distance)
+	{
+		int level = 0;
+		while (level < LOD_LEVELS - 1 && distance > m_lodDistances[level])
+		{
+			level++;
+		}
+		return level;
+	};
+
+	// The lists only need rebuilding if something changed level
+	bool changed = false;
+
+	// Static objects never move so they stay at level 0
+	for (auto object : m_rigidObjects)
+	{
+		int level = object->getIsStatic() ? 0 : levelForDistance(glm::distance(object->getPosition(), m_lodFocus));
+		changed |= level != object->getLODLevel();
+		object->setLODLevel(level);
+	}
+
+	// An island is as detailed as its closest object needs
+	for (auto & island : m_islands)
+	{
+		Real closest = FLT_MAX;
+		for (auto object : island.objects)
+		{
+			closest = glm::min(closest, glm::distance(object->getPosition(), m_lodFocus));
+		}
+		int level = levelForDistance(closest);
+
+		// Leaving the furthest level brings the detail springs back
+		if (island.lodLevel == LOD_LEVELS - 1 && level < LOD_LEVELS - 1)
+		{
+			restoreDetailSprings(island);
+		}
+
+		if (island.lodLevel == level) continue;
+		changed = true;
+		island.lodLevel = level;
+		for (auto object : island.objects)
+		{
+			object->setLODLevel(level);
+		}
+	}
+
+	// Changing levels doesn't touch positions or velocities and happens when every level is in step,
+	// so no time is skipped or repeated and no energy is added
+	if (changed)
+	{
+		rebuildLODLists();
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::rebuildLODLists()
+{
+	MemoryScope scope(MemoryCategory::SUBSYSTEMS);
+
+	for (int level = 0; level < LOD_LEVELS; level++)
+	{
+		m_lodRigidObjects[level].clear();
+		m_lodSpringObjects[level].clear();
+		m_lodSprings[level].clear();
+		m_lodTethers[level].clear();
+		m_lodRigidBodies[level].clear();
+		m_lodSpringBodies[level].clear();
+	}
+
+	for (auto object : m_rigidObjects)
+	{
+		m_lodRigidObjects[object->getLODLevel()].push_back(object);
+	}
+
+	for (auto & island : m_islands)
+	{
+		m_lodSpringObjects[island.lodLevel].insert(m_lodSpringObjects[island.lodLevel].end(), island.objects.begin(), island.objects.end());
+		for (auto spring : island.springs)
+		{
+			// The furthest level is simplified by leaving out the detail springs
+			if (island.lodLevel == LOD_LEVELS - 1 && spring->getIsDetail())
+			{
+				spring->setLODSlot(-1, -1);
+				continue;
+			}
+			m_lodSprings[island.lodLevel].push_back(spring);
+		}
+		m_lodTethers[island.lodLevel].insert(m_lodTethers[island.lodLevel].end(), island.tethers.begin(), island.tethers.end());
+	}
+
+	for (int level = 0; level < LOD_LEVELS; level++)
+	{
+		m_lodStats.objectCount[level] = (int)(m_lodRigidObjects[level].size() + m_lodSpringObjects[level].size());
+
+		// The bodies the integrators step, as indices into the store
+		for (auto object : m_lodRigidObjects[level])
+		{
+			m_lodRigidBodies[level].push_back(object->getBody());
+		}
+		for (auto object : m_lodSpringObjects[level])
+		{
+			m_lodSpringBodies[level].push_back(object->getBody());
+		}
+
+		// Find which springs of the level each object is attached to
+		vector<Object *> & objects = m_lodSpringObjects[level];
+		vector<Spring *> & springs = m_lodSprings[level];
+		SpringAdjacency & adjacency = m_lodSpringAdjacency[level];
+		// Each object's index in the level, found by its body
+		vector<int> & localIndex = m_levelIndex;
+		localIndex.resize(m_bodies.size());
+		for (int i = 0; i < (int)objects.size(); i++)
+		{
+			localIndex[objects[i]->getBody()] = i;
+		}
+
+		// Sort the springs by the first of their objects in the level, then the second, so the kernel reads the objects
+		// roughly in order. Springs between the same two objects stay in the order they were in
+		vector<int> & order = m_springOrder;
+		order.resize(springs.size());
+		for (int i = 0; i < (int)springs.size(); i++)
+		{
+			order[i] = i;
+		}
+		auto sortKey = [&](int spring)
+		{
+			int a = localIndex[springs[spring]->getObjectA()->getBody()];
+			int b = localIndex[springs[spring]->getObjectB()->getBody()];
+			return std::make_tuple(glm::min(a, b), glm::max(a, b), spring);
+		};
+		std::sort(order.begin(), order.end(), [&](int x, int y) { return sortKey(x) < sortKey(y); });
+		m_sortedSprings.resize(springs.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			m_sortedSprings[i] = springs[order[i]];
+		}
+		springs.swap(m_sortedSprings);
+
+		// The springs as arrays for the kernel. From here on the arrays hold the settings the level is stepped with, and
+		// each spring knows its place in them so writeSpringSettings can change them
+		SpringArrays & arrays = m_lodSpringArrays[level];
+		arrays.bodyA.resize(springs.size());
+		arrays.bodyB.resize(springs.size());
+		arrays.localA.resize(springs.size());
+		arrays.localB.resize(springs.size());
+		arrays.restingLength.resize(springs.size());
+		arrays.springCoefficient.resize(springs.size());
+		arrays.damping.resize(springs.size());
+		for (int i = 0; i < (int)springs.size(); i++)
+		{
+			arrays.bodyA[i] = springs[i]->getObjectA()->getBody();
+			arrays.bodyB[i] = springs[i]->getObjectB()->getBody();
+			arrays.localA[i] = localIndex[arrays.bodyA[i]];
+			arrays.localB[i] = localIndex[arrays.bodyB[i]];
+			springs[i]->setLODSlot(level, i);
+			writeSpringSettings(springs[i]);
+		}
+
+		// Count the springs of each object, then turn the counts into offsets and fill in the entries in spring order
+		adjacency.offsets.assign(objects.size() + 1, 0);
+		for (size_t i = 0; i < springs.size(); i++)
+		{
+			adjacency.offsets[arrays.localA[i] + 1]++;
+			adjacency.offsets[arrays.localB[i] + 1]++;
+		}
+		for (size_t i = 1; i < adjacency.offsets.size(); i++)
+		{
+			adjacency.offsets[i] += adjacency.offsets[i - 1];
+		}
+		adjacency.entries.resize(adjacency.offsets.back());
+		vector<int> & filled = m_adjacencyFilled;
+		filled.assign(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (int i = 0; i < (int)springs.size(); i++)
+		{
+			adjacency.entries[filled[arrays.localA[i]]++] = i * 2;
+			adjacency.entries[filled[arrays.localB[i]]++] = i * 2 + 1;
+		}
+
+		// Size the packed state for the fused kernel and fill in its tethers
+		FusedSprings & fused = m_lodFusedSprings[level];
+		fused.positionX.resize(objects.size());
+		fused.positionY.resize(objects.size());
+		fused.positionZ.resize(objects.size());
+		fused.velocityX.resize(objects.size());
+		fused.velocityY.resize(objects.size());
+		fused.velocityZ.resize(objects.size());
+		fused.inverseMass.resize(objects.size());
+		fused.friction.resize(objects.size());
+		fused.tetherAnchor.clear();
+		fused.tetherObject.clear();
+		fused.tetherMaxDistance.clear();
+		for (auto tether : m_lodTethers[level])
+		{
+			fused.tetherAnchor.push_back(localIndex[tether->getObjectA()->getBody()]);
+			fused.tetherObject.push_back(localIndex[tether->getObjectB()->getBody()]);
+			fused.tetherMaxDistance.push_back(tether->getMaxDistance());
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::restoreDetailSprings(Island & island)
+{
+	// While they were left out, the detail springs may have been stretched, which would add energy when they come back
+	Real added = Real(0);
+	for (auto spring : island.springs)
+	{
+		if (spring->getIsDetail())
+		{
+			added += spring->getPotentialEnergy();
+		}
+	}
+	if (added <= Real(0)) return;
+
+	// Pay for it out of the island's kinetic energy first
+	Real kinetic = Real(0);
+	for (auto object : island.objects)
+	{
+		if (object->getIsStatic()) continue;
+		kinetic += Real(0.5) * object->getMass() * glm::dot(object->getVelocity(), object->getVelocity());
+	}
+	Real paid = glm::min(added, kinetic);
+	if (paid > Real(0))
+	{
+		Real scale = std::sqrt((kinetic - paid) / kinetic);
+		for (auto object : island.objects)
+		{
+			object->setVelocity(object->getVelocity() * scale);
+		}
+	}
+
+	// Whatever is left is removed by offsetting the detail springs' resting lengths towards their current lengths,
+	// scaling every stretch by the same amount so the energy they hold is exactly what was paid for.
+	// The resting lengths the springs were given are kept, and relaxRestingLengths eases the offsets away afterwards
+	if (paid < added)
+	{
+		Real stretchScale = std::sqrt(paid / added);
+		for (auto spring : island.springs)
+		{
+			if (!spring->getIsDetail()) continue;
+			Real length = glm::distance(spring->getObjectA()->getPosition(), spring->getObjectB()->getPosition());
+			Real restingLength = length - (length - spring->getEffectiveRestingLength()) * stretchScale;
+			spring->setRestingLengthOffset(restingLength - spring->getRestingLength());
+			writeSpringSettings(spring);
+		}
+		island.relaxing = true;
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::relaxRestingLengths(Real deltaTime)
+{
+	// The offsets shrink exponentially, so the energy they held comes back gradually and the springs' damping can take it
+	Real decay = std::exp(-deltaTime / m_restingLengthRelaxTime);
+	for (auto & island : m_islands)
+	{
+		if (!island.relaxing) continue;
+		island.relaxing = false;
+		for (auto spring : island.springs)
+		{
+			Real offset = spring->getRestingLengthOffset() * decay;
+
+			// Once it is too small to matter the spring is back to exactly its own resting length
+			if (glm::abs(offset) <= spring->getRestingLength() * Real(1e-4))
+			{
+				offset = Real(0);
+			}
+			spring->setRestingLengthOffset(offset);
+			writeSpringSettings(spring);
+			island.relaxing |= offset != Real(0);
+		}
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::writeSpringSettings(const Spring * spring)
+{
+	if (spring->getLODLevel() < 0) return;
+	SpringArrays & arrays = m_lodSpringArrays[spring->getLODLevel()];
+	int index = spring->getLODIndex();
+	arrays.restingLength[index] = spring->getEffectiveRestingLength();
+	arrays.springCoefficient[index] = spring->getSpringCoefficient();
+	arrays.damping[index] = spring->getDamping();
+}
+
+template <typename Real>
+float Physics::BasicScene<Real>::getInterpolationAlpha(const Object * object) const
+{
+	// An object at a coarser level was stepped at the start of a block of 2^level fixed steps,
+	// so its alpha covers the whole block rather than a single step
+	int interval = 1 << object->getLODLevel();
+	int stepsIntoBlock = (int)((m_stepIndex + interval - 1) % interval);
+	return (stepsIntoBlock + getInterpolationAlpha()) / interval;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::draw()
+{
+	// Objects, then springs, then cloths, as one range so it can be split into chunks
+	size_t objectCount = m_objects.size();
+	size_t springCount = m_springs.size();
+	size_t count = objectCount + springCount + m_cloths.size();
+	auto drawRange = [this, objectCount, springCount](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (i < objectCount)
+			{
+				// Draws the object, blended by how far the render time is between its previous and current step
+				m_objects[i]->draw(getInterpolationAlpha(m_objects[i]));
+			}
+			else if (i < objectCount + springCount)
+			{
+				// Both ends of a spring are at the same level of detail
+				Spring * spring = m_springs[i - objectCount];
+				spring->draw(getInterpolationAlpha(spring->getObjectA()));
+			}
+			else
+			{
+				// Cloths are stepped every fixed step
+				m_cloths[i - objectCount - springCount]->draw(getInterpolationAlpha());
+			}
+		}
+	};
+
+	if (m_workers == nullptr || count <= PARALLEL_CHUNK_SIZE)
+	{
+		drawRange(0, count);
+		return;
+	}
+
+	// Each chunk is drawn into its own buffer, bound to the thread that draws it
+	size_t chunkCount = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+	while (m_gizmoBuffers.size() < chunkCount)
+	{
+		MemoryScope scope(MemoryCategory::RENDERING);
+		m_gizmoBuffers.push_back(new aie::GizmoBuffer());
+	}
+	m_workers->run((int)chunkCount, [&](int chunk, int)
+	{
+		MemoryScope scope(MemoryCategory::RENDERING);
+		size_t begin = chunk * PARALLEL_CHUNK_SIZE;
+		aie::Gizmos::bindBuffer(m_gizmoBuffers[chunk]);
+		drawRange(begin, glm::min(begin + PARALLEL_CHUNK_SIZE, count));
+		aie::Gizmos::bindBuffer(nullptr);
+	});
+
+	// Merged in chunk order, which is the order drawing on one thread adds them in
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		aie::Gizmos::mergeBuffer(*m_gizmoBuffers[chunk]);
+	}
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::captureSnapshot(RenderSnapshot & snapshot) const
+{
+	snapshot.clear();
+
+	// Each object's alpha offset and scale, from the same block of fixed steps getInterpolationAlpha uses
+	auto setAlpha = [this](int level, float & offset, float & scale)
+	{
+		int interval = 1 << level;
+		offset = (float)((m_stepIndex + interval - 1) % interval) / interval;
+		scale = 1.0f / interval;
+	};
+
+	for (auto object : m_objects)
+	{
+		RenderSnapshot::ObjectEntry entry;
+		entry.shape = object->getShapeType();
+		entry.previous = vec3(object->getPreviousPosition());
+		entry.current = vec3(object->getPosition());
+		entry.size = vec3(0);
+		entry.distance = 0.0f;
+		entry.color = object->getColor();
+		setAlpha(object->getLODLevel(), entry.alphaOffset, entry.alphaScale);
+		switch (entry.shape)
+		{
+		case ShapeType::SPHERE:
+			entry.size.x = (float)static_cast<const Sphere *>(object)->getRadius();
+			break;
+		case ShapeType::AABB:
+			entry.size = vec3(static_cast<const AABB *>(object)->getExtents());
+			break;
+		case ShapeType::PLANE:
+			entry.size = vec3(static_cast<const Plane *>(object)->getDirection());
+			entry.distance = (float)static_cast<const Plane *>(object)->getDistance();
+			break;
+		}
+		snapshot.addObject(entry);
+	}
+
+	for (auto spring : m_springs)
+	{
+		RenderSnapshot::SpringEntry entry;
+		entry.previousA = vec3(spring->getObjectA()->getPreviousPosition());
+		entry.currentA = vec3(spring->getObjectA()->getPosition());
+		entry.previousB = vec3(spring->getObjectB()->getPreviousPosition());
+		entry.currentB = vec3(spring->getObjectB()->getPosition());
+		setAlpha(spring->getObjectA()->getLODLevel(), entry.alphaOffset, entry.alphaScale);
+		snapshot.addSpring(entry);
+	}
+
+	int particleCount = 0;
+	for (auto cloth : m_cloths)
+	{
+		snapshot.addCloth(cloth->getRows(), cloth->getColumns(), cloth->getColor());
+		for (int i = 0; i < cloth->getParticleCount(); i++)
+		{
+			snapshot.addParticle(vec3(cloth->getPreviousPosition(i)), vec3(cloth->getPosition(i)));
+		}
+		particleCount += cloth->getParticleCount();
+	}
+
+	SnapshotStats & stats = snapshot.getStats();
+	stats.stepIndex = m_stepIndex;
+	stats.objectCount = (int)m_objects.size();
+	stats.springCount = (int)m_springs.size();
+	stats.particleCount = particleCount;
+	stats.updateTime = m_lastUpdateTime;
+	stats.stepCount = m_lastStepCount;
+}
+
+template <typename Real>
+typename BasicScene<Real>::ObjectHandle Physics::BasicScene<Real>::addObject(Object * object)
 {
-	// Default gravity just in case
-	m_gravity = vec3(0.0f, -9.8f, 0.0f);
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	return queueObject(object, false);
+}
 
-	//Defaults for fixed time at 100fps
-	m_fixedTimeStep = 0.01f;
+template <typename Real>
+void Physics::BasicScene<Real>::addObjects(Object * const * objects, size_t count, ObjectHandle * handles)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	for (size_t i = 0; i < count; i++)
+	{
+		ObjectHandle handle = queueObject(objects[i], false);
+		if (handles != nullptr)
+		{
+			handles[i] = handle;
+		}
+	}
+}
 
-	// Set accumulated time to 0
-	m_accumulatedTime = 0.0f;
+template <typename Real>
+typename BasicScene<Real>::ObjectHandle Physics::BasicScene<Real>::queueObject(Object * object, bool pooled)
+{
+	// The handle is reserved now so it can be given out, it starts resolving when the object is applied
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	QueuedObject queued;
+	queued.object = object;
+	queued.handle = m_objectHandles.reserve();
+	queued.pooled = pooled;
+	m_queuedObjects.push_back(queued);
+	return queued.handle;
+}
 
-	// Zero the global force
-	m_globalForce = vec3();
+template <typename Real>
+void Physics::BasicScene<Real>::removeObject(ObjectHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedObjectRemoves.push_back(handle);
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::removeObjects(const ObjectHandle * handles, size_t count)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedObjectRemoves.insert(m_queuedObjectRemoves.end(), handles, handles + count);
 }
 
+template <typename Real>
+void Physics::BasicScene<Real>::removeObject(Object * object)
+{
+	// The handle is looked up under the lock applyCommands holds while it moves objects, so this is safe during a step
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	ObjectHandle handle = findHandle(object);
+	if (handle.generation == 0) return;
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedObjectRemoves.push_back(handle);
+}
 
-Scene::~Scene()
+template <typename Real>
+typename BasicScene<Real>::Object * Physics::BasicScene<Real>::getObject(ObjectHandle handle) const
 {
-	// Delete all springs
-	for (auto spring : m_springs)
+	int index = m_objectHandles.getIndex(handle);
+	return index < 0 ? nullptr : m_objects[index];
+}
+
+template <typename Real>
+typename BasicScene<Real>::ObjectHandle Physics::BasicScene<Real>::getHandle(Object * object) const
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	return findHandle(object);
+}
+
+template <typename Real>
+typename BasicScene<Real>::ObjectHandle Physics::BasicScene<Real>::findHandle(Object * object) const
+{
+	// Objects in the scene have their body in its store
+	if (object->getBodyStore() == &m_bodies)
 	{
-		delete spring;
+		return m_objectHandles.getHandle(object->getBody());
 	}
 
-	// Delete all objects
-	for (auto object : m_objects)
+	// Otherwise it may be waiting to be added
+	for (auto & queued : m_queuedObjects)
 	{
-		delete object;
+		if (queued.object == object)
+		{
+			return queued.handle;
+		}
 	}
+	return ObjectHandle();
 }
 
-void Scene::update(float deltaTime)
+template <typename Real>
+typename BasicScene<Real>::Sphere * Physics::BasicScene<Real>::createSphere(Vector position, Real radius, Real mass, vec4 color, bool isStatic)
 {
-	// Increase accumulated time by delta time
-	m_accumulatedTime += deltaTime;
+	// The object keeps its own body until it is applied, since the store can't change during a step
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::OBJECTS);
+	Sphere * sphere = m_spherePool.create(position, radius, mass, color, isStatic);
+	queueObject(sphere, true);
+	return sphere;
+}
 
-	// Each iteration uses m_fixedTimeStep as delta time
-	// The loop continues until the sum of fixed time steps is equal to or less than m_accumulated time
-	while (m_accumulatedTime >= m_fixedTimeStep)
+template <typename Real>
+typename BasicScene<Real>::AABB * Physics::BasicScene<Real>::createAABB(Vector position, Vector halfExtent, Real mass, vec4 color, bool isStatic)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::OBJECTS);
+	AABB * box = m_aabbPool.create(position, halfExtent, mass, color, isStatic);
+	queueObject(box, true);
+	return box;
+}
+
+template <typename Real>
+typename BasicScene<Real>::Spring * Physics::BasicScene<Real>::createSpring(Object * objA, Object * objB, Real restingLength, Real springCoefficient, Real damping)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::SPRINGS);
+	Spring * spring = m_springPool.create(objA, objB, restingLength, springCoefficient, damping);
+	queueSpring(spring, true);
+	return spring;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::destroyObject(Object * object, bool pooled)
+{
+	if (!pooled)
+	{
+		delete object;
+	}
+	else if (object->getShapeType() == ShapeType::SPHERE)
+	{
+		m_spherePool.destroy((Sphere *)object);
+	}
+	else
 	{
-		// Applies gravity to all objects
-		applyGravity();
+		m_aabbPool.destroy((AABB *)object);
+	}
+}
 
-		// Updates all objects with fixed time step
-		for (auto object : m_objects)
-		{
-			object->update(m_fixedTimeStep);
-		}
+template <typename Real>
+void Physics::BasicScene<Real>::destroySpring(Spring * spring, bool pooled)
+{
+	if (pooled)
+	{
+		m_springPool.destroy(spring);
+	}
+	else
+	{
+		delete spring;
+	}
+}
 
-		// Updated all springs with fixed time step
-		for (auto spring : m_springs)
-		{
-			spring->update(m_fixedTimeStep);
-		}
-		
-		// Decrement the accumulated time
-		m_accumulatedTime -= m_fixedTimeStep;
+template <typename Real>
+typename BasicScene<Real>::SpringHandle Physics::BasicScene<Real>::addSpring(Spring * spring)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	return queueSpring(spring, false);
+}
 
-		// Check for collisions
-		checkCollision();
+template <typename Real>
+typename BasicScene<Real>::SpringHandle Physics::BasicScene<Real>::queueSpring(Spring * spring, bool pooled)
+{
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	QueuedSpring queued;
+	queued.spring = spring;
+	queued.handle = m_springHandles.reserve();
+	queued.pooled = pooled;
+	m_queuedSprings.push_back(queued);
+	return queued.handle;
+}
 
-		// Resolve collisions
-		resolveCollision();
-	}
+template <typename Real>
+void Physics::BasicScene<Real>::removeSpring(SpringHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedSpringRemoves.push_back(handle);
 }
 
-void Scene::draw()
+template <typename Real>
+void Physics::BasicScene<Real>::removeSpring(Spring * spring)
 {
-	// Draws all objects
-	for (auto object : m_objects)
+	// Searched for under the lock applyCommands holds while it moves springs, so this is safe during a step
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+
+	// Look for the spring among the springs of its first object, which are only a few
+	Object * object = spring->getObjectA();
+	if (object->getBodyStore() == &m_bodies)
 	{
-		object->draw();
+		for (auto handle : m_objectSprings[object->getBody()])
+		{
+			if (getSpring(handle) == spring)
+			{
+				m_queuedSpringRemoves.push_back(handle);
+				return;
+			}
+		}
 	}
 
-	// Draws all springs
-	for (auto spring : m_springs)
+	// A spring added before its first object isn't attached to it yet, so it has to be searched for
+	auto iter = std::find(m_springs.begin(), m_springs.end(), spring);
+	if (iter != m_springs.end())
+	{
+		m_queuedSpringRemoves.push_back(m_springHandles.getHandle((int)(iter - m_springs.begin())));
+		return;
+	}
+
+	// It may still be waiting to be added
+	for (auto & queued : m_queuedSprings)
 	{
-		spring->draw();
+		if (queued.spring == spring)
+		{
+			m_queuedSpringRemoves.push_back(queued.handle);
+			return;
+		}
 	}
 }
 
-void Scene::addObject(Object * object)
+template <typename Real>
+void Physics::BasicScene<Real>::setSpringCoefficient(Spring * spring, Real springCoefficient)
+{
+	spring->setSpringCoefficient(springCoefficient);
+	writeSpringSettings(spring);
+
+	// The stable spring step depends on the stiffness
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setRestingLength(Spring * spring, Real restingLength)
+{
+	spring->setRestingLength(restingLength);
+	writeSpringSettings(spring);
+
+	// Tethers are as long as the springs they follow
+	m_tethersDirty = true;
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setMass(Object * object, Real mass)
+{
+	object->setMass(mass);
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::setFriction(Object * object, Real friction)
+{
+	object->setFriction(friction);
+	m_subsystemsDirty = true;
+}
+
+template <typename Real>
+typename BasicScene<Real>::Spring * Physics::BasicScene<Real>::getSpring(SpringHandle handle) const
+{
+	int index = m_springHandles.getIndex(handle);
+	return index < 0 ? nullptr : m_springs[index];
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::addCloth(Cloth * cloth)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedCloths.push_back(cloth);
+}
+
+template <typename Real>
+void Physics::BasicScene<Real>::removeCloth(Cloth * cloth)
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	MemoryScope scope(MemoryCategory::COMMANDS);
+	m_queuedClothRemoves.push_back(cloth);
+}
+
+template <typename Real>
+int Physics::BasicScene<Real>::getQueuedCommandCount() const
+{
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	return (int)(m_queuedObjects.size() + m_queuedSprings.size() + m_queuedObjectRemoves.size() + m_queuedSpringRemoves.size() +
+		m_queuedCloths.size() + m_queuedClothRemoves.size());
+}
+
+template <typename Real>
+bool Physics::BasicScene<Real>::pushCommand(const Command & command)
 {
-	// Adds the parameter object to the vector
-	m_objects.push_back(object);
+	if (m_commandQueue.push(command)) return true;
+	m_droppedCommands++;
+	return false;
 }
 
-void Scene::removeObject(Object * object)
+template <typename Real>
+bool Physics::BasicScene<Real>::popSpawnResult(SpawnResult & result)
 {
-	// Find object in vector
-	auto iter = std::find(m_objects.begin(), m_objects.end(), object);
-	// If found remove from vector
-	if (iter != m_objects.end())
+	return m_spawnResults.pop(result);
+}
+
+template <typename Real>
+bool Physics::BasicScene<Real>::applyQueuedCommands()
+{
+	typename Command::Clock::time_point now = Command::Clock::now();
+	bool added = false;
+	bool applied = false;
+	Command command;
+	while (m_commandQueue.pop(command))
 	{
-		m_objects.erase(iter);
+		// How long the command waited, as a running average so nothing has to be kept between calls
+		float latency = std::chrono::duration<float, std::milli>(now - command.time).count();
+		m_commandStats.appliedCount++;
+		m_commandStats.averageLatency += (latency - m_commandStats.averageLatency) / m_commandStats.appliedCount;
+		m_commandStats.maxLatency = glm::max(m_commandStats.maxLatency, latency);
+		applied = true;
+
+		switch (command.type)
+		{
+		case CommandType::SPAWN:
+		{
+			Object * object;
+			if (command.shape == ShapeType::AABB)
+			{
+				object = createAABB(command.position, command.size, command.mass, command.color, false);
+			}
+			else
+			{
+				object = createSphere(command.position, command.size.x, command.mass, command.color, false);
+			}
+			object->setVelocity(command.value);
+
+			// The result is dropped if the sender isn't taking them, the object is spawned either way
+			SpawnResult result = { command.id, getHandle(object), command.time, m_stepIndex };
+			if (!m_spawnResults.push(result))
+			{
+				m_droppedSpawnResults++;
+				m_commandStats.droppedResultCount = m_droppedSpawnResults;
+			}
+			added = true;
+			break;
+		}
+		case CommandType::REMOVE:
+			removeObject(command.target);
+			break;
+		case CommandType::APPLY_IMPULSE:
+		{
+			// An object spawned earlier in the same batch can only be found once it has been applied
+			if (added)
+			{
+				applyCommands();
+				added = false;
+			}
+			Object * object = getObject(command.target);
+			if (object != nullptr)
+			{
+				object->applyImpulse(command.value);
+			}
+			break;
+		}
+		case CommandType::SET_GLOBAL_FORCE:
+			m_globalForce = command.value;
+			break;
+		}
 	}
+	return applied;
 }
 
-void Physics::Scene::addSpring(Spring * spring)
+template <typename Real>
+void Physics::BasicScene<Real>::applyCommands()
 {
-	// Adds the spring to the vector
-	m_springs.push_back(spring);
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	if (m_queuedObjects.empty() && m_queuedSprings.empty() && m_queuedObjectRemoves.empty() && m_queuedSpringRemoves.empty() &&
+		m_queuedCloths.empty() && m_queuedClothRemoves.empty()) return;
+
+	// Growth of the scene's arrays is charged to objects, the body store and handle maps charge their own
+	MemoryScope scope(MemoryCategory::OBJECTS);
+
+	// Cloths don't share anything with the objects, so they are simply added and removed
+	m_cloths.insert(m_cloths.end(), m_queuedCloths.begin(), m_queuedCloths.end());
+	for (auto cloth : m_queuedClothRemoves)
+	{
+		auto iter = std::find(m_cloths.begin(), m_cloths.end(), cloth);
+		if (iter == m_cloths.end()) continue;
+		delete cloth;
+		m_cloths.erase(iter);
+	}
+	m_queuedCloths.clear();
+	m_queuedClothRemoves.clear();
+
+	// Add the objects at the end, moving their bodies into the scene's store so each object's index stays its body's
+	for (auto & queued : m_queuedObjects)
+	{
+		queued.object->setBodyStore(&m_bodies);
+		m_objects.push_back(queued.object);
+		m_objectSprings.push_back(vector<SpringHandle>());
+		m_pooledObjects.push_back(queued.pooled);
+		m_objectHandles.assign(queued.handle);
+	}
+
+	// Springs applied before their objects are attached to the objects that have just been added
+	if (!m_queuedObjects.empty())
+	{
+		size_t write = 0;
+		for (auto handle : m_unattachedSprings)
+		{
+			// Springs removed since are dropped
+			int index = m_springHandles.getIndex(handle);
+			if (index < 0) continue;
+			if (!attachSpring(handle, m_springs[index]))
+			{
+				m_unattachedSprings[write++] = handle;
+			}
+		}
+		m_unattachedSprings.resize(write);
+	}
+
+	// Then the springs, attaching them to their objects so they are removed with them
+	for (auto & queued : m_queuedSprings)
+	{
+		MemoryScope springScope(MemoryCategory::SPRINGS);
+		m_springs.push_back(queued.spring);
+		m_pooledSprings.push_back(queued.pooled);
+		m_springHandles.assign(queued.handle);
+
+		// A spring whose objects aren't all in the scene yet waits for them, otherwise removing them would leave it behind
+		if (!attachSpring(queued.handle, queued.spring))
+		{
+			m_unattachedSprings.push_back(queued.handle);
+		}
+	}
+
+	// Mark what is removed, the springs attached to removed objects go with them
+	m_removedObjects.assign(m_objects.size(), false);
+	m_removedSprings.assign(m_springs.size(), false);
+	bool anyRemoved = false;
+	for (auto handle : m_queuedObjectRemoves)
+	{
+		int index = m_objectHandles.getIndex(handle);
+		if (index < 0) continue;
+		m_removedObjects[index] = true;
+		for (auto springHandle : m_objectSprings[index])
+		{
+			m_removedSprings[m_springHandles.getIndex(springHandle)] = true;
+		}
+		anyRemoved = true;
+	}
+	for (auto handle : m_queuedSpringRemoves)
+	{
+		int index = m_springHandles.getIndex(handle);
+		if (index < 0) continue;
+		m_removedSprings[index] = true;
+		anyRemoved = true;
+	}
+
+	if (anyRemoved)
+	{
+		// Detach the removed springs from the objects that stay
+		for (int i = 0; i < (int)m_springs.size(); i++)
+		{
+			if (!m_removedSprings[i]) continue;
+			SpringHandle handle = m_springHandles.getHandle(i);
+			Object * objects[2] = { m_springs[i]->getObjectA(), m_springs[i]->getObjectB() };
+			for (auto object : objects)
+			{
+				if (object->getBodyStore() != &m_bodies || m_removedObjects[object->getBody()]) continue;
+				vector<SpringHandle> & springs = m_objectSprings[object->getBody()];
+				auto iter = std::find(springs.begin(), springs.end(), handle);
+				if (iter != springs.end())
+				{
+					*iter = springs.back();
+					springs.pop_back();
+				}
+			}
+		}
+
+		// Compact the springs, deleting the removed ones on the way
+		size_t write = 0;
+		for (size_t i = 0; i < m_springs.size(); i++)
+		{
+			if (m_removedSprings[i])
+			{
+				destroySpring(m_springs[i], m_pooledSprings[i]);
+				continue;
+			}
+			m_springs[write] = m_springs[i];
+			m_pooledSprings[write++] = m_pooledSprings[i];
+		}
+		m_springs.resize(write);
+		m_pooledSprings.resize(write);
+		m_springHandles.compact(m_removedSprings);
+
+		// Compact the bodies first, which detaches the removed objects from the store, then the objects in the same way
+		m_bodies.compact(m_removedObjects);
+		write = 0;
+		for (size_t i = 0; i < m_objects.size(); i++)
+		{
+			if (m_removedObjects[i])
+			{
+				destroyObject(m_objects[i], m_pooledObjects[i]);
+				continue;
+			}
+			m_objects[write] = m_objects[i];
+			m_objectSprings[write].swap(m_objectSprings[i]);
+			m_pooledObjects[write++] = m_pooledObjects[i];
+		}
+		m_objects.resize(write);
+		m_objectSprings.resize(write);
+		m_pooledObjects.resize(write);
+		m_objectHandles.compact(m_removedObjects);
+	}
+
+	// New or removed springs change the tethers, and tethers may point at removed objects
+	m_subsystemsDirty = true;
+	m_tethersDirty = m_tethersDirty || anyRemoved || !m_queuedSprings.empty();
+
+	m_queuedObjects.clear();
+	m_queuedSprings.clear();
+	m_queuedObjectRemoves.clear();
+	m_queuedSpringRemoves.clear();
 }
 
-void Physics::Scene::removeSpring(Spring * spring)
+template <typename Real>
+bool Physics::BasicScene<Real>::attachSpring(SpringHandle handle, Spring * spring)
 {
-	// Find object in vector
-	auto iter = std::find(m_springs.begin(), m_springs.end(), spring);
-	// If found, remove from vector
-	if (iter != m_springs.end())
+	bool attached = true;
+	Object * objects[2] = { spring->getObjectA(), spring->getObjectB() };
+	for (auto object : objects)
 	{
-		m_springs.erase(iter);
+		if (object->getBodyStore() != &m_bodies)
+		{
+			attached = false;
+			continue;
+		}
+		vector<SpringHandle> & springs = m_objectSprings[object->getBody()];
+		if (std::find(springs.begin(), springs.end(), handle) == springs.end())
+		{
+			springs.push_back(handle);
+		}
 	}
+	return attached;
 }
 
-void Scene::applyGlobalForce()
+template <typename Real>
+void Physics::BasicScene<Real>::applyGlobalForce()
 {
 	// Applies global force to all objects
 	for (auto object : m_objects)
@@ -132,78 +1980,226 @@ void Scene::applyGlobalForce()
 	}
 }
 
-void Scene::applyGravity()
+template <typename Real>
+void Physics::BasicScene<Real>::applyGravity(const vector<int> & bodies)
+{
+	// Applies gravity to the objects
+	parallelFor(bodies.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			int body = bodies[i];
+
+			// Static objects don't move and may have no mass
+			if (m_bodies.getIsStatic(body)) continue;
+
+			// Gravity applies force based on mass, so it accelerates everything the same
+			m_bodies.setAcceleration(body, m_bodies.getAcceleration(body) + m_gravity);
+		}
+	});
+}
+
+template <typename Real>
+Real Physics::BasicScene<Real>::getTotalEnergy() const
 {
-	// Applies gravity to all objects
+	Real energy = Real(0);
 	for (auto object : m_objects)
 	{
-		// Since gravity applies force based on mass
-		object->applyForce(m_gravity* object->getMass());
+		if (object->getIsStatic()) continue;
+
+		// Kinetic energy, 1/2 m v^2
+		energy += Real(0.5) * object->getMass() * glm::dot(object->getVelocity(), object->getVelocity());
+
+		// Gravitational potential energy relative to the origin, -m g.x
+		energy -= object->getMass() * glm::dot(m_gravity, object->getPosition());
+	}
+
+	// Energy stored in the springs
+	for (auto spring : m_springs)
+	{
+		energy += spring->getPotentialEnergy();
+	}
+
+	for (auto cloth : m_cloths)
+	{
+		energy += cloth->getEnergy(m_gravity);
+	}
+	return energy;
+}
+
+template <typename Real>
+const MemoryReport & Physics::BasicScene<Real>::getMemoryReport()
+{
+	m_memoryReport.setLiveBytes(MemoryCategory::BODIES, m_bodies.getMemoryBytes());
+
+	size_t objectBytes = m_spherePool.getMemoryBytes() + m_aabbPool.getMemoryBytes();
+	objectBytes += getVectorBytes(m_objects) + getVectorBytes(m_pooledObjects) + getVectorBytes(m_removedObjects);
+	objectBytes += getVectorBytes(m_objectSprings);
+	for (auto & springs : m_objectSprings)
+	{
+		objectBytes += getVectorBytes(springs);
+	}
+	m_memoryReport.setLiveBytes(MemoryCategory::OBJECTS, objectBytes);
+
+	size_t springBytes = m_springPool.getMemoryBytes();
+	springBytes += getVectorBytes(m_springs) + getVectorBytes(m_pooledSprings) + getVectorBytes(m_removedSprings) + getVectorBytes(m_unattachedSprings);
+	m_memoryReport.setLiveBytes(MemoryCategory::SPRINGS, springBytes);
+
+	size_t clothBytes = getVectorBytes(m_cloths);
+	for (auto cloth : m_cloths)
+	{
+		clothBytes += cloth->getMemoryBytes();
+	}
+	m_memoryReport.setLiveBytes(MemoryCategory::CLOTHS, clothBytes);
+
+	m_memoryReport.setLiveBytes(MemoryCategory::HANDLES, m_objectHandles.getMemoryBytes() + m_springHandles.getMemoryBytes());
+
+	{
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		size_t commandBytes = getVectorBytes(m_queuedObjects) + getVectorBytes(m_queuedSprings);
+		commandBytes += getVectorBytes(m_queuedObjectRemoves) + getVectorBytes(m_queuedSpringRemoves);
+		commandBytes += getVectorBytes(m_queuedCloths) + getVectorBytes(m_queuedClothRemoves);
+		m_memoryReport.setLiveBytes(MemoryCategory::COMMANDS, commandBytes);
+	}
+
+	// The islands, levels and the arrays built from them, and the tethers the scene generated
+	size_t subsystemBytes = getVectorBytes(m_rigidObjects) + getVectorBytes(m_islands);
+	for (auto & island : m_islands)
+	{
+		subsystemBytes += getVectorBytes(island.objects) + getVectorBytes(island.springs) + getVectorBytes(island.tethers);
+	}
+	for (int level = 0; level < LOD_LEVELS; level++)
+	{
+		subsystemBytes += getVectorBytes(m_lodRigidObjects[level]) + getVectorBytes(m_lodSpringObjects[level]);
+		subsystemBytes += getVectorBytes(m_lodRigidBodies[level]) + getVectorBytes(m_lodSpringBodies[level]);
+		subsystemBytes += getVectorBytes(m_lodSprings[level]) + getVectorBytes(m_lodTethers[level]);
+		subsystemBytes += getVectorBytes(m_lodSpringAdjacency[level].offsets) + getVectorBytes(m_lodSpringAdjacency[level].entries);
+
+		const SpringArrays & arrays = m_lodSpringArrays[level];
+		subsystemBytes += getVectorBytes(arrays.bodyA) + getVectorBytes(arrays.bodyB) + getVectorBytes(arrays.localA) + getVectorBytes(arrays.localB);
+		subsystemBytes += getVectorBytes(arrays.restingLength) + getVectorBytes(arrays.springCoefficient) + getVectorBytes(arrays.damping);
+
+		const FusedSprings & fused = m_lodFusedSprings[level];
+		subsystemBytes += getVectorBytes(fused.positionX) + getVectorBytes(fused.positionY) + getVectorBytes(fused.positionZ);
+		subsystemBytes += getVectorBytes(fused.velocityX) + getVectorBytes(fused.velocityY) + getVectorBytes(fused.velocityZ);
+		subsystemBytes += getVectorBytes(fused.inverseMass) + getVectorBytes(fused.friction);
+		subsystemBytes += getVectorBytes(fused.tetherAnchor) + getVectorBytes(fused.tetherObject) + getVectorBytes(fused.tetherMaxDistance);
+	}
+	subsystemBytes += getVectorBytes(m_levelIndex) + getVectorBytes(m_adjacencyFilled);
+	subsystemBytes += getVectorBytes(m_springOrder) + getVectorBytes(m_sortedSprings);
+	subsystemBytes += getVectorBytes(m_tethers) + m_tethers.size() * sizeof(Tether);
+	m_memoryReport.setLiveBytes(MemoryCategory::SUBSYSTEMS, subsystemBytes);
+
+	m_memoryReport.setLiveBytes(MemoryCategory::FRAME_ARENA, m_frameArena.getMemoryBytes());
+
+	// The buffers chunks are drawn into when drawing in parallel
+	size_t gizmoBytes = getVectorBytes(m_gizmoBuffers);
+	for (auto buffer : m_gizmoBuffers)
+	{
+		gizmoBytes += sizeof(aie::GizmoBuffer) + buffer->getCapacityBytes();
 	}
+	m_memoryReport.setLiveBytes(MemoryCategory::RENDERING, gizmoBytes);
+	return m_memoryReport;
 }
 
-void Physics::Scene::checkCollision()
+template <typename Real>
+void Physics::BasicScene<Real>::checkCollision(ArenaVector<Collision> & collisions)
 {
-	// Loops through all objects to find collisions, then place them in the collision vector
-	for (auto object  = m_objects.begin(); object != m_objects.end(); object++)
+	// Each chunk of first objects is checked on its own, into its own list when the order has to be kept or into
+	// the list of the thread that checks it otherwise
+	size_t chunkCount = (m_objects.size() + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+	size_t listCount = m_deterministic ? chunkCount : (size_t)getThreadCount();
+
+	auto checkRange = [this](size_t begin, size_t end, ArenaVector<Collision> & collisions)
 	{
-		// Loops through objects that the first object can collide with, the nature of this loop is that it checks
-		// against objects forward in the vector
-		for (auto object2 = object + 1; object2 != m_objects.end(); object2++)
+		// Loops through all objects to find collisions, then place them in the collision vector
+		for (auto object = m_objects.begin() + begin; object != m_objects.begin() + end; object++)
 		{
-			Collision tempCollision;
-			// Passes both objects and a reference to the collision normal of tempCollision into the collision check function
-			// Uses the return bool and adds to collision vector if there is a collision
-			if ((*object)->isColliding(*object2, tempCollision.collisionNormal))
+			// Loops through objects that the first object can collide with, the nature of this loop is that it checks
+			// against objects forward in the vector
+			for (auto object2 = object + 1; object2 != m_objects.end(); object2++)
 			{
-				// For the specific case where the first object is a sphere and the second object is a plane, they are added to the struct in reverse order
-				if ((*object)->getShapeType() == ShapeType::SPHERE && (*object2)->getShapeType() == ShapeType::PLANE)
-				{
-					tempCollision.objA = *object2;
-					tempCollision.objB = *object;
-				}
-				else
+				Collision tempCollision;
+				// Passes both objects and a reference to the collision normal of tempCollision into the collision check function
+				// Uses the return bool and adds to collision vector if there is a collision
+				if ((*object)->isColliding(*object2, tempCollision.collisionNormal))
 				{
-					tempCollision.objA = *object;
-					tempCollision.objB = *object2;
+					// For the specific case where the first object is a sphere and the second object is a plane, they are added to the struct in reverse order
+					if ((*object)->getShapeType() == ShapeType::SPHERE && (*object2)->getShapeType() == ShapeType::PLANE)
+					{
+						tempCollision.objA = *object2;
+						tempCollision.objB = *object;
+					}
+					else
+					{
+						tempCollision.objA = *object;
+						tempCollision.objB = *object2;
+					}
+					// Adds the struct to the vector
+					collisions.push_back(tempCollision);
 				}
-				// Adds the struct to the vector
-				m_collisions.push_back(tempCollision);
 			}
 		}
+	};
+
+	if (m_workers == nullptr || chunkCount <= 1)
+	{
+		checkRange(0, m_objects.size(), collisions);
+		return;
+	}
+
+	ArenaAllocator<Collision> allocator(&m_frameArena);
+	ArenaVector<ArenaVector<Collision>> partialCollisions = ArenaVector<ArenaVector<Collision>>(ArenaAllocator<ArenaVector<Collision>>(allocator));
+	partialCollisions.reserve(listCount);
+	for (size_t i = 0; i < listCount; i++)
+	{
+		partialCollisions.push_back(ArenaVector<Collision>(allocator));
+	}
+
+	m_workers->run((int)chunkCount, [&](int chunk, int thread)
+	{
+		size_t begin = chunk * PARALLEL_CHUNK_SIZE;
+		checkRange(begin, glm::min(begin + PARALLEL_CHUNK_SIZE, m_objects.size()), partialCollisions[m_deterministic ? chunk : thread]);
+	});
+
+	// Join the lists, in chunk order when deterministic
+	for (size_t i = 0; i < listCount; i++)
+	{
+		collisions.insert(collisions.end(), partialCollisions[i].begin(), partialCollisions[i].end());
 	}
 }
 
-void Physics::Scene:: resolveCollision()
+template <typename Real>
+void Physics::BasicScene<Real>::resolveCollision(const ArenaVector<Collision> & collisions)
 {
 	// TODO: COMMENT HERE
-	for (auto col : m_collisions)
+	for (auto col : collisions)
 	{
 		// If both objects are static, skip collision resolution
 		if (col.objA->getIsStatic() && col.objB->getIsStatic()) continue;
 	
 		// Inverse masses
-		float inverseMassObjA = 1 / col.objA->getMass();
-		float inverseMassObjB = 1 / col.objB->getMass();
+		Real inverseMassObjA = 1 / col.objA->getMass();
+		Real inverseMassObjB = 1 / col.objB->getMass();
 
 		// Calculate the relative velocity
-		vec3 relativeVelocity = col.objB->getVelocity() - col.objA->getVelocity();
+		Vector relativeVelocity = col.objB->getVelocity() - col.objA->getVelocity();
 
 		// Find out how much of the relative velocity goes along the collision vector
-		float impactForce = glm::dot(relativeVelocity, col.collisionNormal);
+		Real impactForce = glm::dot(relativeVelocity, col.collisionNormal);
 
 		// Average elasticity of both objects
-		float averageElasticity = (col.objA->getElasticity() + col.objB->getElasticity()) / 2;
+		Real averageElasticity = (col.objA->getElasticity() + col.objB->getElasticity()) / 2;
 
 		// Get the formula from our resources and calculate J
-		float impulseMagnitude = (-(1 + averageElasticity) * impactForce) /  (inverseMassObjA + inverseMassObjB);
+		Real impulseMagnitude = (-(1 + averageElasticity) * impactForce) /  (inverseMassObjA + inverseMassObjB);
 
 		// If both objects are spheres
 		if (col.objA->getShapeType() == ShapeType::SPHERE && col.objB->getShapeType() == ShapeType::SPHERE)
 		{
 			Sphere * sphereA = (Sphere*)col.objA;
 			Sphere * sphereB = (Sphere*)col.objB;
-			float penetration = (sphereA->getRadius() + sphereB->getRadius()) - (glm::distance(col.objB->getPosition(), col.objA->getPosition()));
+			Real penetration = (sphereA->getRadius() + sphereB->getRadius()) - (glm::distance(col.objB->getPosition(), col.objA->getPosition()));
 
 			// Seperate the two objects, using whatever detail of seperation you want
 			if (!col.objB->getIsStatic()) col.objB->setPosition(col.objB->getPosition() + (penetration / 2)* col.collisionNormal);
@@ -214,10 +2210,25 @@ void Physics::Scene:: resolveCollision()
 		{
 			// Cast to plane
 			Plane* plane = (Plane*)col.objA;
+
+			// Seperate the object from the plane if they are overlapping
+			Real distance = glm::dot(col.objB->getPosition(), plane->getDirection()) - plane->getDistance();
+			Real radius = Real(0);
+			if (col.objB->getShapeType() == ShapeType::SPHERE)
+			{
+				radius = ((Sphere*)col.objB)->getRadius();
+			}
+			else if (col.objB->getShapeType() == ShapeType::AABB)
+			{
+				// The "radius" of the AABB is each axis projected along the plane normal
+				Vector extents = ((AABB*)col.objB)->getExtents();
+				radius = extents.x * plane->getDirection().x + extents.y * plane->getDirection().y + extents.z * plane->getDirection().z;
+			}
+			if (!col.objB->getIsStatic()) col.objB->setPosition(col.objB->getPosition() + plane->getDirection() * (radius - distance));
 			
 			// Caclualte the velocity of the second object
 			// Resulting velocity = velocity - (1 + elasticity)velocity.collision normal * collision normal
-			vec3 velocity = col.objB->getVelocity() - (1 + col.objB->getElasticity())  * (glm::dot(col.objB->getVelocity(), plane->getDirection())) * plane->getDirection();
+			Vector velocity = col.objB->getVelocity() - (1 + col.objB->getElasticity())  * (glm::dot(col.objB->getVelocity(), plane->getDirection())) * plane->getDirection();
 
 			// Set velocity
 			col.objB->setVelocity(velocity);
@@ -246,7 +2257,7 @@ void Physics::Scene:: resolveCollision()
 			}
 		}
 	}
-	// Clears the vector as all collisions have been resolved
-	m_collisions.clear();
 }
 
+template class Physics::BasicScene<float>;
+template class Physics::BasicScene<double>;
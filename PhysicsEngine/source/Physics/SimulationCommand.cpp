@@ -0,0 +1,59 @@
+#include "Physics/SimulationCommand.h"
+using namespace Physics;
+
+template <typename Real>
+BasicSimulationCommand<Real> Physics::BasicSimulationCommand<Real>::spawnSphere(uint32_t id, const Vector & position, const Vector & velocity, Real radius, Real mass, const vec4 & color)
+{
+	BasicSimulationCommand command = BasicSimulationCommand();
+	command.type = CommandType::SPAWN;
+	command.time = Clock::now();
+	command.shape = ShapeType::SPHERE;
+	command.id = id;
+	command.position = position;
+	command.size = Vector(radius, Real(0), Real(0));
+	command.mass = mass;
+	command.color = color;
+	command.value = velocity;
+	return command;
+}
+
+template <typename Real>
+BasicSimulationCommand<Real> Physics::BasicSimulationCommand<Real>::spawnAABB(uint32_t id, const Vector & position, const Vector & velocity, const Vector & extents, Real mass, const vec4 & color)
+{
+	BasicSimulationCommand command = spawnSphere(id, position, velocity, Real(0), mass, color);
+	command.shape = ShapeType::AABB;
+	command.size = extents;
+	return command;
+}
+
+template <typename Real>
+BasicSimulationCommand<Real> Physics::BasicSimulationCommand<Real>::remove(Handle<BasicObject<Real>> target)
+{
+	BasicSimulationCommand command = BasicSimulationCommand();
+	command.type = CommandType::REMOVE;
+	command.time = Clock::now();
+	command.target = target;
+	return command;
+}
+
+template <typename Real>
+BasicSimulationCommand<Real> Physics::BasicSimulationCommand<Real>::applyImpulse(Handle<BasicObject<Real>> target, const Vector & impulse)
+{
+	BasicSimulationCommand command = remove(target);
+	command.type = CommandType::APPLY_IMPULSE;
+	command.value = impulse;
+	return command;
+}
+
+template <typename Real>
+BasicSimulationCommand<Real> Physics::BasicSimulationCommand<Real>::setGlobalForce(const Vector & force)
+{
+	BasicSimulationCommand command = BasicSimulationCommand();
+	command.type = CommandType::SET_GLOBAL_FORCE;
+	command.time = Clock::now();
+	command.value = force;
+	return command;
+}
+
+template struct Physics::BasicSimulationCommand<float>;
+template struct Physics::BasicSimulationCommand<double>;
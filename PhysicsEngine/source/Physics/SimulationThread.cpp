@@ -0,0 +1,90 @@
+#include "Physics/SimulationThread.h"
+#include "Physics/Scene.h"
+#include <chrono>
+using namespace Physics;
+
+template <typename Real>
+const float BasicSimulationThread<Real>::MAX_UPDATE_TIME = 0.25f;
+
+template <typename Real>
+Physics::BasicSimulationThread<Real>::BasicSimulationThread(Scene * scene) :
+	m_scene(scene), m_running(false)
+{
+}
+
+template <typename Real>
+BasicSimulationThread<Real>::~BasicSimulationThread()
+{
+	stop();
+}
+
+template <typename Real>
+void Physics::BasicSimulationThread<Real>::start()
+{
+	if (isRunning()) return;
+
+	// The render thread can draw this until the first update has stepped
+	publishSnapshot(RenderSnapshot::Clock::now());
+
+	m_running = true;
+	m_thread = std::thread(&BasicSimulationThread::run, this);
+}
+
+template <typename Real>
+void Physics::BasicSimulationThread<Real>::stop()
+{
+	if (!isRunning()) return;
+	m_running = false;
+	m_thread.join();
+}
+
+template <typename Real>
+void Physics::BasicSimulationThread<Real>::setLODFocus(const Vector & focus)
+{
+	m_lodFocus.getWriteBuffer() = focus;
+	m_lodFocus.publish();
+}
+
+template <typename Real>
+void Physics::BasicSimulationThread<Real>::run()
+{
+	typedef RenderSnapshot::Clock Clock;
+	Clock::time_point lastUpdate = Clock::now();
+	while (m_running.load())
+	{
+		// Pick up the focus if it has moved since the last update, commands are applied by the scene at its next step
+		if (m_lodFocus.hasNew())
+		{
+			m_scene->setLODFocus(m_lodFocus.acquire());
+		}
+
+		// Step the scene by the time since the last update, which is roughly a fixed step after the sleep below
+		Clock::time_point now = Clock::now();
+		float deltaTime = glm::min(std::chrono::duration<float>(now - lastUpdate).count(), MAX_UPDATE_TIME);
+		lastUpdate = now;
+		m_scene->applyGlobalForce();
+		m_scene->update(deltaTime);
+
+		// Only a step changes what is drawn, the time in between is covered by the snapshot's alpha
+		if (m_scene->getLastStepCount() > 0)
+		{
+			publishSnapshot(now);
+		}
+
+		// Sleep until the next fixed step is due
+		float untilNextStep = (1.0f - m_scene->getInterpolationAlpha()) * (float)m_scene->getFixedTimeStep();
+		std::this_thread::sleep_for(std::chrono::duration<float>(untilNextStep));
+	}
+}
+
+template <typename Real>
+void Physics::BasicSimulationThread<Real>::publishSnapshot(RenderSnapshot::Clock::time_point time)
+{
+	RenderSnapshot & snapshot = m_snapshots.getWriteBuffer();
+	m_scene->captureSnapshot(snapshot);
+	snapshot.setTiming(m_scene->getInterpolationAlpha(), (float)m_scene->getFixedTimeStep(), time);
+	m_snapshots.publish();
+}
+
+template class Physics::BasicSimulationThread<float>;
+template class Physics::BasicSimulationThread<double>;
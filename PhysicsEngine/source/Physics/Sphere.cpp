@@ -2,17 +2,23 @@
 #include <Gizmos.h>
 using namespace Physics;
 
-Physics::Sphere::Sphere(vec3 position, float radius, float mass, vec4 color, bool isStatic) : 
-	m_radius(radius), Object(Physics::ShapeType::SPHERE, position, mass, color, isStatic)
+template <typename Real>
+Physics::BasicSphere<Real>::BasicSphere(Vector position, Real radius, Real mass, vec4 color, bool isStatic, BodyStore * bodies) : 
+	m_radius(radius), BasicObject<Real>(Physics::ShapeType::SPHERE, position, mass, color, isStatic, bodies)
 {
 }
 
-Sphere::~Sphere()
+template <typename Real>
+BasicSphere<Real>::~BasicSphere()
 {
 }
 
-void Physics::Sphere::draw()
+template <typename Real>
+void Physics::BasicSphere<Real>::draw(float alpha)
 {
-	// Draws the sphere using its position, radius and colour
-	aie::Gizmos::addSphere(m_position, m_radius, 12, 12, m_color);
+	// Draws the sphere using its interpolated position, radius and colour
+	aie::Gizmos::addSphere(vec3(this->getInterpolatedPosition(alpha)), (float)m_radius, 12, 12, this->getColor());
 }
+
+template class Physics::BasicSphere<float>;
+template class Physics::BasicSphere<double>;
@@ -3,44 +3,66 @@
 #include <Gizmos.h>
 using namespace Physics;
 
-Physics::Spring::Spring(Object * objA, Object * objB, float restingLength, float springCoefficient, float damping) : 
-	m_restingLength(restingLength), m_springCoefficient(springCoefficient), m_damping(damping),Constraint( objA, objB)
+template <typename Real>
+Physics::BasicSpring<Real>::BasicSpring(Object * objA, Object * objB, Real restingLength, Real springCoefficient, Real damping) : 
+	m_restingLength(restingLength), m_springCoefficient(springCoefficient), m_damping(damping),BasicConstraint<Real>( objA, objB)
 {
 }
 
-Spring::~Spring()
+template <typename Real>
+BasicSpring<Real>::~BasicSpring()
 {
 }
 
-void Physics::Spring::update(float deltaTime)
+template <typename Real>
+void Physics::BasicSpring<Real>::update(Real deltaTime)
+{
+	// Apply the force to the objects
+	Vector force = computeForce();
+	this->m_objA->applyForce(force);
+	this->m_objB->applyForce(-force);
+}
+
+template <typename Real>
+typename BasicSpring<Real>::Vector Physics::BasicSpring<Real>::computeForce() const
 {
 	// A vector for the between the two objects that the spring connects
-	vec3 springVec = m_objA->getPosition() - m_objB->getPosition();
+	Vector springVec = this->m_objA->getPosition() - this->m_objB->getPosition();
 	
-	// The float distance between the two objects
-	float distance = glm::length(springVec);
+	// The distance between the two objects
+	Real distance = glm::length(springVec);
 
 	// Force vector, starting at 0,0,0
-	vec3 force = vec3();
+	Vector force = Vector();
 
 	// If the objects are not directly overlapping
-	if (distance != 0.f)
+	if (distance != Real(0))
 	{
 		// Increase force
 		// -vector normal * how far the distance is from resting length * strength of spring
-		force += -(springVec / distance) * (distance - m_restingLength) * m_springCoefficient;
+		force += -(springVec / distance) * (distance - getEffectiveRestingLength()) * m_springCoefficient;
 	}
 
 	// Apply dampening
-	force +=  -(m_objA->getVelocity() - m_objB->getVelocity()) * m_damping;
+	force +=  -(this->m_objA->getVelocity() - this->m_objB->getVelocity()) * m_damping;
+	return force;
+}
 
-	// Apply the force to the objects
-	m_objA->applyForce(force);
-	m_objB->applyForce(-force);
+template <typename Real>
+void Physics::BasicSpring<Real>::draw(float alpha)
+{
+	// Draw a line to represent the spring, between the interpolated positions so it stays attached to the drawn objects
+	aie::Gizmos::addLine(vec3(this->m_objA->getInterpolatedPosition(alpha)), vec3(this->m_objB->getInterpolatedPosition(alpha)), vec4(1.f, 1.f, 1.f, 1.f));
 }
 
-void Physics::Spring::draw()
+
+template <typename Real>
+Real Physics::BasicSpring<Real>::getPotentialEnergy() const
 {
-	// Draw a line to represent the spring
-	aie::Gizmos::addLine(m_objA->getPosition(), m_objB->getPosition(), vec4(1.f, 1.f, 1.f, 1.f));
+	// 1/2 k x^2 where x is how far the spring is from its resting length
+	Real stretch = glm::distance(this->m_objA->getPosition(), this->m_objB->getPosition()) - getEffectiveRestingLength();
+	return Real(0.5) * m_springCoefficient * stretch * stretch;
 }
+
+template class Physics::BasicSpring<float>;
+template class Physics::BasicSpring<double>;
@@ -0,0 +1,197 @@
+#include "Physics/SpringKernel.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+using namespace Physics;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYSICS_SPRING_KERNEL_SSE
+#include <emmintrin.h>
+#endif
+
+template <typename Real>
+void Physics::computeSpringForcesScalar(const SpringBatch<Real> & batch, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		int a = batch.bodyA[i];
+		int b = batch.bodyB[i];
+
+		// The same steps as Spring::computeForce, one axis at a time
+		Real springX = batch.positionX[a] - batch.positionX[b];
+		Real springY = batch.positionY[a] - batch.positionY[b];
+		Real springZ = batch.positionZ[a] - batch.positionZ[b];
+		Real distance = std::sqrt(springX * springX + springY * springY + springZ * springZ);
+
+		Real forceX = Real(0);
+		Real forceY = Real(0);
+		Real forceZ = Real(0);
+		if (distance != Real(0))
+		{
+			Real stretch = distance - batch.restingLength[i];
+			forceX += -(springX / distance) * stretch * batch.springCoefficient[i];
+			forceY += -(springY / distance) * stretch * batch.springCoefficient[i];
+			forceZ += -(springZ / distance) * stretch * batch.springCoefficient[i];
+		}
+		forceX += -(batch.velocityX[a] - batch.velocityX[b]) * batch.damping[i];
+		forceY += -(batch.velocityY[a] - batch.velocityY[b]) * batch.damping[i];
+		forceZ += -(batch.velocityZ[a] - batch.velocityZ[b]) * batch.damping[i];
+
+		batch.forceX[i] = forceX;
+		batch.forceY[i] = forceY;
+		batch.forceZ[i] = forceZ;
+	}
+}
+
+// Without a vector version for the precision, the kernel is the scalar loop
+template <typename Real>
+static void computeSpringForcesVector(const SpringBatch<Real> & batch, size_t begin, size_t end)
+{
+	computeSpringForcesScalar(batch, begin, end);
+}
+
+#ifdef PHYSICS_SPRING_KERNEL_SSE
+static void computeSpringForcesVector(const SpringBatch<float> & batch, size_t begin, size_t end)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		// The bodies are gathered one lane at a time, the springs are sorted so they are mostly close together
+		int a0 = batch.bodyA[i], a1 = batch.bodyA[i + 1], a2 = batch.bodyA[i + 2], a3 = batch.bodyA[i + 3];
+		int b0 = batch.bodyB[i], b1 = batch.bodyB[i + 1], b2 = batch.bodyB[i + 2], b3 = batch.bodyB[i + 3];
+
+		__m128 springX = _mm_sub_ps(_mm_setr_ps(batch.positionX[a0], batch.positionX[a1], batch.positionX[a2], batch.positionX[a3]),
+			_mm_setr_ps(batch.positionX[b0], batch.positionX[b1], batch.positionX[b2], batch.positionX[b3]));
+		__m128 springY = _mm_sub_ps(_mm_setr_ps(batch.positionY[a0], batch.positionY[a1], batch.positionY[a2], batch.positionY[a3]),
+			_mm_setr_ps(batch.positionY[b0], batch.positionY[b1], batch.positionY[b2], batch.positionY[b3]));
+		__m128 springZ = _mm_sub_ps(_mm_setr_ps(batch.positionZ[a0], batch.positionZ[a1], batch.positionZ[a2], batch.positionZ[a3]),
+			_mm_setr_ps(batch.positionZ[b0], batch.positionZ[b1], batch.positionZ[b2], batch.positionZ[b3]));
+		__m128 relativeX = _mm_sub_ps(_mm_setr_ps(batch.velocityX[a0], batch.velocityX[a1], batch.velocityX[a2], batch.velocityX[a3]),
+			_mm_setr_ps(batch.velocityX[b0], batch.velocityX[b1], batch.velocityX[b2], batch.velocityX[b3]));
+		__m128 relativeY = _mm_sub_ps(_mm_setr_ps(batch.velocityY[a0], batch.velocityY[a1], batch.velocityY[a2], batch.velocityY[a3]),
+			_mm_setr_ps(batch.velocityY[b0], batch.velocityY[b1], batch.velocityY[b2], batch.velocityY[b3]));
+		__m128 relativeZ = _mm_sub_ps(_mm_setr_ps(batch.velocityZ[a0], batch.velocityZ[a1], batch.velocityZ[a2], batch.velocityZ[a3]),
+			_mm_setr_ps(batch.velocityZ[b0], batch.velocityZ[b1], batch.velocityZ[b2], batch.velocityZ[b3]));
+
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(springX, springX), _mm_mul_ps(springY, springY)), _mm_mul_ps(springZ, springZ)));
+		__m128 stretch = _mm_sub_ps(distance, _mm_loadu_ps(batch.restingLength + i));
+		__m128 coefficient = _mm_loadu_ps(batch.springCoefficient + i);
+		__m128 damping = _mm_loadu_ps(batch.damping + i);
+
+		// Springs whose objects overlap divide by zero, their lanes are masked out to leave no spring force
+		__m128 apart = _mm_cmpneq_ps(distance, zero);
+		__m128 forceX = _mm_and_ps(apart, _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(_mm_div_ps(springX, distance), signBit), stretch), coefficient));
+		__m128 forceY = _mm_and_ps(apart, _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(_mm_div_ps(springY, distance), signBit), stretch), coefficient));
+		__m128 forceZ = _mm_and_ps(apart, _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(_mm_div_ps(springZ, distance), signBit), stretch), coefficient));
+
+		// Added to zero first as the scalar loop does, so a negative zero comes out the same
+		forceX = _mm_add_ps(_mm_add_ps(zero, forceX), _mm_mul_ps(_mm_xor_ps(relativeX, signBit), damping));
+		forceY = _mm_add_ps(_mm_add_ps(zero, forceY), _mm_mul_ps(_mm_xor_ps(relativeY, signBit), damping));
+		forceZ = _mm_add_ps(_mm_add_ps(zero, forceZ), _mm_mul_ps(_mm_xor_ps(relativeZ, signBit), damping));
+
+		_mm_storeu_ps(batch.forceX + i, forceX);
+		_mm_storeu_ps(batch.forceY + i, forceY);
+		_mm_storeu_ps(batch.forceZ + i, forceZ);
+	}
+
+	// The springs left over
+	computeSpringForcesScalar(batch, i, end);
+}
+#endif
+
+template <typename Real>
+void Physics::computeSpringForces(const SpringBatch<Real> & batch, size_t begin, size_t end)
+{
+	computeSpringForcesVector(batch, begin, end);
+}
+
+template <typename Real>
+bool Physics::isSpringKernelVectorized()
+{
+#ifdef PHYSICS_SPRING_KERNEL_SSE
+	return std::is_same<Real, float>::value;
+#else
+	return false;
+#endif
+}
+
+SpringKernelBenchmark Physics::benchmarkSpringKernel(int rows, int columns, int iterations)
+{
+	// The particles of a cloth, jittered so the springs are stretched by different amounts
+	int count = rows * columns;
+	std::vector<float> positionX(count), positionY(count), positionZ(count);
+	std::vector<float> velocityX(count), velocityY(count), velocityZ(count);
+	unsigned int seed = 12345;
+	auto jitter = [&seed]() { seed = seed * 1664525u + 1013904223u; return (float)(seed >> 8) / (float)(1 << 24) - 0.5f; };
+	for (int i = 0; i < count; i++)
+	{
+		positionX[i] = (float)(i % columns) + jitter() * 0.2f;
+		positionY[i] = jitter() * 0.2f;
+		positionZ[i] = (float)(i / columns) + jitter() * 0.2f;
+		velocityX[i] = jitter();
+		velocityY[i] = jitter();
+		velocityZ[i] = jitter();
+	}
+
+	// Structural and diagonal springs, in the order the scene sorts them into
+	std::vector<int> bodyA, bodyB;
+	std::vector<float> restingLength, springCoefficient, damping;
+	auto addSpring = [&](int a, int b, float length)
+	{
+		bodyA.push_back(a);
+		bodyB.push_back(b);
+		restingLength.push_back(length);
+		springCoefficient.push_back(10.0f);
+		damping.push_back(0.2f);
+	};
+	for (int i = 0; i < count; i++)
+	{
+		int row = i / columns;
+		int column = i % columns;
+		if (column + 1 < columns) addSpring(i, i + 1, 1.0f);
+		if (row + 1 < rows && column > 0) addSpring(i, i + columns - 1, 1.4f);
+		if (row + 1 < rows) addSpring(i, i + columns, 1.0f);
+		if (row + 1 < rows && column + 1 < columns) addSpring(i, i + columns + 1, 1.4f);
+	}
+
+	size_t springCount = bodyA.size();
+	std::vector<float> scalarForce(springCount * 3), kernelForce(springCount * 3);
+	SpringBatch<float> batch = { bodyA.data(), bodyB.data(), restingLength.data(), springCoefficient.data(), damping.data(),
+		positionX.data(), positionY.data(), positionZ.data(), velocityX.data(), velocityY.data(), velocityZ.data(),
+		nullptr, nullptr, nullptr };
+
+	// Times one of the two, after a pass to warm the caches
+	auto time = [&](std::vector<float> & force, void (*function)(const SpringBatch<float> &, size_t, size_t))
+	{
+		batch.forceX = force.data();
+		batch.forceY = force.data() + springCount;
+		batch.forceZ = force.data() + springCount * 2;
+		function(batch, 0, springCount);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			function(batch, 0, springCount);
+		}
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+	};
+
+	SpringKernelBenchmark result;
+	result.springCount = (int)springCount;
+	result.scalarTime = time(scalarForce, &computeSpringForcesScalar<float>);
+	result.kernelTime = time(kernelForce, &computeSpringForces<float>);
+	result.vectorized = isSpringKernelVectorized<float>();
+	result.matches = memcmp(scalarForce.data(), kernelForce.data(), scalarForce.size() * sizeof(float)) == 0;
+	return result;
+}
+
+template void Physics::computeSpringForcesScalar<float>(const SpringBatch<float> &, size_t, size_t);
+template void Physics::computeSpringForcesScalar<double>(const SpringBatch<double> &, size_t, size_t);
+template void Physics::computeSpringForces<float>(const SpringBatch<float> &, size_t, size_t);
+template void Physics::computeSpringForces<double>(const SpringBatch<double> &, size_t, size_t);
+template bool Physics::isSpringKernelVectorized<float>();
+template bool Physics::isSpringKernelVectorized<double>();
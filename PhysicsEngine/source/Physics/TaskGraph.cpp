@@ -0,0 +1,109 @@
+#include "Physics/TaskGraph.h"
+#include <cassert>
+using namespace Physics;
+
+Physics::TaskGraph::TaskGraph() :
+	m_remainingTasks(0), m_stats()
+{
+}
+
+void Physics::TaskGraph::clear()
+{
+	m_tasks.clear();
+	m_jobOffsets.clear();
+	m_jobStorage.clear();
+	m_names.clear();
+	m_dependencyBefore.clear();
+	m_dependencyAfter.clear();
+}
+
+void Physics::TaskGraph::addDependency(int before, int after)
+{
+	assert(before < after && after < (int)m_tasks.size());
+	m_dependencyBefore.push_back(before);
+	m_dependencyAfter.push_back(after);
+}
+
+void Physics::TaskGraph::run(WorkerPool * workers)
+{
+	// The storage has stopped growing, so the jobs can be pointed at
+	int taskCount = (int)m_tasks.size();
+	for (int task = 0; task < taskCount; task++)
+	{
+		m_tasks[task].job = &m_jobStorage[m_jobOffsets[task]];
+		m_tasks[task].remainingChunks = m_tasks[task].chunkCount;
+		m_tasks[task].pendingDependencies = 0;
+		m_tasks[task].started = false;
+	}
+
+	// Count the dependencies of each task and list the tasks waiting on each one, by counting sort on the earlier task
+	m_dependentOffsets.assign(taskCount + 1, 0);
+	for (size_t i = 0; i < m_dependencyBefore.size(); i++)
+	{
+		m_dependentOffsets[m_dependencyBefore[i] + 1]++;
+		m_tasks[m_dependencyAfter[i]].pendingDependencies++;
+	}
+	for (int task = 0; task < taskCount; task++)
+	{
+		m_dependentOffsets[task + 1] += m_dependentOffsets[task];
+	}
+	m_dependents.resize(m_dependencyBefore.size());
+	for (size_t i = 0; i < m_dependencyBefore.size(); i++)
+	{
+		m_dependents[m_dependentOffsets[m_dependencyBefore[i]]++] = m_dependencyAfter[i];
+	}
+	for (int task = taskCount; task > 0; task--)
+	{
+		m_dependentOffsets[task] = m_dependentOffsets[task - 1];
+	}
+	m_dependentOffsets[0] = 0;
+
+	m_startTimes.assign(taskCount, 0.0f);
+	m_endTimes.assign(taskCount, 0.0f);
+	m_threads.assign(taskCount, 0);
+	m_remainingTasks = taskCount;
+	m_stats = SchedulerStats();
+	m_stats.taskCount = taskCount;
+	m_runStart = Clock::now();
+
+	if (workers == nullptr)
+	{
+		// Added order respects the dependencies, so the tasks can simply be run in it
+		m_stats.threadCount = 1;
+		for (int task = 0; task < taskCount; task++)
+		{
+			onTaskStarted(task);
+			WorkerPool::Task & current = m_tasks[task];
+			for (int chunk = 0; chunk < current.chunkCount; chunk++)
+			{
+				current.function(current.job, chunk, 0);
+			}
+			m_stats.chunkCount += current.chunkCount;
+			onTaskFinished(task, 0);
+			m_stats.jobTime += m_endTimes[task] - m_startTimes[task];
+		}
+	}
+	else
+	{
+		WorkerStats before = workers->getStats();
+		workers->run(*this);
+		WorkerStats after = workers->getStats();
+		m_stats.threadCount = workers->getThreadCount();
+		m_stats.chunkCount = after.chunkCount - before.chunkCount;
+		m_stats.stealCount = after.stealCount - before.stealCount;
+		m_stats.jobTime = (float)(after.jobTime - before.jobTime);
+	}
+
+	m_stats.wallTime = std::chrono::duration<float, std::milli>(Clock::now() - m_runStart).count();
+}
+
+void Physics::TaskGraph::onTaskStarted(int task)
+{
+	m_startTimes[task] = std::chrono::duration<float, std::milli>(Clock::now() - m_runStart).count();
+}
+
+void Physics::TaskGraph::onTaskFinished(int task, int thread)
+{
+	m_endTimes[task] = std::chrono::duration<float, std::milli>(Clock::now() - m_runStart).count();
+	m_threads[task] = thread;
+}
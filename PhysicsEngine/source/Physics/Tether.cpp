@@ -0,0 +1,42 @@
+#include "Physics/Tether.h"
+#include "Physics/Object.h"
+using namespace Physics;
+
+template <typename Real>
+Physics::BasicTether<Real>::BasicTether(Object * anchor, Object * object, Real maxDistance) :
+	BasicConstraint<Real>(anchor, object), m_maxDistance(maxDistance)
+{
+}
+
+template <typename Real>
+BasicTether<Real>::~BasicTether()
+{
+}
+
+template <typename Real>
+void Physics::BasicTether<Real>::apply()
+{
+	// Static objects can't be moved
+	if (this->m_objB->getIsStatic()) return;
+
+	// A vector from the anchor to the object
+	Vector offset = this->m_objB->getPosition() - this->m_objA->getPosition();
+	Real distance = glm::length(offset);
+
+	// The constraint is one sided, it only acts once the object is too far away
+	if (distance <= m_maxDistance) return;
+
+	// Move the object back to the maximum distance
+	Vector direction = offset / distance;
+	this->m_objB->setPosition(this->m_objA->getPosition() + direction * m_maxDistance);
+
+	// Remove any velocity that would carry it further away from the anchor
+	Real outwardSpeed = glm::dot(this->m_objB->getVelocity() - this->m_objA->getVelocity(), direction);
+	if (outwardSpeed > Real(0))
+	{
+		this->m_objB->setVelocity(this->m_objB->getVelocity() - direction * outwardSpeed);
+	}
+}
+
+template class Physics::BasicTether<float>;
+template class Physics::BasicTether<double>;
@@ -0,0 +1,308 @@
+#include "Physics/WorkerPool.h"
+#include "Physics/TaskGraph.h"
+#include <cassert>
+#include <chrono>
+using namespace Physics;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// The pool the current thread belongs to and its number in it
+static thread_local const WorkerPool * s_currentPool = nullptr;
+static thread_local int s_currentThread = 0;
+
+// Milliseconds since a point in time
+static inline double millisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Physics::WorkerPool::Task::Task(const Task & other) :
+	function(other.function), job(other.job), chunkCount(other.chunkCount), remainingChunks(other.remainingChunks.load()),
+	graph(other.graph), index(other.index), pendingDependencies(other.pendingDependencies.load()), started(other.started.load())
+{
+}
+
+Physics::WorkerPool::WorkerPool(int threadCount) :
+	m_activeRuns(0), m_stopping(false)
+{
+	m_threads = new ThreadState[threadCount];
+
+	// The calling thread is thread 0, so one less worker is needed
+	for (int thread = 1; thread < threadCount; thread++)
+	{
+		m_workers.push_back(std::thread(&WorkerPool::workerLoop, this, thread));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	// Wake every worker so they see they have to stop
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_workReady.notify_all();
+
+	for (auto & worker : m_workers)
+	{
+		worker.join();
+	}
+	delete[] m_threads;
+}
+
+WorkerStats Physics::WorkerPool::getStats() const
+{
+	WorkerStats stats = { 0, 0, 0.0 };
+	for (int thread = 0; thread < getThreadCount(); thread++)
+	{
+		stats.chunkCount += m_threads[thread].chunkCount;
+		stats.stealCount += m_threads[thread].stealCount;
+		stats.jobTime += m_threads[thread].jobTime;
+	}
+	return stats;
+}
+
+void Physics::WorkerPool::runJob(int chunkCount, JobFunction function, const void * job)
+{
+	if (chunkCount <= 0) return;
+
+	// Without workers there is nothing to share
+	if (m_workers.empty())
+	{
+		for (int chunk = 0; chunk < chunkCount; chunk++)
+		{
+			function(job, chunk, 0);
+		}
+		return;
+	}
+
+	Task task;
+	task.function = function;
+	task.job = job;
+	task.chunkCount = chunkCount;
+	task.remainingChunks = chunkCount;
+	task.graph = nullptr;
+	task.index = 0;
+	task.pendingDependencies = 0;
+	task.started = true;
+
+	// Push the chunks onto this thread's deque and work until they are done, the task must outlive every chunk
+	int thread = getCurrentThread();
+	bool outside = s_currentPool != this;
+	OutsideThread previous;
+	if (outside) previous = beginRun();
+	pushTask(thread, &task);
+	runUntil(thread, [&]() { return task.remainingChunks.load() == 0; });
+	if (outside) endRun(previous);
+}
+
+void Physics::WorkerPool::run(TaskGraph & graph)
+{
+	int thread = getCurrentThread();
+	bool outside = s_currentPool != this;
+	OutsideThread previous;
+	if (outside) previous = beginRun();
+
+	// Tasks with nothing to wait for are pushed in reverse, so the thread takes them in the order they were added
+	for (int task = (int)graph.m_tasks.size() - 1; task >= 0; task--)
+	{
+		if (graph.m_tasks[task].pendingDependencies.load() == 0)
+		{
+			pushTask(thread, &graph.m_tasks[task]);
+		}
+	}
+	runUntil(thread, [&]() { return graph.m_remainingTasks.load() == 0; });
+	if (outside) endRun(previous);
+}
+
+WorkerPool::OutsideThread Physics::WorkerPool::beginRun()
+{
+	// The thread is thread 0 for the length of the run, a worker of another pool goes back to being one afterwards
+	OutsideThread previous = { s_currentPool, s_currentThread };
+	s_currentPool = this;
+	s_currentThread = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		assert(m_activeRuns == 0 && "WorkerPool run from two outside threads at once");
+		m_activeRuns++;
+	}
+	m_workReady.notify_all();
+	return previous;
+}
+
+void Physics::WorkerPool::endRun(const OutsideThread & previous)
+{
+	m_activeRuns--;
+	s_currentPool = previous.pool;
+	s_currentThread = previous.thread;
+}
+
+int Physics::WorkerPool::getCurrentThread() const
+{
+	return s_currentPool == this ? s_currentThread : 0;
+}
+
+bool Physics::WorkerPool::push(int thread, const WorkItem & item)
+{
+	ThreadState & state = m_threads[thread];
+	std::lock_guard<std::mutex> lock(state.mutex);
+	if (state.back - state.front == DEQUE_CAPACITY) return false;
+	state.items[state.back++ % DEQUE_CAPACITY] = item;
+	return true;
+}
+
+bool Physics::WorkerPool::take(int thread, WorkItem & item)
+{
+	// The newest range of this thread's own work, which is the most likely to still be in its cache
+	{
+		ThreadState & state = m_threads[thread];
+		std::lock_guard<std::mutex> lock(state.mutex);
+		if (state.back != state.front)
+		{
+			item = state.items[--state.back % DEQUE_CAPACITY];
+			return true;
+		}
+	}
+
+	// Otherwise the oldest range of another thread, starting with the next one so the threads don't all pick the same
+	int threadCount = getThreadCount();
+	for (int offset = 1; offset < threadCount; offset++)
+	{
+		ThreadState & victim = m_threads[(thread + offset) % threadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.back != victim.front)
+		{
+			item = victim.items[victim.front++ % DEQUE_CAPACITY];
+			m_threads[thread].stealCount++;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Physics::WorkerPool::runOne(int thread)
+{
+	WorkItem item;
+	if (!take(thread, item)) return false;
+	runItem(thread, item);
+	return true;
+}
+
+void Physics::WorkerPool::runItem(int thread, WorkItem item)
+{
+	// Leave the upper half for other threads until one chunk is left
+	while (item.end - item.begin > 1)
+	{
+		int middle = item.begin + (item.end - item.begin) / 2;
+		if (!push(thread, { item.task, middle, item.end })) break;
+		item.end = middle;
+	}
+	for (int chunk = item.begin; chunk < item.end; chunk++)
+	{
+		runChunk(thread, item.task, chunk);
+	}
+}
+
+void Physics::WorkerPool::runChunk(int thread, Task * task, int chunk)
+{
+	ThreadState & state = m_threads[thread];
+	if (task->graph != nullptr && !task->started.exchange(true))
+	{
+		task->graph->onTaskStarted(task->index);
+	}
+
+	// Only the outermost job is timed, less whatever time it spent waiting inside runs it started
+	Clock::time_point start;
+	double waitTime = state.waitTime;
+	if (state.depth++ == 0)
+	{
+		start = Clock::now();
+	}
+	task->function(task->job, chunk, thread);
+	if (--state.depth == 0)
+	{
+		state.jobTime += millisecondsSince(start) - (state.waitTime - waitTime);
+	}
+	state.chunkCount++;
+
+	// A plain run's task belongs to the thread waiting on it and may be gone as soon as the last chunk is counted
+	TaskGraph * graph = task->graph;
+	if (--task->remainingChunks == 0 && graph != nullptr)
+	{
+		finishTask(thread, task);
+	}
+}
+
+void Physics::WorkerPool::pushTask(int thread, Task * task)
+{
+	if (task->chunkCount == 0)
+	{
+		finishTask(thread, task);
+		return;
+	}
+
+	WorkItem item = { task, 0, task->chunkCount };
+	if (!push(thread, item))
+	{
+		runItem(thread, item);
+	}
+}
+
+void Physics::WorkerPool::finishTask(int thread, Task * task)
+{
+	TaskGraph * graph = task->graph;
+	graph->onTaskFinished(task->index, thread);
+	for (int entry = graph->m_dependentOffsets[task->index]; entry < graph->m_dependentOffsets[task->index + 1]; entry++)
+	{
+		Task & dependent = graph->m_tasks[graph->m_dependents[entry]];
+		if (--dependent.pendingDependencies == 0)
+		{
+			pushTask(thread, &dependent);
+		}
+	}
+
+	// Counted last, the graph's run returns as soon as this reaches zero
+	graph->m_remainingTasks--;
+}
+
+template <typename Done>
+void Physics::WorkerPool::runUntil(int thread, Done done)
+{
+	ThreadState & state = m_threads[thread];
+	while (!done())
+	{
+		if (runOne(thread)) continue;
+
+		// Nothing to take, the rest of the work is being run by other threads
+		Clock::time_point start = Clock::now();
+		std::this_thread::yield();
+		if (state.depth > 0)
+		{
+			state.waitTime += millisecondsSince(start);
+		}
+	}
+}
+
+void Physics::WorkerPool::workerLoop(int thread)
+{
+	s_currentPool = this;
+	s_currentThread = thread;
+	while (true)
+	{
+		// Sleep until a run starts
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workReady.wait(lock, [&]() { return m_stopping || m_activeRuns.load() > 0; });
+			if (m_stopping) return;
+		}
+
+		// Take work until every run has finished
+		while (m_activeRuns.load() > 0)
+		{
+			if (!runOne(thread))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
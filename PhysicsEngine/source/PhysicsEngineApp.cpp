@@ -3,7 +3,15 @@
 #include "Gizmos.h"
 #include "Input.h"
 
+#include "Physics/AllocationTracker.h"
+#include "Physics/Cloth.h"
+#include "Physics/Ensemble.h"
+#include "Physics/FramePipeline.h"
+#include "Physics/MemoryAccounting.h"
+#include "Physics/RenderSnapshot.h"
 #include "Physics/Scene.h"
+#include "Physics/SimulationCommand.h"
+#include "Physics/SimulationThread.h"
 #include "Physics/Object.h"
 #include "Physics/Sphere.h"
 #include "Physics/Plane.h"
@@ -13,6 +21,8 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <imgui.h>
+#include <cmath>
+#include <cstdio>
 
 using glm::vec3;
 using glm::vec4;
@@ -33,7 +43,11 @@ bool PhysicsEngineApp::startup() {
 	setBackgroundColour(0.25f, 0.25f, 0.25f);
 
 	// initialise gizmo primitive counts
-	Gizmos::create(100000, 100000, 100000, 100000);
+	const int maxLines = 100000, maxTris = 100000, max2DLines = 100000, max2DTris = 100000;
+	{
+		MemoryScope scope(MemoryCategory::RENDERING);
+		Gizmos::create(maxLines, maxTris, max2DLines, max2DTris);
+	}
 
 	// create simple camera transforms
 	m_camera = new Camera();
@@ -41,47 +55,105 @@ bool PhysicsEngineApp::startup() {
 	m_camera->SetPosition(glm::vec3(10, 10, 10));
 	m_camera->Lookat(glm::vec3(0, 0, 0));
 	
+	// Create a scene using the default integrator
+	createScene(IntegratorType::SYMPLECTIC_EULER);
+	return true;
+}
+
+void PhysicsEngineApp::createScene(IntegratorType integrator)
+{
+	// Keep the threading settings of the previous scene
+	int threadCount = 1;
+	bool deterministic = false;
+	if (m_scene != nullptr)
+	{
+		threadCount = m_scene->getThreadCount();
+		deterministic = m_scene->getDeterministic();
+	}
+
+	// The pipeline steps the scene, so it is rebuilt around the new one
+	bool pipelined = m_framePipeline != nullptr;
+	setFramePipeline(false);
+
+	// Remove the previous scene if there is one
+	delete m_scene;
+
 	// Create a scene
-	m_scene = new Scene();
+	m_scene = new Scene(integrator);
+	m_scene->setThreadCount(threadCount);
+	m_scene->setDeterministic(deterministic);
+
+	// Fill it with the default objects
+	buildDefaultScene(*m_scene, m_compactCloth);
+
+	// No sphere has been shot in the new scene and there is no global force
+	m_sphere = ObjectHandle();
+	m_globalForce = vec3(0);
+
+	// Record the starting energy to measure drift against, once everything added has been applied
+	m_scene->applyCommands();
+	m_startEnergy = m_scene->getTotalEnergy();
+
+	setFramePipeline(pipelined);
+}
+
+template <typename Real>
+void PhysicsEngineApp::buildDefaultScene(BasicScene<Real> & scene, bool compactCloth)
+{
+	// Rigid bodies and contacts are stepped at 60Hz, the stiff springs and cloth at 240Hz
+	scene.setFixedTimeStep(1.0f / 60.0f);
+	scene.setSpringTimeStep(1.0f / 240.0f);
+
+	// Objects far from the camera are simulated at a lower rate
+	scene.setLODDistances(40.0f, 80.0f);
+
+	// Tether the cloth to its pins so it holds its shape without extra substeps
+	scene.setLongRangeAttachments(true);
 
 	// Make heavy object
-	m_sphere = new Sphere(vec3(0.f,20.f,10.0f), 2.0f, 3.0f, vec4(0.2f, 0.1f, 0.7f, 0.9f), false);
-	m_scene->addObject(m_sphere);
+	BasicSphere<Real> * sphere = scene.createSphere(vec3(0.f,20.f,10.0f), 2.0f, 3.0f, vec4(0.2f, 0.1f, 0.7f, 0.9f), false);
 
 
 	// Make light object
-	Sphere * sphere2 = new Sphere(vec3(20.0f, 20.0f, 10.0f),0.5f,1.0f, vec4(1.0f, 1.0f, 0.2f, 1.0f), false);
-	m_scene->addObject(sphere2);
+	BasicSphere<Real> * sphere2 = scene.createSphere(vec3(20.0f, 20.0f, 10.0f),0.5f,1.0f, vec4(1.0f, 1.0f, 0.2f, 1.0f), false);
 
 	// Create a plane
-	Plane * plane = new Plane(0, vec3(0, 1, 0), vec4(0.2f, 1.0f, 0.2f, 0.7f));
-	m_scene->addObject(plane);
+	BasicPlane<Real> * plane = new BasicPlane<Real>(0, vec3(0, 1, 0), vec4(0.2f, 1.0f, 0.2f, 0.7f));
+	scene.addObject(plane);
 
 	// Create a plane
-	Plane * plane2 = new Plane(-20, vec3(1, 0, 0), vec4(0.4f, 1.0f, 0.2f, 1.0f));
-	m_scene->addObject(plane2);
+	BasicPlane<Real> * plane2 = new BasicPlane<Real>(-20, vec3(1, 0, 0), vec4(0.4f, 1.0f, 0.2f, 1.0f));
+	scene.addObject(plane2);
 
 	// Make static sphere
-	Sphere * sphere3 = new Sphere(vec3(-3.0f, 10.f, 3.0f), 2.0f, 1.0f, vec4(1.0f, 1.0f, 0.2f, 1.0f), true);
-	m_scene->addObject(sphere3);
+	scene.createSphere(vec3(-3.0f, 10.f, 3.0f), 2.0f, 1.0f, vec4(1.0f, 1.0f, 0.2f, 1.0f), true);
 
 	// Spring between light and heavy sphere
-	m_spring = new Spring(m_sphere, sphere2, 5.0f, 100.f, 1.f);
-	m_scene->addSpring(m_spring);
+	scene.createSpring(sphere, sphere2, 5.0f, 100.f, 1.f);
 
-	// Make Cloth
-	MakeCloth(5, 5, vec3(0, 10, 0));
+	// Make Cloth, either from spheres and springs or as a compact cloth pinned at the same corners
+	if (compactCloth)
+	{
+		BasicCloth<Real> * cloth = new BasicCloth<Real>(5, 5, vec3(0, 10, 0), 1.0f, 0.1f, 10.f, 0.2f, vec4(1.0f, 1.0f, 1.0f, 1.0f), true);
+		cloth->setPinned(0, 4);
+		cloth->setPinned(4, 4);
+		scene.addCloth(cloth);
+	}
+	else
+	{
+		vec3 origin(0, 10, 0);
+		MakeCloth(scene, 5, 5, origin);
+	}
 
 	// Make static box
-	AABB * box = new AABB(vec3(2, 2, 2), vec3(2, 2, 2), 2.f, vec4(1.0f, 1.0f, 0.2f, 1.0f), true);
-	m_scene->addObject(box);
-
-	m_sphere = nullptr;
-	return true;
+	scene.createAABB(vec3(2, 2, 2), vec3(2, 2, 2), 2.f, vec4(1.0f, 1.0f, 0.2f, 1.0f), true);
 }
 
 void PhysicsEngineApp::shutdown() 
 {
+	// The thread and the pipeline step the scene, so they go first
+	delete m_simulationThread;
+	delete m_framePipeline;
 	delete m_scene;
 	delete m_camera;
 	Gizmos::destroy();
@@ -89,6 +161,32 @@ void PhysicsEngineApp::shutdown()
 
 void PhysicsEngineApp::update(float deltaTime) 
 {
+	// The frame before ends as this one starts. Its pipelined step is waited for here, after which the scene is idle
+	// until this frame's step begins, and the frame before is complete for the timeline
+	m_frameTimes.end = RenderSnapshot::Clock::now();
+	if (m_framePipeline != nullptr)
+	{
+		m_framePipeline->waitForStep();
+		const PipelineStepTimes & step = m_framePipeline->getStepTimes();
+		m_frameTimes.stepStart = step.start;
+		m_frameTimes.stepEnd = step.end;
+		m_frameTimes.waitTime = step.waitTime;
+	}
+	m_lastFrameTimes = m_frameTimes;
+	m_frameTimes = FrameTimes();
+	m_frameTimes.start = m_lastFrameTimes.end;
+
+	// The windows read and change the scene and can replace it. Pipelined, they go here while no step is running and
+	// before input sends the scene commands, so none go to a scene they replace. Otherwise they go after this frame's
+	// step so they show its stats
+	bool windowsBeforeStep = m_framePipeline != nullptr;
+	if (windowsBeforeStep)
+	{
+		drawDebugWindow();
+		drawMemoryWindow();
+		drawFrameTimeline();
+	}
+
 	// Update camera
 	m_camera->Update(deltaTime);
 
@@ -115,54 +213,509 @@ void PhysicsEngineApp::update(float deltaTime)
 	if (input->isKeyDown(aie::INPUT_KEY_ESCAPE))
 		quit();
 
-	// On mouse click, create AABB and shoot it forward
+	// Input is sent to the scene as commands, which it applies at the start of its next fixed step on whichever thread
+	// is stepping it
 	if (input->wasMouseButtonPressed(aie::INPUT_MOUSE_BUTTON_LEFT))
 	{
-		AABB * box = new AABB(m_camera->GetPosition(), vec3(2, 2, 2), 2.f, vec4(1.0f, 1.0f, 0.2f, 1.0f), false);
-		m_scene->addObject(box);
-		box->setVelocity(m_camera->getHeading() * 15.f);
+		// On mouse click, create AABB and shoot it forward
+		m_scene->pushCommand(SimulationCommand::spawnAABB(m_nextSpawnId++, m_camera->GetPosition(), m_camera->getHeading() * 15.f, vec3(2, 2, 2), 2.f, vec4(1.0f, 1.0f, 0.2f, 1.0f)));
 	}
-
-	// When E is pressed, create sphere and shoot it forward
 	if (input->wasKeyPressed(aie::INPUT_KEY_E))
 	{
-		m_sphere = new Sphere(m_camera->GetPosition(), 1.f, 1.0f, vec4(0.4f, 0.5f, 0.1f, 0.8f), false);
-		m_scene->addObject(m_sphere);
-		m_sphere->setVelocity(m_camera->getHeading() * 15.f);
+		// When E is pressed, create sphere and shoot it forward
+		m_sphereSpawnId = m_nextSpawnId++;
+		m_scene->pushCommand(SimulationCommand::spawnSphere(m_sphereSpawnId, m_camera->GetPosition(), m_camera->getHeading() * 15.f, 1.f, 1.0f, vec4(0.4f, 0.5f, 0.1f, 0.8f)));
 	}
-	
+
+	// The handle of the most recent sphere comes back once it has been spawned
+	SpawnResult spawned;
+	while (m_scene->popSpawnResult(spawned))
+	{
+		if (spawned.id == m_sphereSpawnId)
+		{
+			m_sphere = spawned.handle;
+		}
+	}
+
 	// Deletes the most recent sphere created by the user
 	if (input->wasKeyPressed(aie::INPUT_KEY_Q))
 	{
-		if (m_sphere != nullptr)
+		// The handle stops resolving once the sphere has been removed, so removing twice does nothing
+		m_scene->pushCommand(SimulationCommand::remove(m_sphere));
+	}
+
+	// Knocks the most recent sphere upwards when R is pressed
+	if (input->wasKeyPressed(aie::INPUT_KEY_R))
+	{
+		m_scene->pushCommand(SimulationCommand::applyImpulse(m_sphere, vec3(0, 10.f, 0)));
+	}
+
+	if (m_simulationThread != nullptr)
+	{
+		// The simulation thread steps the scene itself
+		m_simulationThread->setLODFocus(m_camera->GetPosition());
+	}
+	else if (m_framePipeline != nullptr)
+	{
+		// The step runs while this frame is drawn from the snapshot of the last one
+		m_framePipeline->beginStep(deltaTime, m_camera->GetPosition());
+		m_frameTimes.stepped = true;
+	}
+	else
+	{
+		// The level of detail is relative to the camera
+		m_scene->setLODFocus(m_camera->GetPosition());
+
+		// Apply global for and update scene
+		m_frameTimes.stepStart = RenderSnapshot::Clock::now();
+		m_scene->applyGlobalForce();
+		m_scene->update(deltaTime);
+		m_frameTimes.stepEnd = RenderSnapshot::Clock::now();
+		m_frameTimes.stepped = true;
+	}
+
+	if (!windowsBeforeStep)
+	{
+		drawDebugWindow();
+		drawMemoryWindow();
+		drawFrameTimeline();
+	}
+}
+
+bool PhysicsEngineApp::runAllocationCheck()
+{
+	if (!AllocationTracker::isEnabled())
+	{
+		printf("Allocation check: allocation tracking isn't compiled in, define PHYSICS_TRACK_ALLOCATIONS\n");
+		return false;
+	}
+
+	const int warmUpSteps = 600;
+	const int checkedSteps = 10000;
+	const char * passNames[] = { "default scene", "default scene with a large cloth" };
+	bool passed = true;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		createScene(IntegratorType::SYMPLECTIC_EULER);
+		if (pass == 1)
+		{
+			vec3 origin(-40, 40, 0);
+			MakeCloth(*m_scene, 30, 30, origin);
+		}
+
+		// Let every buffer reach its working size before the guard goes on
+		for (int i = 0; i < warmUpSteps; i++)
+		{
+			m_scene->applyGlobalForce();
+			m_scene->update(m_scene->getFixedTimeStep());
+		}
+		// Failures are counted rather than asserted, so the check reports every step that allocated
+		m_scene->setAllocationGuard(true, false);
+		for (int i = 0; i < checkedSteps; i++)
+		{
+			m_scene->applyGlobalForce();
+			m_scene->update(m_scene->getFixedTimeStep());
+		}
+
+		int failures = m_scene->getAllocationGuardFailures();
+		printf("Allocation check, %s: %d of %d steps allocated\n", passNames[pass], failures, checkedSteps);
+		passed = passed && failures == 0;
+	}
+
+	delete m_scene;
+	m_scene = nullptr;
+	return passed;
+}
+
+void PhysicsEngineApp::setSimulationThread(bool enabled)
+{
+	if (enabled && m_simulationThread == nullptr)
+	{
+		setFramePipeline(false);
+		m_simulationThread = new SimulationThread(m_scene);
+		m_simulationThread->start();
+	}
+	else if (!enabled && m_simulationThread != nullptr)
+	{
+		// Stopping waits for the step in progress, after which the scene is the app's again
+		delete m_simulationThread;
+		m_simulationThread = nullptr;
+	}
+}
+
+void PhysicsEngineApp::setFramePipeline(bool enabled)
+{
+	if (enabled && m_framePipeline == nullptr)
+	{
+		setSimulationThread(false);
+		m_framePipeline = new FramePipeline(m_scene);
+	}
+	else if (!enabled && m_framePipeline != nullptr)
+	{
+		// Destroying the pipeline waits for its step, after which the scene is the app's again
+		delete m_framePipeline;
+		m_framePipeline = nullptr;
+	}
+}
+
+bool PhysicsEngineApp::runEnsemble(int instanceCount, int steps, int threadCount)
+{
+	// Every instance is the default scene, sweeping spring coefficient, elasticity and friction across them
+	Ensemble ensemble([](Scene & scene) { buildDefaultScene(scene, false); });
+	const float elasticities[] = { 0.3f, 0.6f, 0.9f };
+	const float frictions[] = { 0.0f, 0.3f, 0.6f };
+	for (int i = 0; i < instanceCount; i++)
+	{
+		EnsembleOverrides overrides;
+		overrides.elasticity = elasticities[i % 3];
+		overrides.friction = frictions[(i / 3) % 3];
+		overrides.springCoefficient = 5.0f + 5.0f * (i / 9);
+		ensemble.addInstance(overrides);
+	}
+
+	ensemble.run(steps, threadCount);
+
+	printf("Instance  Spring  Elasticity  Friction  Energy drift  Max stretch  Time (ms)  Hash\n");
+	bool stable = true;
+	for (int i = 0; i < ensemble.getInstanceCount(); i++)
+	{
+		const EnsembleOverrides & overrides = ensemble.getOverrides(i);
+		const EnsembleMetrics & metrics = ensemble.getMetrics(i);
+		printf("%8d  %6.1f  %10.2f  %8.2f  %12.2f  %10.2f%%  %9.2f  %016llx\n", i, overrides.springCoefficient, overrides.elasticity, overrides.friction,
+			metrics.energy - metrics.startEnergy, metrics.maxStretch * 100.0f, metrics.runTime, (unsigned long long)metrics.stateHash);
+		stable = stable && std::isfinite(metrics.energy);
+	}
+	printf("%d instances of %d steps on %d threads: %.2f ms, %.2f ms of instance time, %.0f instance steps per second\n", ensemble.getInstanceCount(), steps,
+		threadCount, ensemble.getLastRunTime(), ensemble.getInstanceRunTime(), ensemble.getInstanceCount() * steps * 1000.0f / ensemble.getLastRunTime());
+	return stable;
+}
+
+bool PhysicsEngineApp::runPrecisionBenchmark(int steps)
+{
+	// The same scene and the same updates in both, so the difference is only the precision
+	bool finite = runPrecisionPass<float>("Scene", steps);
+	finite = runPrecisionPass<double>("DoubleScene", steps) && finite;
+	return finite;
+}
+
+template <typename Real>
+bool PhysicsEngineApp::runPrecisionPass(const char * precision, int steps)
+{
+	BasicScene<Real> scene(IntegratorType::SYMPLECTIC_EULER);
+	buildDefaultScene(scene, false);
+
+	// Behind the default objects and clear of the wall at x = -20
+	vec3 origin(-10, 40, -20);
+	MakeCloth(scene, 40, 40, origin);
+	scene.applyCommands();
+	Real startEnergy = scene.getTotalEnergy();
+
+	float updateTime = 0.0f;
+	size_t bodyBytes = 0;
+	for (int i = 0; i < steps; i++)
+	{
+		scene.applyGlobalForce();
+		scene.update((float)scene.getFixedTimeStep());
+		updateTime += scene.getLastUpdateTime();
+		bodyBytes = glm::max(bodyBytes, scene.getBodyBytesPerStep());
+	}
+
+	Real energy = scene.getTotalEnergy();
+	printf("%s: %d updates, %.4f ms per update, %d body bytes per step, energy drift %.4f\n", precision, steps, updateTime / steps,
+		(int)bodyBytes, (double)(energy - startEnergy));
+	return std::isfinite((double)energy);
+}
+
+void PhysicsEngineApp::drawDebugWindow()
+{
+	ImGui::Begin("Physics Debug");
+
+	// Stepping on a thread of its own, the rest of the window reads the scene so it only shows the snapshot's stats then
+	bool simulationThread = m_simulationThread != nullptr;
+	if (ImGui::Checkbox("Simulation thread", &simulationThread))
+	{
+		setSimulationThread(simulationThread);
+	}
+
+	// Pipelined, the window is drawn between steps so the whole scene can still be shown and changed
+	bool framePipeline = m_framePipeline != nullptr;
+	if (ImGui::Checkbox("Pipelined frame", &framePipeline))
+	{
+		setFramePipeline(framePipeline);
+	}
+	if (m_simulationThread != nullptr)
+	{
+		const SnapshotStats & stats = m_simulationThread->acquireSnapshot().getStats();
+		ImGui::Text("Update: %.3f ms (%d steps)", stats.updateTime, stats.stepCount);
+		ImGui::Text("Step: %u", stats.stepIndex);
+		ImGui::Text("Objects: %d, springs: %d, cloth particles: %d", stats.objectCount, stats.springCount, stats.particleCount);
+	}
+
+	// Sent as a command, so it can be changed while the simulation thread runs
+	if (ImGui::DragFloat3("Global force", &m_globalForce.x, 0.1f))
+	{
+		m_scene->pushCommand(SimulationCommand::setGlobalForce(m_globalForce));
+	}
+	if (m_simulationThread != nullptr)
+	{
+		ImGui::End();
+		return;
+	}
+
+	// What the commands applied during the last update waited for
+	const CommandStats & commands = m_scene->getCommandStats();
+	ImGui::Text("Commands: %d (%.3f ms average wait, %.3f ms max, %d dropped)", commands.appliedCount, commands.averageLatency, commands.maxLatency, commands.droppedCount);
+	ImGui::Text("Spawn results dropped: %d", commands.droppedResultCount);
+
+	// Integrator selection, recreates the scene when changed
+	const char * integrators[] = { "Symplectic Euler", "Velocity Verlet", "RK4" };
+	int integrator = (int)m_scene->getIntegrator();
+	if (ImGui::Combo("Integrator", &integrator, integrators, 3))
+	{
+		createScene((IntegratorType)integrator);
+	}
+
+	// Cost of the last update, per frame and per fixed step
+	int steps = m_scene->getLastStepCount();
+	ImGui::Text("Update: %.3f ms (%d steps)", m_scene->getLastUpdateTime(), steps);
+	ImGui::Text("Spring substeps: %d", m_scene->getSpringSubsteps());
+
+	// Fused spring kernel, only used by the symplectic Euler integrator, toggled to compare the per step cost
+	bool fusedSpringKernel = m_scene->getFusedSpringKernel();
+	if (ImGui::Checkbox("Fused spring kernel", &fusedSpringKernel))
+	{
+		m_scene->setFusedSpringKernel(fusedSpringKernel);
+	}
+
+	// Compact cloth, recreates the scene to swap the cloth of spheres and springs for one
+	if (ImGui::Checkbox("Compact cloth", &m_compactCloth))
+	{
+		createScene(m_scene->getIntegrator());
+	}
+	for (auto cloth : m_scene->getCloths())
+	{
+		ImGui::Text("Cloth: %d particles, %d bytes (%d per particle)", cloth->getParticleCount(), (int)cloth->getMemoryBytes(), (int)Cloth::getBytesPerParticle(cloth->getCompactVelocity()));
+	}
+
+	// Heap allocations by the last update, zero once the scene has warmed up
+	ImGui::Text("Allocations last update: %d", m_scene->getLastUpdateAllocations());
+
+	// Scratch memory used by each fixed step
+	FrameArena & arena = m_scene->getFrameArena();
+	ImGui::Text("Frame arena: %d KB peak of %d KB (%d overflows)", (int)(arena.getHighWaterMark() / 1024), (int)(arena.getCapacity() / 1024), arena.getOverflowCount());
+	bool poisonFreed = arena.getPoisonFreed();
+	if (ImGui::Checkbox("Poison freed scratch memory", &poisonFreed))
+	{
+		arena.setPoisonFreed(poisonFreed);
+	}
+
+	// Threads the scene steps with, the hash of a deterministic scene is the same for any thread count
+	int threadCount = m_scene->getThreadCount();
+	if (ImGui::SliderInt("Threads", &threadCount, 1, 8))
+	{
+		m_scene->setThreadCount(threadCount);
+	}
+	bool deterministic = m_scene->getDeterministic();
+	if (ImGui::Checkbox("Deterministic", &deterministic))
+	{
+		m_scene->setDeterministic(deterministic);
+	}
+	if (deterministic)
+	{
+		ImGui::Text("State hash: %016llx", (unsigned long long)m_scene->getStateHash());
+	}
+
+	// What scheduling the step's task graph cost, per fixed step
+	const SchedulerStats & scheduler = m_scene->getSchedulerStats();
+	if (steps > 0)
+	{
+		ImGui::Text("Tasks: %d, chunks: %d, steals: %d per step", scheduler.taskCount / steps, scheduler.chunkCount / steps, scheduler.stealCount / steps);
+		ImGui::Text("Scheduler overhead: %.4f ms per step", scheduler.getOverheadTime() / steps);
+	}
+
+	// Let the scene choose its own time steps from the springs and the fastest objects
+	bool autoTimeStep = m_scene->getAutoTimeStep();
+	if (ImGui::Checkbox("Auto time step", &autoTimeStep))
+	{
+		m_scene->setAutoTimeStep(autoTimeStep);
+	}
+	TimeStepAnalysis analysis = m_scene->analyseTimeStep();
+	ImGui::Text("Fixed step: %.1f Hz, spring step: %.1f Hz", 1.0f / m_scene->getFixedTimeStep(), 1.0f / m_scene->getSpringTimeStep());
+	ImGui::Text("Stable spring step: %.4f s, rigid step: %.4f s", analysis.springTimeStep, analysis.rigidTimeStep);
+
+	// How many objects are simulated at each level of detail and what that saved
+	const LODStats & lodStats = m_scene->getLODStats();
+	ImGui::Text("LOD objects: %d / %d / %d", lodStats.objectCount[0], lodStats.objectCount[1], lodStats.objectCount[2]);
+	ImGui::Text("LOD skipped steps: %d (%.4f ms saved)", lodStats.skippedSteps, lodStats.timeSaved);
+
+	// Long range attachments and how stretched the springs are
+	bool longRangeAttachments = m_scene->getLongRangeAttachments();
+	if (ImGui::Checkbox("Long range attachments", &longRangeAttachments))
+	{
+		m_scene->setLongRangeAttachments(longRangeAttachments);
+	}
+	ImGui::Text("Tethers: %d", m_scene->getTetherCount());
+	ImGui::Text("Spring stretch: %.2f%% average, %.2f%% max", m_scene->getAverageSpringStretch() * 100.0f, m_scene->getMaxSpringStretch() * 100.0f);
+	if (steps > 0)
+	{
+		ImGui::Text("Per step: %.4f ms, %d body bytes", m_scene->getLastUpdateTime() / steps, (int)m_scene->getBodyBytesPerStep());
+	}
+
+	// Energy drift since the scene was created
+	float energy = m_scene->getTotalEnergy();
+	ImGui::Text("Energy: %.2f (drift %.2f)", energy, energy - m_startEnergy);
+
+	ImGui::End();
+}
+
+void PhysicsEngineApp::drawMemoryWindow()
+{
+	ImGui::Begin("Memory");
+
+	// The scene's report with the gizmos added to its gizmo buffers, peaks are since the scene was created. The scene
+	// can't be read while the simulation thread steps it, so only the gizmos are reported then
+	MemoryReport report;
+	if (m_simulationThread == nullptr)
+	{
+		report = m_scene->getMemoryReport();
+	}
+	report.setLiveBytes(MemoryCategory::RENDERING, report.getUsage(MemoryCategory::RENDERING).liveBytes + Gizmos::getCapacityBytes());
+
+	bool tracked = AllocationTracker::isEnabled();
+	ImGui::Columns(tracked ? 6 : 3, "MemoryColumns");
+	ImGui::Text("Category"); ImGui::NextColumn();
+	ImGui::Text("Live KB"); ImGui::NextColumn();
+	ImGui::Text("Peak KB"); ImGui::NextColumn();
+	if (tracked)
+	{
+		ImGui::Text("Heap live KB"); ImGui::NextColumn();
+		ImGui::Text("Heap peak KB"); ImGui::NextColumn();
+		ImGui::Text("Allocations"); ImGui::NextColumn();
+	}
+	ImGui::Separator();
+	for (int i = 0; i < (int)MemoryCategory::COUNT; i++)
+	{
+		MemoryCategory category = (MemoryCategory)i;
+		const MemoryUsage & usage = report.getUsage(category);
+		ImGui::Text("%s", getMemoryCategoryName(category)); ImGui::NextColumn();
+		ImGui::Text("%.1f", usage.liveBytes / 1024.0f); ImGui::NextColumn();
+		ImGui::Text("%.1f", usage.peakBytes / 1024.0f); ImGui::NextColumn();
+		if (tracked)
 		{
-			m_scene->removeObject(m_sphere);
-			delete m_sphere;
-			m_sphere = nullptr;
+			MemoryUsage heap = AllocationTracker::getUsage(category);
+			ImGui::Text("%.1f", heap.liveBytes / 1024.0f); ImGui::NextColumn();
+			ImGui::Text("%.1f", heap.peakBytes / 1024.0f); ImGui::NextColumn();
+			ImGui::Text("%llu", (unsigned long long)heap.allocationCount); ImGui::NextColumn();
 		}
-		
 	}
-	// Apply global for and update scene
-	m_scene->applyGlobalForce();
-	m_scene->update(deltaTime);
+	ImGui::Columns(1);
+	ImGui::Separator();
+
+	ImGui::Text("Total: %.1f KB live, %.1f KB peak", report.getTotalLiveBytes() / 1024.0f, report.getTotalPeakBytes() / 1024.0f);
+	ImGui::Text("Gizmo GPU buffers: %.1f KB", Gizmos::getCapacityBytes() / 1024.0f);
+	if (!tracked)
+	{
+		ImGui::Text("Define PHYSICS_TRACK_ALLOCATIONS for heap figures");
+	}
+
+	ImGui::End();
+}
+
+void PhysicsEngineApp::drawFrameTimeline()
+{
+	ImGui::Begin("Frame Timeline");
+
+	// Milliseconds from the start of the last frame
+	const FrameTimes & frame = m_lastFrameTimes;
+	auto since = [&frame](FrameTimes::TimePoint time) { return std::chrono::duration<float, std::milli>(time - frame.start).count(); };
+	float drawStart = since(frame.draw);
+	float uploadStart = since(frame.upload);
+	float presentStart = since(frame.present);
+	float frameEnd = since(frame.end);
+	ImGui::Text("Frame: %.3f ms", frameEnd);
+	ImGui::Text("Update %.3f ms, gizmos %.3f ms, upload %.3f ms, ImGui and swap %.3f ms", drawStart, uploadStart - drawStart, presentStart - uploadStart, frameEnd - presentStart);
+
+	// The part of the step that ran once update had returned, alongside drawing, uploading and presenting
+	float stepStart = since(frame.stepStart);
+	float stepEnd = since(frame.stepEnd);
+	if (frame.stepped)
+	{
+		float overlap = glm::max(0.0f, glm::min(stepEnd, frameEnd) - glm::max(stepStart, drawStart));
+		ImGui::Text("Step: %.3f ms, %.3f ms of it alongside drawing, next frame waited %.3f ms", stepEnd - stepStart, overlap, frame.waitTime);
+	}
+	else
+	{
+		ImGui::Text("Step: on the simulation thread");
+	}
+
+	// The main thread's parts and the step as bars on the same scale, a pipelined step overlaps the draw and may run
+	// past the end of the frame
+	const ImVec4 colors[] = { ImVec4(0.4f, 0.4f, 0.9f, 1.0f), ImVec4(0.3f, 0.8f, 0.3f, 1.0f), ImVec4(0.9f, 0.7f, 0.2f, 1.0f), ImVec4(0.6f, 0.6f, 0.6f, 1.0f), ImVec4(0.9f, 0.3f, 0.3f, 1.0f) };
+	const float rowHeight = 14.0f, rowGap = 4.0f;
+	float width = ImGui::GetContentRegionAvailWidth();
+	float scale = width / glm::max(frame.stepped ? glm::max(frameEnd, stepEnd) : frameEnd, 0.001f);
+	ImDrawList * drawList = ImGui::GetWindowDrawList();
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	auto bar = [&](int row, float begin, float end, const ImVec4 & color)
+	{
+		float top = origin.y + row * (rowHeight + rowGap);
+		drawList->AddRectFilled(ImVec2(origin.x + begin * scale, top), ImVec2(origin.x + end * scale, top + rowHeight), ImGui::ColorConvertFloat4ToU32(color));
+	};
+	bar(0, 0.0f, drawStart, colors[0]);
+	bar(0, drawStart, uploadStart, colors[1]);
+	bar(0, uploadStart, presentStart, colors[2]);
+	bar(0, presentStart, frameEnd, colors[3]);
+	if (frame.stepped)
+	{
+		bar(1, stepStart, stepEnd, colors[4]);
+	}
+	ImGui::Dummy(ImVec2(width, 2 * rowHeight + rowGap));
+
+	const char * names[] = { "Update", "Gizmos", "Upload", "ImGui and swap", "Step" };
+	for (int i = 0; i < 5; i++)
+	{
+		if (i > 0) ImGui::SameLine();
+		ImGui::TextColored(colors[i], "%s", names[i]);
+	}
+
+	ImGui::End();
 }
 
 void PhysicsEngineApp::draw() {
+	m_frameTimes.draw = RenderSnapshot::Clock::now();
 
 	// wipe the screen to the background colour
 	clearScreen();
 
-	// Call the scene's draw
-	m_scene->draw();
+	// Call the scene's draw, or draw the latest snapshot when the scene is being stepped on its own thread, or the last
+	// frame's snapshot while the pipeline steps this frame
+	if (m_simulationThread != nullptr)
+	{
+		const RenderSnapshot & snapshot = m_simulationThread->acquireSnapshot();
+		snapshot.draw(snapshot.getAlpha(RenderSnapshot::Clock::now()));
+	}
+	else if (m_framePipeline != nullptr)
+	{
+		// Every pipelined snapshot is drawn a frame after it was taken, so its own alpha already advances evenly
+		const RenderSnapshot & snapshot = m_framePipeline->getSnapshot();
+		snapshot.draw(snapshot.getAlpha());
+	}
+	else
+	{
+		m_scene->draw();
+	}
 
 	// update perspective based on screen size
+	m_frameTimes.upload = RenderSnapshot::Clock::now();
 	Gizmos::draw(m_camera->GetProjectionView());
+	m_frameTimes.present = RenderSnapshot::Clock::now();
 }
 
 ///<summary> 
 /// This function handles the creation of a cloth. The necessary spheres are created according to the amount of rows, columns, and the given radius. 
-/// The spheres are then connected to adjacent spheres. Spheres are then added to the object vector and springs to the springs vector.
+/// The spheres are then connected to adjacent spheres. Both are created in the scene's pools, which adds them to the scene.
 ///</summary>
+///<param name = "scene"> The scene the cloth is created in</param>
 ///<param name = "rows"> The amount of rows in the cloth</param>
 ///<param name = "columns"> The amount of columns in the cloth</param>
 ///<param name = "origin"> The location of the bottom left sphere in the cloth</param>
@@ -171,11 +724,12 @@ void PhysicsEngineApp::draw() {
 ///<param name = "springDiagonal"> The resting length of the diagonals</param>
 ///<param name = "springCoefficient"> The strength of the spring</param>
 ///<param name = "springDamping"> The interal spring friction</param>
-void PhysicsEngineApp::MakeCloth(int rows, int columns, vec3 & origin,float radius, float springLength, float springDiagonal, float springCoefficient, float springDamping)
+template <typename Real>
+void PhysicsEngineApp::MakeCloth(BasicScene<Real> & scene, int rows, int columns, vec3 & origin,float radius, float springLength, float springDiagonal, float springCoefficient, float springDamping)
 {
-	vector<Object *> clothSpheres;	// Holds the spheres
-	vector<Spring *> clothSprings;	// Holds the springs 
-	Sphere * clothSphere;			// Cloth pointer
+	vector<BasicObject<Real> *> clothSpheres;	// Holds the spheres
+	BasicSphere<Real> * clothSphere;			// Cloth pointer
+	BasicSpring<Real> * spring;				// Spring pointer
 
 	// Iterate through rows
 	for (int i = 0; i < rows; i++)
@@ -185,7 +739,7 @@ void PhysicsEngineApp::MakeCloth(int rows, int columns, vec3 & origin,float radi
 		{
 			// Create sphere, offset by the row and columns it is supoosed to be at
 			// The ternary checks if the current sphere is at the top left or top right and makes that static, all others are dynamic
-			clothSphere = new Sphere(vec3(origin.x + (i), origin.y + (j), origin.z), radius, 0.1f, vec4(1.0f, 1.0f, 1.0f, 1.0f), ((i == 0 || i == rows - 1) && j == columns - 1) ? true : false);
+			clothSphere = scene.createSphere(vec3(origin.x + (i), origin.y + (j), origin.z), radius, 0.1f, vec4(1.0f, 1.0f, 1.0f, 1.0f), ((i == 0 || i == rows - 1) && j == columns - 1) ? true : false);
 			clothSpheres.push_back(clothSphere); // Adds to vector
 		}
 	}
@@ -205,8 +759,7 @@ void PhysicsEngineApp::MakeCloth(int rows, int columns, vec3 & origin,float radi
 		if (currentColumn < columns - 1)
 		{
 			// Connect the current sphere to the next one in the row
-			m_spring = new Spring(clothSpheres[i], clothSpheres[i + 1], springLength, springCoefficient, springDamping);
-			clothSprings.push_back(m_spring); // Add to vector
+			spring = scene.createSpring(clothSpheres[i], clothSpheres[i + 1], springLength, springCoefficient, springDamping);
 		}
 
 		// If we haven't reached the last row, since we can't connect to a row that isn't there
@@ -216,33 +769,21 @@ void PhysicsEngineApp::MakeCloth(int rows, int columns, vec3 & origin,float radi
 			if (currentColumn > 0)
 			{
 				// Connects the current sphere to the one diagonal left
-				m_spring = new Spring(clothSpheres[i], clothSpheres[i + columns - 1], springDiagonal, springCoefficient, springDamping);
-				clothSprings.push_back(m_spring);
+				spring = scene.createSpring(clothSpheres[i], clothSpheres[i + columns - 1], springDiagonal, springCoefficient, springDamping);
+				spring->setIsDetail(true);	// Shear springs can be left out of far away cloth
 			}
 
 			// If the current column isn't at the right edge
 			if (currentColumn < columns - 1)
 			{
 				// Connects the current sphere to the one diagonal right
-				m_spring = new Spring(clothSpheres[i], clothSpheres[i + columns + 1], springDiagonal, springCoefficient, springDamping);
-				clothSprings.push_back(m_spring);
+				spring = scene.createSpring(clothSpheres[i], clothSpheres[i + columns + 1], springDiagonal, springCoefficient, springDamping);
+				spring->setIsDetail(true);	// Shear springs can be left out of far away cloth
 			}
 
 			// Connects the current sphere to the one directly above
-			m_spring = new Spring(clothSpheres[i], clothSpheres[i + columns], springLength, springCoefficient, springDamping);
-			clothSprings.push_back(m_spring);
+			spring = scene.createSpring(clothSpheres[i], clothSpheres[i + columns], springLength, springCoefficient, springDamping);
 		}
 		currentColumn++; // Increment current column
 	}
-
-	// Add springs and spheres to their respective vectors 
-	for (auto sphere : clothSpheres)
-	{
-		m_scene->addObject(sphere);
-	}
-
-	for (auto springs : clothSprings)
-	{
-		m_scene->addSpring(springs);
-	}
 }
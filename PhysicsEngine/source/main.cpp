@@ -1,7 +1,82 @@
 #include "PhysicsEngineApp.h"
+#include "BodyStoreBenchmark.h"
+#include "Physics/ClothEnsemble.h"
+#include "Physics/SpringKernel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+int main(int argc, char ** argv) {
+
+	// --allocation-check runs the allocation check instead of the app, the exit code is 0 if it passed
+	if (argc > 1 && strcmp(argv[1], "--allocation-check") == 0)
+	{
+		auto app = new PhysicsEngineApp();
+		bool passed = app->runAllocationCheck();
+		delete app;
+		return passed ? 0 : 1;
+	}
+
+	// --spring-kernel-benchmark times the spring force kernel against the scalar loop on cloths of a few sizes
+	if (argc > 1 && strcmp(argv[1], "--spring-kernel-benchmark") == 0)
+	{
+		bool matched = true;
+		for (int size : { 32, 128, 512 })
+		{
+			Physics::SpringKernelBenchmark result = Physics::benchmarkSpringKernel(size, size, 200);
+			printf("%d springs: scalar %.4f ms, kernel %.4f ms (%s), forces %s\n", result.springCount, result.scalarTime, result.kernelTime,
+				result.vectorized ? "SSE" : "scalar", result.matches ? "match" : "differ");
+			matched = matched && result.matches;
+		}
+		return matched ? 0 : 1;
+	}
+
+	// --precision-benchmark [updates] steps the same scene as a Scene and as a DoubleScene and prints the time of each
+	if (argc > 1 && strcmp(argv[1], "--precision-benchmark") == 0)
+	{
+		int steps = argc > 2 ? atoi(argv[2]) : 300;
+		return PhysicsEngineApp::runPrecisionBenchmark(steps) ? 0 : 1;
+	}
+
+	// --body-store-benchmark compares the bytes a step touches and its time with bodies laid out as objects and in a body store
+	if (argc > 1 && strcmp(argv[1], "--body-store-benchmark") == 0)
+	{
+		bool matched = true;
+		for (int bodyCount : { 1000, 10000, 100000 })
+		{
+			BodyStoreBenchmark result = benchmarkBodyStore(bodyCount, 200);
+			printf("%d bodies: objects %d bytes %.4f ms, store %d bytes %.4f ms, states %s\n", result.bodyCount, (int)result.objectBytes, result.objectTime,
+				(int)result.storeBytes, result.storeTime, result.matches ? "match" : "differ");
+			matched = matched && result.matches;
+		}
+		return matched ? 0 : 1;
+	}
+
+	// --cloth-ensemble-benchmark times a cloth ensemble against as many separate cloths for a few instance counts
+	if (argc > 1 && strcmp(argv[1], "--cloth-ensemble-benchmark") == 0)
+	{
+		bool matched = true;
+		for (int instanceCount : { 8, 32, 128 })
+		{
+			Physics::ClothEnsembleBenchmark result = Physics::benchmarkClothEnsemble(instanceCount, 20, 20, 200);
+			printf("%d cloths: separate %.4f ms, ensemble %.4f ms (%d wide), states %s\n", result.instanceCount, result.clothTime, result.ensembleTime,
+				result.simdWidth, result.matches ? "match" : "differ");
+			matched = matched && result.matches;
+		}
+		return matched ? 0 : 1;
+	}
+
+	// --ensemble [instances] [steps] [threads] steps a parameter sweep of the default scene and prints the metrics
+	if (argc > 1 && strcmp(argv[1], "--ensemble") == 0)
+	{
+		int instanceCount = argc > 2 ? atoi(argv[2]) : 27;
+		int steps = argc > 3 ? atoi(argv[3]) : 600;
+		int threadCount = argc > 4 ? atoi(argv[4]) : (int)std::max(1u, std::thread::hardware_concurrency());
+		return PhysicsEngineApp::runEnsemble(instanceCount, steps, threadCount) ? 0 : 1;
+	}
 
-int main() {
-	
 	// allocation
 	auto app = new PhysicsEngineApp();
 
@@ -2,11 +2,13 @@
 #include "gl_core_4_4.h"
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <algorithm>
 #include <iostream>
 
 namespace aie {
 
 Gizmos* Gizmos::sm_singleton = nullptr;
+thread_local GizmoBuffer* Gizmos::sm_boundBuffer = nullptr;
 
 Gizmos::Gizmos(unsigned int maxLines, unsigned int maxTris,
 			   unsigned int max2DLines, unsigned int max2DTris)
@@ -710,95 +712,122 @@ void Gizmos::addLine(const glm::vec3& v0,  const glm::vec3& v1, const glm::vec4&
 
 void Gizmos::addLine(const glm::vec3& v0, const glm::vec3& v1, const glm::vec4& colour0, const glm::vec4& colour1) {
 
-	if (sm_singleton != nullptr &&
-		sm_singleton->m_lineCount < sm_singleton->m_maxLines) {
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.x = v0.x;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.y = v0.y;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.z = v0.z;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.w = 1;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.r = colour0.r;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.g = colour0.g;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.b = colour0.b;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.a = colour0.a;
-
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.x = v1.x;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.y = v1.y;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.z = v1.z;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.w = 1;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.r = colour1.r;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.g = colour1.g;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.b = colour1.b;
-		sm_singleton->m_lines[sm_singleton->m_lineCount].v1.a = colour1.a;
-
-		sm_singleton->m_lineCount++;
-	}
+	if (sm_singleton == nullptr)
+		return;
+
+	GizmoLine line;
+	line.v0.x = v0.x;
+	line.v0.y = v0.y;
+	line.v0.z = v0.z;
+	line.v0.w = 1;
+	line.v0.r = colour0.r;
+	line.v0.g = colour0.g;
+	line.v0.b = colour0.b;
+	line.v0.a = colour0.a;
+
+	line.v1.x = v1.x;
+	line.v1.y = v1.y;
+	line.v1.z = v1.z;
+	line.v1.w = 1;
+	line.v1.r = colour1.r;
+	line.v1.g = colour1.g;
+	line.v1.b = colour1.b;
+	line.v1.a = colour1.a;
+
+	// a thread with a buffer bound adds to its buffer
+	if (sm_boundBuffer != nullptr)
+		sm_boundBuffer->m_lines.push_back(line);
+	else if (sm_singleton->m_lineCount < sm_singleton->m_maxLines)
+		sm_singleton->m_lines[sm_singleton->m_lineCount++] = line;
 }
 
 void Gizmos::addTri(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec4& colour) {
+
+	if (sm_singleton == nullptr)
+		return;
+
+	GizmoTri tri;
+	tri.v0.x = v0.x;
+	tri.v0.y = v0.y;
+	tri.v0.z = v0.z;
+	tri.v0.w = 1;
+	tri.v1.x = v1.x;
+	tri.v1.y = v1.y;
+	tri.v1.z = v1.z;
+	tri.v1.w = 1;
+	tri.v2.x = v2.x;
+	tri.v2.y = v2.y;
+	tri.v2.z = v2.z;
+	tri.v2.w = 1;
+
+	tri.v0.r = colour.r;
+	tri.v0.g = colour.g;
+	tri.v0.b = colour.b;
+	tri.v0.a = colour.a;
+	tri.v1.r = colour.r;
+	tri.v1.g = colour.g;
+	tri.v1.b = colour.b;
+	tri.v1.a = colour.a;
+	tri.v2.r = colour.r;
+	tri.v2.g = colour.g;
+	tri.v2.b = colour.b;
+	tri.v2.a = colour.a;
+
+	// a thread with a buffer bound adds to its buffer
+	if (colour.w == 1) {
+		if (sm_boundBuffer != nullptr)
+			sm_boundBuffer->m_tris.push_back(tri);
+		else if (sm_singleton->m_triCount < sm_singleton->m_maxTris)
+			sm_singleton->m_tris[sm_singleton->m_triCount++] = tri;
+	}
+	else {
+		if (sm_boundBuffer != nullptr)
+			sm_boundBuffer->m_transparentTris.push_back(tri);
+		else if (sm_singleton->m_transparentTriCount < sm_singleton->m_maxTris)
+			sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount++] = tri;
+	}
+}
+
+void Gizmos::bindBuffer(GizmoBuffer* buffer) {
+	sm_boundBuffer = buffer;
+}
+
+void Gizmos::mergeBuffer(GizmoBuffer& buffer) {
+
 	if (sm_singleton != nullptr) {
-		if (colour.w == 1) {
-			if (sm_singleton->m_triCount < sm_singleton->m_maxTris) {
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.x = v0.x;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.y = v0.y;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.z = v0.z;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.w = 1;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.x = v1.x;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.y = v1.y;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.z = v1.z;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.w = 1;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.x = v2.x;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.y = v2.y;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.z = v2.z;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.w = 1;
-
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.r = colour.r;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.g = colour.g;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.b = colour.b;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v0.a = colour.a;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.r = colour.r;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.g = colour.g;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.b = colour.b;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v1.a = colour.a;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.r = colour.r;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.g = colour.g;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.b = colour.b;
-				sm_singleton->m_tris[sm_singleton->m_triCount].v2.a = colour.a;
-
-				sm_singleton->m_triCount++;
-			}
-		}
-		else {
-			if (sm_singleton->m_transparentTriCount < sm_singleton->m_maxTris) {
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.x = v0.x;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.y = v0.y;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.z = v0.z;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.w = 1;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.x = v1.x;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.y = v1.y;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.z = v1.z;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.w = 1;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.x = v2.x;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.y = v2.y;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.z = v2.z;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.w = 1;
-
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.r = colour.r;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.g = colour.g;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.b = colour.b;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.a = colour.a;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.r = colour.r;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.g = colour.g;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.b = colour.b;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v1.a = colour.a;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.r = colour.r;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.g = colour.g;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.b = colour.b;
-				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v2.a = colour.a;
-
-				sm_singleton->m_transparentTriCount++;
-			}
-		}
+		// whatever doesn't fit is dropped, the same as adding past the maximum
+		unsigned int lines = std::min((unsigned int)buffer.m_lines.size(), sm_singleton->m_maxLines - sm_singleton->m_lineCount);
+		std::copy(buffer.m_lines.begin(), buffer.m_lines.begin() + lines, sm_singleton->m_lines + sm_singleton->m_lineCount);
+		sm_singleton->m_lineCount += lines;
+
+		unsigned int tris = std::min((unsigned int)buffer.m_tris.size(), sm_singleton->m_maxTris - sm_singleton->m_triCount);
+		std::copy(buffer.m_tris.begin(), buffer.m_tris.begin() + tris, sm_singleton->m_tris + sm_singleton->m_triCount);
+		sm_singleton->m_triCount += tris;
+
+		unsigned int transparentTris = std::min((unsigned int)buffer.m_transparentTris.size(), sm_singleton->m_maxTris - sm_singleton->m_transparentTriCount);
+		std::copy(buffer.m_transparentTris.begin(), buffer.m_transparentTris.begin() + transparentTris, sm_singleton->m_transparentTris + sm_singleton->m_transparentTriCount);
+		sm_singleton->m_transparentTriCount += transparentTris;
 	}
+
+	buffer.clear();
+}
+
+void GizmoBuffer::clear() {
+	m_lines.clear();
+	m_tris.clear();
+	m_transparentTris.clear();
+}
+
+size_t Gizmos::getCapacityBytes() {
+	if (sm_singleton == nullptr)
+		return 0;
+	return (sm_singleton->m_maxLines + sm_singleton->m_max2DLines) * sizeof(GizmoLine) +
+		(2 * sm_singleton->m_maxTris + sm_singleton->m_max2DTris) * sizeof(GizmoTri);
+}
+
+size_t GizmoBuffer::getCapacityBytes() const {
+	return m_lines.capacity() * sizeof(Gizmos::GizmoLine) +
+		(m_tris.capacity() + m_transparentTris.capacity()) * sizeof(Gizmos::GizmoTri);
 }
 
 void Gizmos::add2DAABB(const glm::vec2& center, const glm::vec2& extents, const glm::vec4& colour, const glm::mat4* transform /*= nullptr*/) {	
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <glm/fwd.hpp>
+#include <vector>
 
 namespace aie {
 
+class GizmoBuffer;
+
 // a singleton class for rendering immediate-mode 3-D primitives
 class Gizmos {
 public:
@@ -89,9 +92,25 @@ public:
 	static void		add2DAABB(const glm::vec2& center, const glm::vec2& extents, const glm::vec4& colour, const glm::mat4* transform = nullptr);	
 	static void		add2DAABBFilled(const glm::vec2& center, const glm::vec2& extents, const glm::vec4& colour, const glm::mat4* transform = nullptr);	
 	static void		add2DCircle(const glm::vec2& center, float radius, unsigned int segments, const glm::vec4& colour, const glm::mat4* transform = nullptr);
+
+	// binds a buffer to the calling thread, or unbinds it with nullptr. while a buffer is bound every 3-D line and
+	// triangle added on that thread goes into the buffer rather than the shared Gizmos, so several threads can add
+	// 3-D gizmos at once as long as each has its own buffer. 2-D gizmos always go to the shared Gizmos
+	static void		bindBuffer(GizmoBuffer* buffer);
+
+	// appends a buffer's lines and triangles to the shared Gizmos and empties it. only one thread may add to the
+	// shared Gizmos at a time, so buffers are merged on the drawing thread once the threads filling them are done.
+	// merging the same buffers in the same order gives the same draw order as adding everything on one thread
+	static void		mergeBuffer(GizmoBuffer& buffer);
+
+	// bytes of the vertex arrays the primitives are built in, from the capacities the Gizmos were created with.
+	// the GPU buffers they are uploaded to are the same size again
+	static size_t	getCapacityBytes();
 	
 private:
 
+	friend class GizmoBuffer;
+
 	Gizmos(unsigned int maxLines, unsigned int maxTris,
 		   unsigned int max2DLines, unsigned int max2DTris);
 	~Gizmos();
@@ -153,6 +172,32 @@ private:
 	unsigned int 	m_2DtriVBO;
 
 	static Gizmos*	sm_singleton;
+
+	// the buffer bound to each thread, if any
+	static thread_local GizmoBuffer*	sm_boundBuffer;
+};
+
+// 3-D lines and triangles added on one thread while it is bound, see Gizmos::bindBuffer.
+// it grows to hold whatever is added and keeps its memory when emptied, so it can be reused every frame
+class GizmoBuffer {
+public:
+
+	// removes everything added since the buffer was last merged
+	void			clear();
+
+	unsigned int	getLineCount() const	{ return (unsigned int)m_lines.size(); }
+	unsigned int	getTriCount() const		{ return (unsigned int)(m_tris.size() + m_transparentTris.size()); }
+
+	// bytes the buffer holds on to
+	size_t			getCapacityBytes() const;
+
+private:
+
+	friend class Gizmos;
+
+	std::vector<Gizmos::GizmoLine>	m_lines;
+	std::vector<Gizmos::GizmoTri>	m_tris;
+	std::vector<Gizmos::GizmoTri>	m_transparentTris;
 };
 
 } // namespace aie
\ No newline at end of file